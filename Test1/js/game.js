@@ -3,6 +3,7 @@
 
 const CAMERA_DISTANCE = 4;
 const CAMERA_HEIGHT = 1.5;
+const CAMERA_COLLISION_MARGIN = 0.2; // keep the camera this far in front of whatever blocks it
 const RUN_CYCLE_DURATION = 0.4;
 const PROJECTILE_RADIUS = 0.15;
 
@@ -19,6 +20,55 @@ let game_update, game_get_player_position, game_get_player_rotation, game_get_fr
 let game_get_projectile_count, game_get_projectile;
 let game_get_is_moving, game_get_is_in_air, game_get_run_time;
 let game_get_obstacle_count, getObstacleX, getObstacleY, getObstacleZ, getObstacleRotation, getObstacleColor, getObstacleType;
+// Typed-array views over WASM-side buffers (null when the WASM build predates game_get_buffer)
+let wasmBuffers = null;
+// Rebuilds the obstacle meshes from WASM state; rerun whenever GAME_FRAME_WORLD_VERSION changes
+let refreshObstacles = null;
+let worldVersion = -1;
+// Set when the page was opened with ?record and the build has the input recorder: F8 downloads the log
+let saveRecording = null;
+// Set when the page was opened with ?stats and the build has GAME_STATS: logs the slowest update each second
+let logStats = null;
+
+// Buffer ids and frame block offsets (match wasm/game.h)
+const GAME_BUFFER_OBSTACLE_POSITIONS = 0;
+const GAME_BUFFER_OBSTACLE_ROTATIONS = 1;
+const GAME_BUFFER_OBSTACLE_COLORS = 2;
+const GAME_BUFFER_OBSTACLE_TYPES = 3;
+const GAME_BUFFER_PROJECTILE_POSITIONS = 4;
+const GAME_BUFFER_FRAME = 6;
+const GAME_BUFFER_OBSTACLE_ROTATION_SPEEDS = 7;
+const GAME_BUFFER_PROJECTILE_PREV_POSITIONS = 8;
+const GAME_BUFFER_RAYS = 9;
+const GAME_BUFFER_RAY_HITS = 10;
+const GAME_BUFFER_CULL_PARAMS = 11;
+const GAME_BUFFER_VISIBLE_INDICES = 12;
+const GAME_BUFFER_VISIBLE_MATRICES = 13;
+const GAME_BUFFER_VISIBLE_LISTS = 14;
+const GAME_BUFFER_RECORD = 15;
+const GAME_LOD_LEVELS = 3;
+const GAME_CULL_EYE_X = 24;
+const GAME_CULL_MAX_DIST = 27;
+const GAME_CULL_LOD_DIST = 28;
+const GAME_RAY_MISS = -1;
+const GAME_FRAME_PLAYER_X = 0;
+const GAME_FRAME_YAW = 3;
+const GAME_FRAME_FRONT_X = 5;
+const GAME_FRAME_IS_MOVING = 8;
+const GAME_FRAME_IS_IN_AIR = 9;
+const GAME_FRAME_RUN_TIME = 10;
+const GAME_FRAME_PROJECTILE_COUNT = 11;
+const GAME_FRAME_PREV_PLAYER_X = 12;
+const GAME_FRAME_ALPHA = 15;
+const GAME_FRAME_WORLD_VERSION = 17;
+// GameStats fields in struct order (all uint32)
+const GAME_STATS_FIELD_NAMES = [
+  'updates', 'ticks', 'update_ns', 'move_ns', 'vertical_ns', 'world_ns', 'projectile_ns', 'projectile_pair_ns',
+  'rotation_ns', 'obstacle_queries', 'obstacle_hits', 'pair_tests', 'pair_hits', 'spawns', 'removals', 'projectiles'
+];
+// Simulation tick rate when the WASM build supports fixed-step mode (rendering interpolates between ticks)
+const SIM_TICK_RATE = 60;
+const SIM_MAX_CATCHUP_STEPS = 5;
 
 // Scene
 const scene = new THREE.Scene();
@@ -32,15 +82,15 @@ renderer.setPixelRatio(Math.min(window.devicePixelRatio, 2));
 renderer.shadowMap.enabled = true;
 renderer.shadowMap.type = THREE.PCFSoftShadowMap;
 
-// Terrain: hilly floor (500x500) with procedural height
-function makeTerrainGeometry(width, depth, segsW, segsD) {
+// Terrain: hilly floor (500x500) with procedural height, for a mesh placed at world (centerX, 0, centerZ)
+function makeTerrainGeometry(width, depth, segsW, segsD, centerX = 0, centerZ = 0) {
   const geom = new THREE.PlaneGeometry(width, depth, segsW, segsD);
   const pos = geom.attributes.position;
   const scale = 0.04;
   const amp = 6;
   for (let i = 0; i < pos.count; i++) {
-    const x = pos.getX(i);
-    const y = pos.getY(i);
+    const x = pos.getX(i) + centerX;
+    const y = pos.getY(i) - centerZ; // plane Y = -world Z
     const h =
       amp * (0.5 * Math.sin(x * scale) * Math.cos(y * scale * 0.8) +
              0.4 * Math.sin(x * scale * 1.3 + 1) * Math.cos(y * scale * 1.1 + 0.5) +
@@ -57,73 +107,120 @@ const floor = new THREE.Mesh(floorGeom, floorMat);
 floor.position.set(0, 0, 0);
 floor.receiveShadow = true;
 scene.add(floor);
+// Streamed (unbounded) worlds: the floor mesh and shadow frustum re-center on the player in texture-tile steps
+const FLOOR_RECENTER_DISTANCE = 100;
+const FLOOR_RECENTER_SNAP = 100;
+let floorFollowsPlayer = false;
 
-const floorTextureUrl = new URL('Assets/Textures/BricksWall.png', document.baseURI || window.location.href).href;
-new THREE.TextureLoader().load(
-  floorTextureUrl,
-  (tex) => {
-    console.log('Loaded floor texture:', floorTextureUrl, tex.image?.width, 'x', tex.image?.height);
-    // Ensure correct color and filtering for JPG textures
-    tex.colorSpace = THREE.SRGBColorSpace;
-    tex.wrapS = tex.wrapT = THREE.RepeatWrapping;
-    // Tile the texture across the whole 500x500 floor
-    tex.repeat.set(50, 50);
-    tex.anisotropy = renderer.capabilities.getMaxAnisotropy?.() ?? 1;
-    floorMat.map = tex;
-    floorMat.color.setHex(0xffffff);
-    // Needed when adding a map to a material that previously had none
-    floorMat.needsUpdate = true;
-  },
-  undefined,
-  (err) => { console.error('Floor texture failed to load:', floorTextureUrl, err); }
-);
+// Scene textures ship as PNGs plus GPU-compressed KTX2 copies written by `make textures` (shared/texpack.c):
+// BC1 for desktop GPUs, ETC2 for mobile ones. The KTX2 files carry their whole mip chain and upload without a
+// decode; without a matching extension, or when the file is missing, the PNG is used instead.
+const KTX2_VARIANT = (() => {
+  const ext = renderer.extensions;
+  if (ext.has('WEBGL_compressed_texture_s3tc') && ext.has('WEBGL_compressed_texture_s3tc_srgb')) {
+    return { suffix: 'bc1', vkFormat: 132, format: THREE.RGB_S3TC_DXT1_Format };
+  }
+  if (ext.has('WEBGL_compressed_texture_etc')) return { suffix: 'etc2', vkFormat: 148, format: THREE.RGB_ETC2_Format };
+  return null;
+})();
 
-// Grass texture for cube obstacles
-const grassTextureUrl = new URL('Assets/Textures/GrassTile.png', document.baseURI || window.location.href).href;
-new THREE.TextureLoader().load(
-  grassTextureUrl,
-  (tex) => {
+// Minimal KTX2 reader for texpack's output: one 2D image without supercompression, levels from the level index
+function parseKtx2(buffer, variant) {
+  const dv = new DataView(buffer);
+  const identifier = [0xab, 0x4b, 0x54, 0x58, 0x20, 0x32, 0x30, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a];
+  if (buffer.byteLength < 80 || identifier.some((b, i) => dv.getUint8(i) !== b)) throw new Error('not a KTX2 file');
+  const vkFormat = dv.getUint32(12, true);
+  if (vkFormat !== variant.vkFormat || dv.getUint32(44, true) !== 0) throw new Error('unexpected vkFormat ' + vkFormat);
+  const width = dv.getUint32(20, true);
+  const height = dv.getUint32(24, true);
+  const levelCount = Math.max(1, dv.getUint32(40, true));
+  const mipmaps = [];
+  for (let i = 0; i < levelCount; i++) {
+    const offset = Number(dv.getBigUint64(80 + 24 * i, true));
+    const length = Number(dv.getBigUint64(88 + 24 * i, true));
+    mipmaps.push({ data: new Uint8Array(buffer, offset, length), width: Math.max(1, width >> i), height: Math.max(1, height >> i) });
+  }
+  const tex = new THREE.CompressedTexture(mipmaps, width, height, variant.format, THREE.UnsignedByteType);
+  tex.minFilter = levelCount > 1 ? THREE.LinearMipmapLinearFilter : THREE.LinearFilter;
+  tex.magFilter = THREE.LinearFilter;
+  tex.needsUpdate = true;
+  return tex;
+}
+
+// Loads Assets/Textures/<name> as a tiling sRGB texture repeated (repeatX, repeatY) times per UV unit
+function loadTiledTexture(name, repeatX, repeatY, onLoad) {
+  const base = document.baseURI || window.location.href;
+  const pngUrl = new URL(`Assets/Textures/${name}.png`, base).href;
+  const finish = (tex, url) => {
+    console.log('Loaded texture:', url, tex.image?.width, 'x', tex.image?.height);
     tex.colorSpace = THREE.SRGBColorSpace;
     tex.wrapS = tex.wrapT = THREE.RepeatWrapping;
-    tex.repeat.set(2, 2);
+    // Compressed images are not flipped on upload; a negative repeat samples them the way the PNG is sampled
+    tex.repeat.set(repeatX, tex.flipY ? repeatY : -repeatY);
     tex.anisotropy = renderer.capabilities.getMaxAnisotropy?.() ?? 1;
-    obstacleCubeMat.map = tex;
-    obstacleCubeMat.color.setHex(0xffffff);
-    obstacleCubeMat.needsUpdate = true;
-    // Ensure cube instances use white so the texture shows (no tint)
-    if (obstacleCubes && obstacleCubeIndices.length > 0) {
-      const white = new THREE.Color(0xffffff);
-      for (let k = 0; k < obstacleCubeIndices.length; k++) {
-        obstacleCubes.setColorAt(k, white);
+    onLoad(tex);
+  };
+  const loadPng = () => new THREE.TextureLoader().load(
+    pngUrl,
+    (tex) => finish(tex, pngUrl),
+    undefined,
+    (err) => { console.error('Texture failed to load:', pngUrl, err); }
+  );
+  if (!KTX2_VARIANT) {
+    loadPng();
+    return;
+  }
+  const ktx2Url = new URL(`Assets/Textures/${name}.${KTX2_VARIANT.suffix}.ktx2`, base).href;
+  fetch(ktx2Url)
+    .then((res) => {
+      if (!res.ok) throw new Error('HTTP ' + res.status);
+      return res.arrayBuffer();
+    })
+    .then((buffer) => parseKtx2(buffer, KTX2_VARIANT))
+    .then(
+      (tex) => finish(tex, ktx2Url),
+      (err) => {
+        console.warn('KTX2 texture unavailable, using the PNG:', ktx2Url, err.message || err);
+        loadPng();
       }
-      if (obstacleCubes.instanceColor) obstacleCubes.instanceColor.needsUpdate = true;
+    );
+}
+
+// Tile the floor texture across the whole 500x500 floor
+loadTiledTexture('BricksWall', 50, 50, (tex) => {
+  floorMat.map = tex;
+  floorMat.color.setHex(0xffffff);
+  // Needed when adding a map to a material that previously had none
+  floorMat.needsUpdate = true;
+});
+
+// Grass texture for cube obstacles
+loadTiledTexture('GrassTile', 2, 2, (tex) => {
+  obstacleCubeMat.map = tex;
+  obstacleCubeMat.color.setHex(0xffffff);
+  obstacleCubeMat.needsUpdate = true;
+  // Ensure cube instances use white so the texture shows (no tint)
+  if (obstacleCubes && obstacleCubeIndices.length > 0) {
+    const white = new THREE.Color(0xffffff);
+    for (let k = 0; k < obstacleCubeIndices.length; k++) {
+      obstacleCubes.setColorAt(k, white);
     }
-  },
-  undefined,
-  (err) => { console.error('Grass texture failed to load:', grassTextureUrl, err); }
-);
+    if (obstacleCubes.instanceColor) obstacleCubes.instanceColor.needsUpdate = true;
+  }
+});
 
 // Rock tile texture for triangle obstacles
-const rockTileTextureUrl = new URL('Assets/Textures/RockTile.png', document.baseURI || window.location.href).href;
-new THREE.TextureLoader().load(
-  rockTileTextureUrl,
-  (tex) => {
-    tex.colorSpace = THREE.SRGBColorSpace;
-    tex.wrapS = tex.wrapT = THREE.RepeatWrapping;
-    tex.repeat.set(2, 2);
-    tex.anisotropy = renderer.capabilities.getMaxAnisotropy?.() ?? 1;
-    obstacleTriangleMat.map = tex;
-    obstacleTriangleMat.color.setHex(0xffffff);
-    obstacleTriangleMat.needsUpdate = true;
-  },
-  undefined,
-  (err) => { console.error('RockTile texture failed to load:', rockTileTextureUrl, err); }
-);
+loadTiledTexture('RockTile', 2, 2, (tex) => {
+  obstacleTriangleMat.map = tex;
+  obstacleTriangleMat.color.setHex(0xffffff);
+  obstacleTriangleMat.needsUpdate = true;
+});
 
 // Obstacles: cubes (0), spheres (1), triangles (2) - each type has its own InstancedMesh
 const OBSTACLE_TYPE_CUBE = 0;
 const OBSTACLE_TYPE_SPHERE = 1;
 const OBSTACLE_TYPE_TRIANGLE = 2;
+const GAME_OBSTACLE_TYPE_EMPTY = 255; // slot with no resident chunk (streamed worlds)
 
 const obstacleCubeGeom = new THREE.BoxGeometry(1, 1, 1);
 const obstacleSphereGeom = new THREE.SphereGeometry(0.5, 16, 12);
@@ -150,7 +247,7 @@ function ensureObstaclesByType(getObstacleType, count) {
     const t = getObstacleType(i);
     if (t === OBSTACLE_TYPE_CUBE) cubeIndices.push(i);
     else if (t === OBSTACLE_TYPE_SPHERE) sphereIndices.push(i);
-    else triangleIndices.push(i);
+    else if (t !== GAME_OBSTACLE_TYPE_EMPTY) triangleIndices.push(i);
   }
   const nCubes = cubeIndices.length;
   const nSpheres = sphereIndices.length;
@@ -182,6 +279,71 @@ function ensureObstaclesByType(getObstacleType, count) {
   obstacleCount = count;
 }
 
+// Write rotation-Y + translation matrices straight into an InstancedMesh's instanceMatrix array.
+// Rotation is evaluated here as base + speed * t (t from game_get_obstacle_rotation_time).
+function writeObstacleMatrices(mesh, indices, positions, rotations, speeds, t) {
+  if (!mesh || !indices.length) return;
+  const te = mesh.instanceMatrix.array;
+  for (let k = 0; k < indices.length; k++) {
+    const i = indices[k];
+    const rot = rotations[i] + speeds[i] * t;
+    const c = Math.cos(rot);
+    const s = Math.sin(rot);
+    const o = k * 16;
+    te[o] = c;      te[o + 1] = 0;  te[o + 2] = -s;  te[o + 3] = 0;
+    te[o + 4] = 0;  te[o + 5] = 1;  te[o + 6] = 0;   te[o + 7] = 0;
+    te[o + 8] = s;  te[o + 9] = 0;  te[o + 10] = c;  te[o + 11] = 0;
+    te[o + 12] = positions[i * 3];
+    te[o + 13] = positions[i * 3 + 1];
+    te[o + 14] = positions[i * 3 + 2];
+    te[o + 15] = 1;
+  }
+  mesh.instanceMatrix.needsUpdate = true;
+}
+
+// Builds with WASM-side culling: hand the camera frustum to game_cull_obstacles, then copy only the visible
+// instances of each type and shrink the draw count. LOD distances stay 0, so each type is one list.
+const cullFrustum = new THREE.Frustum();
+const cullMatrix = new THREE.Matrix4();
+const cullColor = new THREE.Color();
+function writeCullParams(params) {
+  camera.updateMatrixWorld();
+  cullMatrix.multiplyMatrices(camera.projectionMatrix, camera.matrixWorldInverse);
+  cullFrustum.setFromProjectionMatrix(cullMatrix);
+  for (let p = 0; p < 6; p++) {
+    const plane = cullFrustum.planes[p];
+    params[p * 4] = plane.normal.x;
+    params[p * 4 + 1] = plane.normal.y;
+    params[p * 4 + 2] = plane.normal.z;
+    params[p * 4 + 3] = plane.constant;
+  }
+  params[GAME_CULL_EYE_X] = camera.position.x;
+  params[GAME_CULL_EYE_X + 1] = camera.position.y;
+  params[GAME_CULL_EYE_X + 2] = camera.position.z;
+  params[GAME_CULL_MAX_DIST] = camera.far;
+  for (let l = 0; l < GAME_LOD_LEVELS - 1; l++) params[GAME_CULL_LOD_DIST + l] = 0;
+}
+
+// Copies one type's visible instances (all of its LOD lists, which are adjacent) into the mesh
+function uploadVisibleObstacles(mesh, type, withColors) {
+  if (!mesh) return;
+  const { visibleLists, visibleMatrices, visibleIndices, obstacleColors } = wasmBuffers;
+  const first = type * GAME_LOD_LEVELS;
+  const offset = visibleLists[first * 2];
+  let count = 0;
+  for (let l = 0; l < GAME_LOD_LEVELS; l++) count += visibleLists[(first + l) * 2 + 1];
+  mesh.instanceMatrix.array.set(visibleMatrices.subarray(offset * 16, (offset + count) * 16));
+  mesh.instanceMatrix.needsUpdate = true;
+  if (withColors && count > 0) {
+    const te = mesh.instanceColor.array;
+    for (let k = 0; k < count; k++) {
+      cullColor.setHex(obstacleColors[visibleIndices[offset + k]] & 0xFFFFFF).toArray(te, k * 3);
+    }
+    mesh.instanceColor.needsUpdate = true;
+  }
+  mesh.count = count;
+}
+
 // Character (blocky humanoid)
 const charMat = new THREE.MeshLambertMaterial({ color: 0x5999ff });
 const skinMat = new THREE.MeshLambertMaterial({ color: 0xf2d9c4 });
@@ -236,11 +398,25 @@ dirLight.shadow.camera.top = 280;
 dirLight.shadow.camera.bottom = -280;
 dirLight.shadow.camera.far = 500;
 scene.add(dirLight);
+scene.add(dirLight.target);
+
+function recenterFloor(px, pz) {
+  if (Math.abs(px - floor.position.x) < FLOOR_RECENTER_DISTANCE && Math.abs(pz - floor.position.z) < FLOOR_RECENTER_DISTANCE) return;
+  const cx = Math.round(px / FLOOR_RECENTER_SNAP) * FLOOR_RECENTER_SNAP;
+  const cz = Math.round(pz / FLOOR_RECENTER_SNAP) * FLOOR_RECENTER_SNAP;
+  floor.geometry.dispose();
+  floor.geometry = makeTerrainGeometry(500, 500, 80, 80, cx, cz);
+  floor.position.set(cx, 0, cz);
+  dirLight.position.set(cx + 10, 20, cz + 10);
+  dirLight.target.position.set(cx, 0, cz);
+}
 
 // Projectiles: list of Three.js meshes (count/layout driven by WASM)
 const projectileGeom = new THREE.SphereGeometry(PROJECTILE_RADIUS, 8, 6);
 const projectileMat = new THREE.MeshLambertMaterial({ color: 0xffff00 });
 const projectileMeshes = [];
+// Zero-copy builds draw all projectiles with one InstancedMesh sized to the WASM capacity (10k+ in high-volume builds)
+let projectileInstances = null;
 
 function updateCharacterAnimation(isMoving, isInAir, runTime) {
   const phase = ((runTime % RUN_CYCLE_DURATION) / RUN_CYCLE_DURATION) * Math.PI * 2;
@@ -693,6 +869,10 @@ document.addEventListener('pointerlockchange', () => {
 document.addEventListener('keydown', (e) => {
   keys[e.code] = true;
   if (e.code === 'Escape') document.exitPointerLock();
+  if (e.code === 'F8' && saveRecording) {
+    e.preventDefault();
+    saveRecording();
+  }
 });
 document.addEventListener('keyup', (e) => { keys[e.code] = false; });
 
@@ -765,6 +945,7 @@ function gameLoop() {
   }
   
   game_update(dt, keysMask, mouseDeltaX, mouseDeltaY, shouldShoot ? 1 : 0);
+  if (logStats) logStats();
   mouseDeltaX = 0;
   mouseDeltaY = 0;
 
@@ -777,13 +958,29 @@ function gameLoop() {
   const isInAir = game_get_is_in_air();
   const runTime = game_get_run_time();
 
+  if (refreshObstacles && wasmBuffers.frame.length > GAME_FRAME_WORLD_VERSION &&
+      wasmBuffers.frame[GAME_FRAME_WORLD_VERSION] !== worldVersion) {
+    refreshObstacles();
+  }
+  if (floorFollowsPlayer) recenterFloor(px, pz);
+
   const rootY = py - 0.5;
   character.position.set(px, rootY, pz);
   character.rotation.y = yaw;
   updateCharacterAnimation(!!isMoving, !!isInAir, runTime);
 
   const projCount = game_get_projectile_count();
-  while (projectileMeshes.length < projCount) {
+  if (projectileInstances) {
+    const te = projectileInstances.instanceMatrix.array;
+    for (let i = 0; i < projCount; i++) {
+      te[i * 16 + 12] = game_get_projectile(i, 0);
+      te[i * 16 + 13] = game_get_projectile(i, 1);
+      te[i * 16 + 14] = game_get_projectile(i, 2);
+    }
+    projectileInstances.count = projCount;
+    projectileInstances.instanceMatrix.needsUpdate = true;
+  }
+  while (!projectileInstances && projectileMeshes.length < projCount) {
     const mesh = new THREE.Mesh(projectileGeom, projectileMat);
     scene.add(mesh);
     projectileMeshes.push(mesh);
@@ -792,7 +989,7 @@ function gameLoop() {
     const mesh = projectileMeshes.pop();
     scene.remove(mesh);
   }
-  for (let i = 0; i < projCount; i++) {
+  for (let i = 0; i < projectileMeshes.length; i++) {
     const mesh = projectileMeshes[i];
     mesh.position.set(
       game_get_projectile(i, 0),
@@ -804,15 +1001,39 @@ function gameLoop() {
   const frontX = game_get_front(0);
   const frontY = game_get_front(1);
   const frontZ = game_get_front(2);
-  camera.position.set(
-    px - frontX * CAMERA_DISTANCE,
-    py + CAMERA_HEIGHT - frontY * CAMERA_DISTANCE,
-    pz - frontZ * CAMERA_DISTANCE
-  );
+  let camX = -frontX * CAMERA_DISTANCE;
+  let camY = CAMERA_HEIGHT - frontY * CAMERA_DISTANCE;
+  let camZ = -frontZ * CAMERA_DISTANCE;
+  // Camera collision: cast from the player towards the camera and pull it in front of the first hit
+  if (wasmBuffers && wasmBuffers.raycastBatch) {
+    const { rays, rayHits, rayHitIndices } = wasmBuffers;
+    const camDist = Math.hypot(camX, camY, camZ);
+    rays[0] = px; rays[1] = py; rays[2] = pz;
+    rays[3] = camX; rays[4] = camY; rays[5] = camZ;
+    rays[6] = camDist;
+    wasmBuffers.raycastBatch(1);
+    if (rayHitIndices[0] !== GAME_RAY_MISS) {
+      const s = Math.max(rayHits[1] - CAMERA_COLLISION_MARGIN, 0) / camDist;
+      camX *= s; camY *= s; camZ *= s;
+    }
+  }
+  camera.position.set(px + camX, py + camY, pz + camZ);
   camera.lookAt(px, py, pz);
 
   // Update obstacle rotations for all three shape meshes
-  if (obstacleCount > 0 && getObstacleRotation) {
+  if (obstacleCount > 0 && wasmBuffers && wasmBuffers.cullObstacles) {
+    writeCullParams(wasmBuffers.cullParams);
+    wasmBuffers.cullObstacles();
+    uploadVisibleObstacles(obstacleCubes, OBSTACLE_TYPE_CUBE, false);
+    uploadVisibleObstacles(obstacleSpheres, OBSTACLE_TYPE_SPHERE, true);
+    uploadVisibleObstacles(obstacleTriangles, OBSTACLE_TYPE_TRIANGLE, false);
+  } else if (obstacleCount > 0 && wasmBuffers) {
+    const { obstaclePositions, obstacleRotations, obstacleRotationSpeeds } = wasmBuffers;
+    const t = wasmBuffers.getRotationTime();
+    writeObstacleMatrices(obstacleCubes, obstacleCubeIndices, obstaclePositions, obstacleRotations, obstacleRotationSpeeds, t);
+    writeObstacleMatrices(obstacleSpheres, obstacleSphereIndices, obstaclePositions, obstacleRotations, obstacleRotationSpeeds, t);
+    writeObstacleMatrices(obstacleTriangles, obstacleTriangleIndices, obstaclePositions, obstacleRotations, obstacleRotationSpeeds, t);
+  } else if (obstacleCount > 0 && getObstacleRotation) {
     const matrix = new THREE.Matrix4();
     function updateMesh(mesh, indices) {
       if (!mesh || !indices.length) return;
@@ -883,13 +1104,116 @@ function gameLoop() {
     const hasObstacleType = typeof Module['_game_get_obstacle_type'] === 'function';
     getObstacleType = hasObstacleType ? Module.cwrap('game_get_obstacle_type', 'number', ['number']) : null;
 
-    Module.ccall('game_init', null, [], []);
-    obstacleCount = game_get_obstacle_count();
-    if (getObstacleType) {
-      ensureObstaclesByType(getObstacleType, obstacleCount);
+    // Zero-copy path: wrap the WASM-side buffers once and read them directly instead of one cwrap call per value
+    if (typeof Module['_game_get_buffer'] === 'function' && Module.HEAPF32) {
+      const getBuffer = Module.cwrap('game_get_buffer', 'number', ['number']);
+      const getBufferStride = Module.cwrap('game_get_buffer_stride', 'number', ['number']);
+      const getBufferCount = Module.cwrap('game_get_buffer_count', 'number', ['number']);
+      const view = (heap, id) => {
+        const start = getBuffer(id) / heap.BYTES_PER_ELEMENT;
+        return heap.subarray(start, start + getBufferCount(id) * getBufferStride(id) / heap.BYTES_PER_ELEMENT);
+      };
+      wasmBuffers = {
+        frame: view(Module.HEAPF32, GAME_BUFFER_FRAME),
+        obstaclePositions: view(Module.HEAPF32, GAME_BUFFER_OBSTACLE_POSITIONS),
+        obstacleRotations: view(Module.HEAPF32, GAME_BUFFER_OBSTACLE_ROTATIONS),
+        obstacleColors: view(Module.HEAPU32, GAME_BUFFER_OBSTACLE_COLORS),
+        obstacleTypes: view(Module.HEAPU8, GAME_BUFFER_OBSTACLE_TYPES),
+        projectilePositions: view(Module.HEAPF32, GAME_BUFFER_PROJECTILE_POSITIONS),
+      };
+      // Builds with analytic obstacle rotation export base rotations + speeds and the time to apply them at
+      if (typeof Module['_game_get_obstacle_rotation_time'] === 'function') {
+        wasmBuffers.obstacleRotationSpeeds = view(Module.HEAPF32, GAME_BUFFER_OBSTACLE_ROTATION_SPEEDS);
+        wasmBuffers.getRotationTime = Module.cwrap('game_get_obstacle_rotation_time', 'number', []);
+      } else {
+        wasmBuffers.obstacleRotationSpeeds = new Float32Array(wasmBuffers.obstacleRotations.length);
+        wasmBuffers.getRotationTime = () => 0;
+      }
+      const { frame, obstaclePositions, obstacleColors, obstacleTypes, projectilePositions } = wasmBuffers;
+      game_get_player_position = (axis) => frame[GAME_FRAME_PLAYER_X + axis];
+      game_get_player_rotation = (axis) => frame[GAME_FRAME_YAW + axis];
+      game_get_front = (axis) => frame[GAME_FRAME_FRONT_X + axis];
+      game_get_is_moving = () => frame[GAME_FRAME_IS_MOVING];
+      game_get_is_in_air = () => frame[GAME_FRAME_IS_IN_AIR];
+      game_get_run_time = () => frame[GAME_FRAME_RUN_TIME];
+      game_get_projectile_count = () => frame[GAME_FRAME_PROJECTILE_COUNT];
+      game_get_projectile = (i, axis) => projectilePositions[i * 3 + axis];
+      getObstacleX = (i) => obstaclePositions[i * 3];
+      getObstacleY = (i) => obstaclePositions[i * 3 + 1];
+      getObstacleZ = (i) => obstaclePositions[i * 3 + 2];
+      getObstacleColor = (i) => obstacleColors[i];
+      getObstacleType = (i) => obstacleTypes[i];
+      projectileInstances = new THREE.InstancedMesh(projectileGeom, projectileMat, getBufferCount(GAME_BUFFER_PROJECTILE_POSITIONS));
+      projectileInstances.count = 0;
+      projectileInstances.frustumCulled = false; // instances move every frame; the base geometry's bounds don't cover them
+      scene.add(projectileInstances);
+
+      // Builds with the obstacle BVH: rays are written into / read from WASM-side buffers (hit index is int32)
+      if (typeof Module['_game_raycast_batch'] === 'function') {
+        wasmBuffers.rays = view(Module.HEAPF32, GAME_BUFFER_RAYS);
+        wasmBuffers.rayHits = view(Module.HEAPF32, GAME_BUFFER_RAY_HITS);
+        wasmBuffers.rayHitIndices = new Int32Array(wasmBuffers.rayHits.buffer, wasmBuffers.rayHits.byteOffset, wasmBuffers.rayHits.length);
+        wasmBuffers.raycastBatch = Module.cwrap('game_raycast_batch', 'number', ['number']);
+      }
+
+      // Builds with WASM-side culling: per-type visible lists and ready-made instance matrices
+      if (typeof Module['_game_cull_obstacles'] === 'function') {
+        wasmBuffers.cullParams = view(Module.HEAPF32, GAME_BUFFER_CULL_PARAMS);
+        wasmBuffers.visibleMatrices = view(Module.HEAPF32, GAME_BUFFER_VISIBLE_MATRICES);
+        const visibleIndices = view(Module.HEAPU32, GAME_BUFFER_VISIBLE_INDICES);
+        const visibleLists = view(Module.HEAPU32, GAME_BUFFER_VISIBLE_LISTS);
+        wasmBuffers.visibleIndices = new Int32Array(visibleIndices.buffer, visibleIndices.byteOffset, visibleIndices.length);
+        wasmBuffers.visibleLists = new Int32Array(visibleLists.buffer, visibleLists.byteOffset, visibleLists.length);
+        wasmBuffers.cullObstacles = Module.cwrap('game_cull_obstacles', 'number', []);
+      }
+
+      // Fixed-step builds: simulate at SIM_TICK_RATE and draw player/projectiles blended between the last two ticks
+      if (typeof Module['_game_set_fixed_timestep'] === 'function') {
+        Module.ccall('game_set_fixed_timestep', null, ['number', 'number'], [SIM_TICK_RATE, SIM_MAX_CATCHUP_STEPS]);
+        const projectilePrevPositions = view(Module.HEAPF32, GAME_BUFFER_PROJECTILE_PREV_POSITIONS);
+        const lerp = (a, b) => a + (b - a) * frame[GAME_FRAME_ALPHA];
+        game_get_player_position = (axis) => lerp(frame[GAME_FRAME_PREV_PLAYER_X + axis], frame[GAME_FRAME_PLAYER_X + axis]);
+        game_get_projectile = (i, axis) => lerp(projectilePrevPositions[i * 3 + axis], projectilePositions[i * 3 + axis]);
+      }
+    }
+
+    // GAME_THREADS builds: spread the parallel phases over the cores (workers need a cross-origin isolated page)
+    if (typeof Module['_game_set_thread_count'] === 'function' && self.crossOriginIsolated) {
+      Module.ccall('game_set_thread_count', 'number', ['number'], [Math.min(navigator.hardwareConcurrency || 1, 8)]);
+    }
+
+    // ?record: log every game_update from a fresh start; replay the download with wasm/native/replay.c
+    if (new URLSearchParams(window.location.search).has('record') && typeof Module['_game_record_start'] === 'function') {
+      Module.ccall('game_record_start', null, [], []);
+      saveRecording = () => {
+        const start = Module.ccall('game_get_buffer', 'number', ['number'], [GAME_BUFFER_RECORD]);
+        const size = Module.ccall('game_get_record_size', 'number', [], []);
+        const url = URL.createObjectURL(new Blob([Module.HEAPU8.slice(start, start + size)], { type: 'application/octet-stream' }));
+        const link = document.createElement('a');
+        link.href = url;
+        link.download = 'test1-input.bin';
+        link.click();
+        URL.revokeObjectURL(url);
+      };
     } else {
-      // Old WASM build: all obstacles as cubes (single InstancedMesh)
-      ensureObstaclesByType(() => OBSTACLE_TYPE_CUBE, obstacleCount);
+      Module.ccall('game_init', null, [], []);
+    }
+    // ?stats: GAME_STATS builds expose per-phase timings and work counters of the last update (GameStats)
+    const statsPtr = typeof Module['_game_get_stats'] === 'function' ? Module.ccall('game_get_stats', 'number', [], []) : 0;
+    if (new URLSearchParams(window.location.search).has('stats') && statsPtr) {
+      const stats = new Uint32Array(Module.HEAPU32.buffer, statsPtr, GAME_STATS_FIELD_NAMES.length);
+      let worst = null;
+      let nextLog = performance.now() + 1000;
+      logStats = () => {
+        if (!worst || stats[2] > worst[2]) worst = stats.slice();
+        if (performance.now() < nextLog) return;
+        console.log('slowest game_update this second:', Object.fromEntries(GAME_STATS_FIELD_NAMES.map((name, i) => [name, worst[i]])));
+        worst = null;
+        nextLog += 1000;
+      };
+    }
+    if (typeof Module['_game_get_world_half_size'] === 'function') {
+      floorFollowsPlayer = Module.ccall('game_get_world_half_size', 'number', [], []) === 0;
     }
 
     // Set initial colors for each shape mesh
@@ -903,16 +1227,37 @@ function gameLoop() {
       }
       if (mesh.instanceColor) mesh.instanceColor.needsUpdate = true;
     }
-    // Cube obstacles: white instance color so GrassTile texture shows
-    if (obstacleCubes && obstacleCubeIndices.length > 0) {
-      const white = new THREE.Color(0xffffff);
-      for (let k = 0; k < obstacleCubeIndices.length; k++) {
-        obstacleCubes.setColorAt(k, white);
+    function buildObstacleMeshes() {
+      obstacleCount = game_get_obstacle_count();
+      if (getObstacleType) {
+        ensureObstaclesByType(getObstacleType, obstacleCount);
+      } else {
+        // Old WASM build: all obstacles as cubes (single InstancedMesh)
+        ensureObstaclesByType(() => OBSTACLE_TYPE_CUBE, obstacleCount);
       }
-      if (obstacleCubes.instanceColor) obstacleCubes.instanceColor.needsUpdate = true;
+      // Cube obstacles: white instance color so GrassTile texture shows
+      if (obstacleCubes && obstacleCubeIndices.length > 0) {
+        const white = new THREE.Color(0xffffff);
+        for (let k = 0; k < obstacleCubeIndices.length; k++) {
+          obstacleCubes.setColorAt(k, white);
+        }
+        if (obstacleCubes.instanceColor) obstacleCubes.instanceColor.needsUpdate = true;
+      }
+      setColorsForMesh(obstacleSpheres, obstacleSphereIndices);
+      // Triangle obstacles use RockTile texture only (no per-instance color)
+      if (wasmBuffers && wasmBuffers.cullObstacles) {
+        // Instances are already culled in WASM; three's bounds for the mesh would be stale as the set changes
+        [obstacleCubes, obstacleSpheres, obstacleTriangles].forEach(m => { if (m) m.frustumCulled = false; });
+      }
+    }
+    buildObstacleMeshes();
+    if (wasmBuffers) {
+      worldVersion = wasmBuffers.frame[GAME_FRAME_WORLD_VERSION];
+      refreshObstacles = () => {
+        worldVersion = wasmBuffers.frame[GAME_FRAME_WORLD_VERSION];
+        buildObstacleMeshes();
+      };
     }
-    setColorsForMesh(obstacleSpheres, obstacleSphereIndices);
-    // Triangle obstacles use RockTile texture only (no per-instance color)
     gameLoop();
   }
 })();
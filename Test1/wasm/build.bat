@@ -1,5 +1,7 @@
 @echo off
 REM Build WASM game module (requires Emscripten: https://emscripten.org/docs/getting_started/downloads.html)
+REM Extra arguments go to emcc, e.g. build.bat -DPROJECTILE_HIGH_VOLUME=1 for the 16k-projectile build, or
+REM build.bat -DGAME_THREADS=1 -pthread -sPTHREAD_POOL_SIZE=4 for parallel phases (page must be cross-origin isolated)
 set SCRIPT_DIR=%~dp0
 cd /d "%SCRIPT_DIR%"
 REM If emcc is not in PATH, try project emsdk (run "emsdk install latest" and "emsdk activate latest" once)
@@ -7,8 +9,8 @@ where emcc >nul 2>&1 || if exist "%~dp0..\emsdk\emsdk_env.bat" call "%~dp0..\ems
 emcc game.c -o game.js ^
   -s MODULARIZE=1 ^
   -s EXPORT_NAME="createGameModule" ^
-  -s EXPORTED_FUNCTIONS="['_malloc','_free','_game_init','_game_update','_game_get_player_position','_game_get_player_x','_game_get_player_y','_game_get_player_z','_game_get_player_rotation','_game_get_player_yaw','_game_get_player_pitch','_game_get_front','_game_get_front_x','_game_get_front_y','_game_get_front_z','_game_get_projectile_count','_game_get_projectile','_game_get_projectile_x','_game_get_projectile_y','_game_get_projectile_z','_game_get_obstacle_count','_game_get_obstacle','_game_get_obstacle_x','_game_get_obstacle_y','_game_get_obstacle_z','_game_get_obstacle_rotation','_game_get_obstacle_color','_game_get_obstacle_type','_game_get_is_moving','_game_get_is_in_air','_game_get_run_time']" ^
-  -s EXPORTED_RUNTIME_METHODS="['ccall','cwrap']" ^
+  -s EXPORTED_FUNCTIONS="['_malloc','_free','_game_init','_game_update','_game_set_fixed_timestep','_game_get_interpolation_alpha','_game_get_player_position','_game_get_player_x','_game_get_player_y','_game_get_player_z','_game_get_player_rotation','_game_get_player_yaw','_game_get_player_pitch','_game_get_front','_game_get_front_x','_game_get_front_y','_game_get_front_z','_game_get_projectile_count','_game_spawn_projectile','_game_get_projectile','_game_get_projectile_x','_game_get_projectile_y','_game_get_projectile_z','_game_get_obstacle_count','_game_get_obstacle','_game_get_obstacle_x','_game_get_obstacle_y','_game_get_obstacle_z','_game_get_obstacle_rotation','_game_get_obstacle_rotation_time','_game_get_sim_time','_game_get_obstacle_color','_game_get_obstacle_type','_game_get_world_version','_game_get_world_half_size','_game_get_is_moving','_game_get_is_in_air','_game_get_run_time','_game_get_buffer','_game_get_buffer_stride','_game_get_buffer_count','_game_get_terrain_height','_game_get_terrain_normal','_game_get_terrain_max_error','_game_raycast','_game_raycast_batch','_game_cull_obstacles','_game_get_state_size','_game_snapshot','_game_restore','_game_get_tick','_game_snapshot_push','_game_snapshot_rewind','_game_get_snapshot_count','_game_record_start','_game_record_stop','_game_get_record_size','_game_state_hash','_game_get_stats','_game_set_thread_count','_game_world_default','_game_world_create','_game_world_destroy','_game_world_update','_game_worlds_update','_game_world_get_frame','_game_world_state_hash','_game_net_client_open','_game_net_client_close','_game_net_client_view','_game_net_encode','_game_net_ack','_game_net_replica_create','_game_net_replica_destroy','_game_net_replica_apply','_game_net_replica_tick','_game_net_replica_count','_game_net_replica_id','_game_net_replica_field']" ^
+  -s EXPORTED_RUNTIME_METHODS="['ccall','cwrap','HEAPF32','HEAPU32','HEAPU8']" ^
   -s INITIAL_MEMORY=16777216 ^
-  -O2
+  -I..\..\shared -O2 -msimd128 %*
 echo Build complete. Output: game.js, game.wasm
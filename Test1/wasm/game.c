@@ -1,5 +1,13 @@
 #include "game.h"
+#include "narrowphase.h"
+#include "jobs.h"
+#include "hash.h"
+#define STATS_STEP_NAME "tick"
+#include "stats.h"
+#include "netcode.h"
 #include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 /* Constants (match JS game) */
@@ -18,6 +26,22 @@
 #define PROJECTILE_MAX_DIST 50.f
 #define PROJECTILE_BOUNCE_COEFFICIENT 0.7f
 #define MAX_PITCH_RAD ((89.f * 3.14159265f) / 180.f)
+#ifndef PROJECTILE_PAIR_COLLISIONS
+#define PROJECTILE_PAIR_COLLISIONS PROJECTILE_HIGH_VOLUME  /* projectiles bounce off each other */
+#endif
+/* Spatial hash over live projectiles, rebuilt by counting sort every tick. Cells are one projectile
+   diameter wide, so touching projectiles are always in the same or adjacent cells. */
+#define PROJECTILE_HASH_CELL_SIZE (2.f * PROJECTILE_RADIUS)
+#define PROJECTILE_HASH_BUCKETS (PROJECTILE_HIGH_VOLUME ? 32768 : 256)  /* power of two, ~2x MAX_PROJECTILES */
+#define PROJECTILE_JOB_CHUNK 256   /* projectiles per jobs_parallel_for chunk */
+#define ROTATION_JOB_CHUNK   4096  /* obstacles per chunk of the reference-mode rotation update */
+#ifndef GAME_FIXED_TIMESTEP_HZ
+#define GAME_FIXED_TIMESTEP_HZ 0  /* 0 = one variable step per game_update; see game_set_fixed_timestep */
+#endif
+#define GAME_MAX_CATCHUP_STEPS 5  /* default cap on fixed steps per game_update */
+#ifndef OBSTACLE_ROTATION_ANALYTIC
+#define OBSTACLE_ROTATION_ANALYTIC 1  /* 0 = integrate every obstacle's rotation each tick (reference mode) */
+#endif
 
 #define OBSTACLE_TYPE_CUBE    0
 #define OBSTACLE_TYPE_SPHERE  1
@@ -25,12 +49,40 @@
 #define OBSTACLE_SPHERE_RADIUS 0.5f
 #define OBSTACLE_TRIANGLE_HALF_Y 0.25f
 #define OBSTACLE_PLACEMENT_GAP 0.25f  /* min distance between obstacle surfaces */
+#ifndef OBSTACLE_PLACEMENT_SEED
+#define OBSTACLE_PLACEMENT_SEED 12345u  /* same seed -> same obstacle layout */
+#endif
+#define OBSTACLE_MAX_HALF_EXTENT 0.5f /* largest XZ half extent of any obstacle type */
+
+/* World streaming (WORLD_STREAMING=1): the world is cut into WORLD_CHUNK_SIZE squares and only the chunks
+   within WORLD_CHUNK_RADIUS of the player's chunk are resident, each in one of WORLD_CHUNK_SLOTS cache slots
+   (game.h). Chunk contents depend only on (OBSTACLE_PLACEMENT_SEED, chunk x, chunk z). */
+#define WORLD_CHUNK_SIZE 32.f  /* ~32 obstacles per 32x32 chunk matches the fixed world's density */
+#define WORLD_CHUNK_RADIUS 3
+#define WORLD_CHUNK_INSET (OBSTACLE_MAX_HALF_EXTENT + OBSTACLE_PLACEMENT_GAP)
+#if WORLD_STREAMING && (2 * WORLD_CHUNK_RADIUS + 1) * (2 * WORLD_CHUNK_RADIUS + 1) > WORLD_CHUNK_SLOTS
+#error "WORLD_CHUNK_SLOTS must hold the (2 * WORLD_CHUNK_RADIUS + 1)^2 resident window"
+#endif
+
+/* Uniform grid over the floor, obstacles binned by center (built once in game_init) */
+#define OBSTACLE_GRID_DIM 256
+#define OBSTACLE_GRID_CELL_SIZE ((2.f * FLOOR_HALF_SIZE) / (float)OBSTACLE_GRID_DIM)
+#define OBSTACLE_GRID_CELLS (OBSTACLE_GRID_DIM * OBSTACLE_GRID_DIM)
 
 /* Terrain height = world Y of surface. JS plane: vertex (x, y, -h) -> after rotateX(-90) -> (x, -h, -y), so world (x, z) = (x, -y) and world Y = -h(x, -z). */
 #define TERRAIN_SCALE 0.04f
 #define TERRAIN_AMP 6.f
 #define TERRAIN_OBSTACLE_CLEARANCE 0.01f  /* minimal lift so obstacles sit on terrain, not float */
-static float terrain_height(float x, float z) {
+#define TERRAIN_MAX_ABS_HEIGHT (TERRAIN_AMP * 1.2f)  /* |height| <= AMP * (0.5 + 0.4 + 0.3) */
+#define TERRAIN_MAX_SLOPE 0.4f     /* bound on |grad height|: AMP * SCALE * (0.5 + 0.4 * 1.3 + 0.3 * 0.5) ~= 0.28 per axis */
+#define TERRAIN_RAY_MIN_STEP 0.05f /* ray march floor; features narrower than this can be stepped over */
+#ifndef TERRAIN_HEIGHTFIELD
+#define TERRAIN_HEIGHTFIELD 1  /* 0 = reference mode: evaluate terrain_height_analytic everywhere */
+#endif
+#ifndef TERRAIN_HEIGHTFIELD_RES
+#define TERRAIN_HEIGHTFIELD_RES 512  /* cells per side over the floor (power of two) */
+#endif
+static float terrain_height_analytic(float x, float z) {
   float plane_y = -z; /* world Z = -plane Y */
   float h = TERRAIN_AMP * (
     0.5f * sinf(x * TERRAIN_SCALE) * cosf(plane_y * TERRAIN_SCALE * 0.8f) +
@@ -39,36 +91,304 @@ static float terrain_height(float x, float z) {
   return -h; /* world Y = -h */
 }
 /* Max terrain height under an obstacle's footprint (3x3 grid to catch peaks on bumpy terrain) */
-static float terrain_height_under_footprint(float x, float z, float half_ext) {
-  float max_y = terrain_height(x, z);
+static float terrain_height_under_footprint_analytic(float x, float z, float half_ext) {
+  float max_y = terrain_height_analytic(x, z);
   float step = half_ext; /* 3x3 grid over full footprint: -half_ext, 0, +half_ext */
   for (int ix = -1; ix <= 1; ix++) {
     for (int iz = -1; iz <= 1; iz++) {
       float sx = x + (float)ix * step;
       float sz = z + (float)iz * step;
-      float ty = terrain_height(sx, sz);
+      float ty = terrain_height_analytic(sx, sz);
       if (ty > max_y) max_y = ty;
     }
   }
   return max_y + TERRAIN_OBSTACLE_CLEARANCE;
 }
 
+#if TERRAIN_HEIGHTFIELD
+/* Heightfield over the floor: (RES + 1)^2 samples of terrain_height_analytic, bilinearly interpolated.
+   Level k of the max pyramid holds, per (RES >> k)^2 cell, the highest sample touching that cell, which
+   bounds the interpolated surface from above. Points off the floor fall back to the analytic function. */
+#define TERRAIN_HF_SAMPLES (TERRAIN_HEIGHTFIELD_RES + 1)
+#define TERRAIN_HF_CELL_SIZE ((2.f * FLOOR_HALF_SIZE) / (float)TERRAIN_HEIGHTFIELD_RES)
+#define TERRAIN_HF_MAX_LEVELS 16
+static float terrain_samples[TERRAIN_HF_SAMPLES * TERRAIN_HF_SAMPLES];
+static float terrain_max_pyramid[TERRAIN_HEIGHTFIELD_RES * TERRAIN_HEIGHTFIELD_RES * 4 / 3 + 1];
+static int terrain_pyramid_offset[TERRAIN_HF_MAX_LEVELS];
+static int terrain_pyramid_levels;
+static int terrain_heightfield_built;
+static float terrain_max_error; /* max |bilinear - analytic| measured at cell centers when built */
+
+/* terrain_height_analytic is a sum of products of one-dimensional terms in x and in plane Y (-z),
+   (sin(a + b) expanded for the diagonal wave), so a whole grid needs only O(RES) trig calls. */
+static void terrain_x_terms(float x, float* t) {
+  float e = x * TERRAIN_SCALE * 0.5f;
+  t[0] = 0.5f * sinf(x * TERRAIN_SCALE);
+  t[1] = 0.4f * sinf(x * TERRAIN_SCALE * 1.3f + 1.f);
+  t[2] = 0.3f * sinf(e);
+  t[3] = 0.3f * cosf(e);
+}
+static void terrain_z_terms(float z, float* t) {
+  float plane_y = -z, e = plane_y * TERRAIN_SCALE * 0.5f;
+  t[0] = cosf(plane_y * TERRAIN_SCALE * 0.8f);
+  t[1] = cosf(plane_y * TERRAIN_SCALE * 1.1f + 0.5f);
+  t[2] = cosf(e);
+  t[3] = sinf(e);
+}
+static float terrain_terms_height(const float* tx, const float* tz) {
+  return -TERRAIN_AMP * (tx[0] * tz[0] + tx[1] * tz[1] + tx[2] * tz[2] + tx[3] * tz[3]);
+}
+
+static void terrain_heightfield_build(void) {
+  static float x_terms[TERRAIN_HF_SAMPLES * 2][4], z_terms[TERRAIN_HF_SAMPLES * 2][4]; /* samples, then cell centers */
+  const int n = TERRAIN_HF_SAMPLES;
+  for (int i = 0; i < n; i++) {
+    float p = -FLOOR_HALF_SIZE + (float)i * TERRAIN_HF_CELL_SIZE;
+    float c = p + 0.5f * TERRAIN_HF_CELL_SIZE;
+    terrain_x_terms(p, x_terms[i]);
+    terrain_z_terms(p, z_terms[i]);
+    terrain_x_terms(c, x_terms[n + i]);
+    terrain_z_terms(c, z_terms[n + i]);
+  }
+  for (int iz = 0; iz < n; iz++)
+    for (int ix = 0; ix < n; ix++)
+      terrain_samples[iz * n + ix] = terrain_terms_height(x_terms[ix], z_terms[iz]);
+  /* Level 0: max of each cell's four corners; level k: max of four level k-1 children.
+     The bilinear error is measured against the analytic height at each cell center. */
+  int dim = TERRAIN_HEIGHTFIELD_RES, offset = 0, levels = 0;
+  float max_err = 0.f;
+  for (int iz = 0; iz < dim; iz++) {
+    for (int ix = 0; ix < dim; ix++) {
+      const float* s = &terrain_samples[iz * n + ix];
+      float m = fmaxf(fmaxf(s[0], s[1]), fmaxf(s[n], s[n + 1]));
+      terrain_max_pyramid[iz * dim + ix] = m;
+      float center = 0.25f * (s[0] + s[1] + s[n] + s[n + 1]);
+      float err = fabsf(center - terrain_terms_height(x_terms[n + ix], z_terms[n + iz]));
+      if (err > max_err) max_err = err;
+    }
+  }
+  terrain_pyramid_offset[levels++] = 0;
+  while (dim > 1 && levels < TERRAIN_HF_MAX_LEVELS) {
+    const float* src = &terrain_max_pyramid[offset];
+    int src_dim = dim;
+    offset += dim * dim;
+    dim >>= 1;
+    float* dst = &terrain_max_pyramid[offset];
+    for (int iz = 0; iz < dim; iz++) {
+      for (int ix = 0; ix < dim; ix++) {
+        const float* c = &src[(iz * 2) * src_dim + ix * 2];
+        dst[iz * dim + ix] = fmaxf(fmaxf(c[0], c[1]), fmaxf(c[src_dim], c[src_dim + 1]));
+      }
+    }
+    terrain_pyramid_offset[levels++] = offset;
+  }
+  terrain_pyramid_levels = levels;
+  terrain_max_error = max_err;
+  terrain_heightfield_built = 1;
+}
+
+/* Heightfield coordinates of (x, z) in cells; 0 if the point is off the sampled floor. */
+static int terrain_grid_coords(float x, float z, float* gx, float* gz) {
+  *gx = (x + FLOOR_HALF_SIZE) / TERRAIN_HF_CELL_SIZE;
+  *gz = (z + FLOOR_HALF_SIZE) / TERRAIN_HF_CELL_SIZE;
+  return *gx >= 0.f && *gz >= 0.f &&
+         *gx < (float)TERRAIN_HEIGHTFIELD_RES && *gz < (float)TERRAIN_HEIGHTFIELD_RES;
+}
+
+static float terrain_height(float x, float z) {
+  float gx, gz;
+  if (!terrain_grid_coords(x, z, &gx, &gz)) return terrain_height_analytic(x, z);
+  int ix = (int)gx, iz = (int)gz;
+  float fx = gx - (float)ix, fz = gz - (float)iz;
+  const float* s = &terrain_samples[iz * TERRAIN_HF_SAMPLES + ix];
+  float h0 = s[0] + (s[1] - s[0]) * fx;
+  float h1 = s[TERRAIN_HF_SAMPLES] + (s[TERRAIN_HF_SAMPLES + 1] - s[TERRAIN_HF_SAMPLES]) * fx;
+  return h0 + (h1 - h0) * fz;
+}
+
+/* Unit surface normal from the gradient of the bilinear patch under (x, z). */
+static void terrain_normal(float x, float z, float* nx, float* ny, float* nz) {
+  float gx, gz, dhdx, dhdz;
+  if (terrain_grid_coords(x, z, &gx, &gz)) {
+    int ix = (int)gx, iz = (int)gz;
+    float fx = gx - (float)ix, fz = gz - (float)iz;
+    const float* s = &terrain_samples[iz * TERRAIN_HF_SAMPLES + ix];
+    const float* t = s + TERRAIN_HF_SAMPLES;
+    dhdx = ((s[1] - s[0]) * (1.f - fz) + (t[1] - t[0]) * fz) / TERRAIN_HF_CELL_SIZE;
+    dhdz = ((t[0] - s[0]) * (1.f - fx) + (t[1] - s[1]) * fx) / TERRAIN_HF_CELL_SIZE;
+  } else {
+    const float e = 0.05f;
+    dhdx = (terrain_height_analytic(x + e, z) - terrain_height_analytic(x - e, z)) / (2.f * e);
+    dhdz = (terrain_height_analytic(x, z + e) - terrain_height_analytic(x, z - e)) / (2.f * e);
+  }
+  float len = sqrtf(dhdx * dhdx + 1.f + dhdz * dhdz);
+  *nx = -dhdx / len; *ny = 1.f / len; *nz = -dhdz / len;
+}
+
+/* Max terrain height under a square footprint: at most 3x3 lookups in the coarsest pyramid level needed,
+   so the cost does not depend on the footprint size. Conservative (never below the surface). */
+static float terrain_height_under_footprint(float x, float z, float half_ext) {
+  float gx0, gz0, gx1, gz1;
+  if (!terrain_grid_coords(x - half_ext, z - half_ext, &gx0, &gz0) ||
+      !terrain_grid_coords(x + half_ext, z + half_ext, &gx1, &gz1))
+    return terrain_height_under_footprint_analytic(x, z, half_ext);
+  float width = fmaxf(gx1 - gx0, gz1 - gz0);
+  int level = 0;
+  while (level < terrain_pyramid_levels - 1 && width > (float)(2 << level)) level++;
+  int dim = TERRAIN_HEIGHTFIELD_RES >> level;
+  const float* mip = &terrain_max_pyramid[terrain_pyramid_offset[level]];
+  int ix0 = (int)gx0 >> level, iz0 = (int)gz0 >> level;
+  int ix1 = (int)gx1 >> level, iz1 = (int)gz1 >> level;
+  if (ix1 >= dim) ix1 = dim - 1;
+  if (iz1 >= dim) iz1 = dim - 1;
+  float max_y = mip[iz0 * dim + ix0];
+  for (int iz = iz0; iz <= iz1; iz++)
+    for (int ix = ix0; ix <= ix1; ix++)
+      max_y = fmaxf(max_y, mip[iz * dim + ix]);
+  return max_y + TERRAIN_OBSTACLE_CLEARANCE;
+}
+#else
+static float terrain_height(float x, float z) { return terrain_height_analytic(x, z); }
+static void terrain_normal(float x, float z, float* nx, float* ny, float* nz) {
+  const float e = 0.05f;
+  float dhdx = (terrain_height_analytic(x + e, z) - terrain_height_analytic(x - e, z)) / (2.f * e);
+  float dhdz = (terrain_height_analytic(x, z + e) - terrain_height_analytic(x, z - e)) / (2.f * e);
+  float len = sqrtf(dhdx * dhdx + 1.f + dhdz * dhdz);
+  *nx = -dhdx / len; *ny = 1.f / len; *nz = -dhdz / len;
+}
+static float terrain_height_under_footprint(float x, float z, float half_ext) {
+  return terrain_height_under_footprint_analytic(x, z, half_ext);
+}
+#endif
+
 typedef struct { float x, y, z; } Vec3;
-typedef struct { float x, y, z, vx, vy, vz; } Projectile;
 
 static Vec3 obstacle_centers[NUM_OBSTACLES];
 static unsigned char obstacle_types[NUM_OBSTACLES]; /* 0=cube, 1=sphere, 2=triangle */
-static float obstacle_rotations[NUM_OBSTACLES];
+static float obstacle_rotations[NUM_OBSTACLES]; /* rotation at sim_time 0 (reference mode: as placed, see GameState) */
 static float obstacle_rotation_speeds[NUM_OBSTACLES];
 static unsigned int obstacle_colors[NUM_OBSTACLES]; /* RGB packed as 0xRRGGBB */
-static unsigned int rng_state = 12345u;
+static int obstacle_grid_start[OBSTACLE_GRID_CELLS + 1]; /* cell c owns items [start[c], start[c + 1]) */
+static int obstacle_grid_items[NUM_OBSTACLES]; /* obstacle indices, ascending within each cell */
+static float obstacle_grid_origin_x = -FLOOR_HALF_SIZE, obstacle_grid_origin_z = -FLOOR_HALF_SIZE; /* grid min corner */
+/* Obstacle shapes in grid slot order (slot k describes obstacle_grid_items[k]) for the narrowphase kernels */
+static float slot_min_x[NUM_OBSTACLES + NP_PADDING], slot_min_y[NUM_OBSTACLES + NP_PADDING], slot_min_z[NUM_OBSTACLES + NP_PADDING];
+static float slot_max_x[NUM_OBSTACLES + NP_PADDING], slot_max_y[NUM_OBSTACLES + NP_PADDING], slot_max_z[NUM_OBSTACLES + NP_PADDING];
+static float slot_center_x[NUM_OBSTACLES + NP_PADDING], slot_center_y[NUM_OBSTACLES + NP_PADDING], slot_center_z[NUM_OBSTACLES + NP_PADDING];
+static float slot_is_sphere[NUM_OBSTACLES + NP_PADDING];
+static const NpShapes obstacle_slots = {
+  slot_min_x, slot_min_y, slot_min_z, slot_max_x, slot_max_y, slot_max_z,
+  slot_center_x, slot_center_y, slot_center_z, slot_is_sphere, OBSTACLE_SPHERE_RADIUS
+};
+static int placement_cell_head[OBSTACLE_GRID_CELLS]; /* per-cell list of placed obstacles (-1 = empty) */
+static int placement_next[NUM_OBSTACLES];
+static int world_version; /* bumped whenever the set of resident obstacles changes */
+#if !WORLD_STREAMING
+static unsigned int placement_rng_end; /* rng_state after the fixed layout was placed (game_world_create) */
+#endif
+/* Static BVH over obstacle bounds, built once in game_init. Nodes are flattened depth-first: an interior
+   node's left child directly follows it and offset is its right child; a leaf (count > 0) covers
+   bvh_items[offset, offset + count). */
+#define BVH_LEAF_SIZE 4
+#define BVH_MAX_NODES (2 * NUM_OBSTACLES)
+#define BVH_STACK_SIZE 64
+typedef struct {
+  float min_x, min_y, min_z;
+  float max_x, max_y, max_z;
+  int offset;
+  int count;
+} BvhNode;
+static BvhNode bvh_nodes[BVH_MAX_NODES];
+static int bvh_items[NUM_OBSTACLES]; /* obstacle indices in leaf order */
+static int bvh_node_count;
+typedef struct { float origin_x, origin_y, origin_z, dir_x, dir_y, dir_z, max_dist; } RayQuery; /* GAME_BUFFER_RAYS */
+typedef struct { int hit; float dist, normal_x, normal_y, normal_z; } RayHit;                    /* GAME_BUFFER_RAY_HITS */
+static RayQuery ray_queries[GAME_MAX_RAYS];
+static RayHit ray_hits[GAME_MAX_RAYS];
+/* Visible set written by game_cull_obstacles, grouped per (type, LOD) list */
+#define OBSTACLE_CULL_RADIUS 0.87f  /* bounds every obstacle shape around its center at any rotation (cube: sqrt(3) / 2) */
+typedef struct { int offset, count; } CullList; /* GAME_BUFFER_VISIBLE_LISTS */
+static float cull_params[GAME_CULL_FLOATS];
+static int visible_indices[NUM_OBSTACLES];
+static float visible_matrices[NUM_OBSTACLES][16];
+static CullList visible_lists[GAME_CULL_LISTS];
+static int cull_candidates[NUM_OBSTACLES]; /* visible obstacles in traversal order, before grouping */
+static unsigned char cull_candidate_lists[NUM_OBSTACLES];
+/* All mutable simulation state lives in one arena, so a snapshot, restore or rollback is a plain copy (see
+   game_snapshot). The projectile arrays come last, so a snapshot holds everything before them plus the
+   live prefix of each. World data derived from it (obstacle layout, grids, BVH, terrain) stays outside and is
+   rebuilt on restore only if the streamed chunk set differs. */
+typedef struct {
+  unsigned int version; /* GAME_STATE_VERSION */
+  unsigned int size;    /* sizeof(GameState): rejects snapshots from builds with other limits */
+  unsigned int tick;    /* ticks simulated since game_init */
+  unsigned int rng_state;
+  Vec3 player_position;
+  Vec3 prev_player_position; /* player position before the last tick */
+  float yaw, pitch;
+  float velocity_y;
+  int is_moving, is_in_air;
+  float run_time;
+  double sim_time; /* seconds simulated since game_init */
+  double step_accumulator; /* unsimulated time carried to the next game_update (fixed-step mode) */
+  float interpolation_alpha; /* render blend between previous (0) and current (1) tick state */
+  int projectile_count;
+#if WORLD_STREAMING
+  int chunk_slot_x[WORLD_CHUNK_SLOTS], chunk_slot_z[WORLD_CHUNK_SLOTS];
+  unsigned char chunk_slot_used[WORLD_CHUNK_SLOTS];
+  int world_center_cx, world_center_cz; /* chunk the resident window is centered on */
+#endif
+#if !OBSTACLE_ROTATION_ANALYTIC
+  float obstacle_rotations[NUM_OBSTACLES]; /* integrated each tick from the placed rotation */
+#endif
+  Vec3 projectile_positions[MAX_PROJECTILES]; /* projectile state as SoA, exported via game_get_buffer */
+  Vec3 projectile_velocities[MAX_PROJECTILES];
+  Vec3 projectile_prev_positions[MAX_PROJECTILES]; /* positions before the last tick, same order as projectile_positions */
+} GameState;
+/* One simulation (GameWorld in game.h): the arena plus the latched input and per-update outputs that are
+   not part of a snapshot. World data, scratch buffers, the snapshot ring and the input recorder stay
+   shared; the last two only ever serve the default world. */
+struct GameWorld {
+  GameState state;
+  unsigned int keys_mask;
+  float pending_mouse_dx, pending_mouse_dy;
+  int pending_shoot;
+  int ticks_last_update;
+  Vec3 front_dir; /* normalized look direction, cached once per update */
+  float frame_block[GAME_FRAME_FLOATS]; /* per-frame camera/player snapshot, see GAME_FRAME_* */
+};
+static GameWorld default_world; /* zero-initialized (no data segment for the projectile arrays); game_init fills it */
+/* The world everything below acts on. It is the default world except inside game_world_* calls, which
+   switch to theirs with world_select and switch back before returning. */
+static GameWorld* world = &default_world;
+static GameState* state = &default_world.state;
+/* A snapshot is the arena up to its projectile arrays, then the live prefix of each array */
+#define STATE_HEADER_SIZE offsetof(GameState, projectile_positions)
+#define STATE_PROJECTILE_ARRAYS 3
+#define GAME_STATE_MAX_BYTES (STATE_HEADER_SIZE + (size_t)MAX_PROJECTILES * STATE_PROJECTILE_ARRAYS * sizeof(Vec3))
+/* The rewind ring packs snapshots back to back into one static pool and wraps at its end, so each costs its
+   live size and memory never grows. A push evicts the oldest entries until the new one fits. The pool holds
+   GAME_SNAPSHOT_RING full snapshots unless GAME_SNAPSHOT_RING_BYTES caps it, and never less than one.
+   Entries start on 8-byte boundaries, as game_restore reads them in place. */
+#define SNAPSHOT_ALIGNED(bytes) (((bytes) + 7) & ~(size_t)7)
+#define SNAPSHOT_ENTRY_MAX SNAPSHOT_ALIGNED(GAME_STATE_MAX_BYTES)
+#define SNAPSHOT_POOL_BYTES                                                                             \
+  (GAME_SNAPSHOT_RING_BYTES == 0 || (size_t)GAME_SNAPSHOT_RING_BYTES >= GAME_SNAPSHOT_RING * SNAPSHOT_ENTRY_MAX \
+       ? GAME_SNAPSHOT_RING * SNAPSHOT_ENTRY_MAX                                                        \
+       : SNAPSHOT_ALIGNED((size_t)GAME_SNAPSHOT_RING_BYTES) > SNAPSHOT_ENTRY_MAX                         \
+             ? SNAPSHOT_ALIGNED((size_t)GAME_SNAPSHOT_RING_BYTES)                                        \
+             : SNAPSHOT_ENTRY_MAX)
+static unsigned long long snapshot_pool[SNAPSHOT_POOL_BYTES / 8];
+static size_t snapshot_ring_offset[GAME_SNAPSHOT_RING]; /* entry i is bytes [offset[i], offset[i] + size[i]) */
+static size_t snapshot_ring_size[GAME_SNAPSHOT_RING];
+static int snapshot_ring_head, snapshot_ring_count; /* newest entry is [head - 1], oldest [head - count] */
 
 static unsigned int rng_next(void) {
-  unsigned int x = rng_state;
+  unsigned int x = state->rng_state;
   x ^= x << 13;
   x ^= x >> 17;
   x ^= x << 5;
-  rng_state = x;
+  state->rng_state = x;
   return x;
 }
 
@@ -76,17 +396,25 @@ static float rng_float(float min_val, float max_val) {
   return min_val + (max_val - min_val) * ((float)(rng_next() % 65536u) / 65536.f);
 }
 
-static Vec3 player_position;
-static float yaw, pitch;
-static float velocity_y;
-static int is_moving, is_in_air;
-static float run_time;
-static unsigned int keys_mask;
 static int pointer_locked;
-static Projectile projectiles[MAX_PROJECTILES];
-static int projectile_count;
-static float pending_mouse_dx, pending_mouse_dy;
-static int pending_shoot;
+static unsigned char projectile_removed[MAX_PROJECTILES]; /* marked during a tick, compacted away at its end */
+#if PROJECTILE_PAIR_COLLISIONS
+static int projectile_hash_start[PROJECTILE_HASH_BUCKETS + 1]; /* bucket b owns items [start[b], start[b + 1]) */
+static int projectile_hash_items[MAX_PROJECTILES]; /* projectile indices grouped by bucket */
+static int projectile_bucket[MAX_PROJECTILES];
+#endif
+static float fixed_step = GAME_FIXED_TIMESTEP_HZ > 0 ? 1.f / (float)GAME_FIXED_TIMESTEP_HZ : 0.f; /* 0 = variable step */
+static int max_catchup_steps = GAME_MAX_CATCHUP_STEPS;
+static float fixed_step_hz = GAME_FIXED_TIMESTEP_HZ; /* as last passed to game_set_fixed_timestep, for the record header */
+static unsigned char record_log[GAME_RECORD_CAPACITY]; /* GAME_BUFFER_RECORD */
+static int record_size;
+static int recording;
+
+/* Instrumentation (GAME_STATS, stats.h): phases are traced with the tick they belong to */
+#if GAME_STATS
+static GameStats stats;
+#define STATS_STEP state->tick
+#endif
 
 static void vec3_set(Vec3* v, float x, float y, float z) {
   v->x = x; v->y = y; v->z = z;
@@ -112,30 +440,6 @@ static int aabb_overlap(float min_ax, float min_ay, float min_az,
          min_az < max_bz && max_az > min_bz;
 }
 
-static int sphere_aabb_overlap(float sx, float sy, float sz, float radius,
-                               float min_x, float min_y, float min_z,
-                               float max_x, float max_y, float max_z) {
-  float closest_x = sx < min_x ? min_x : (sx > max_x ? max_x : sx);
-  float closest_y = sy < min_y ? min_y : (sy > max_y ? max_y : sy);
-  float closest_z = sz < min_z ? min_z : (sz > max_z ? max_z : sz);
-  float dx = sx - closest_x, dy = sy - closest_y, dz = sz - closest_z;
-  return (dx*dx + dy*dy + dz*dz) < (radius * radius);
-}
-
-static int sphere_sphere_overlap(float x1, float y1, float z1, float r1,
-                                 float x2, float y2, float z2, float r2) {
-  float dx = x1 - x2, dy = y1 - y2, dz = z1 - z2;
-  float dist_sq = dx*dx + dy*dy + dz*dz;
-  float sum_r = r1 + r2;
-  return dist_sq < (sum_r * sum_r);
-}
-
-static int aabb_sphere_overlap(float min_x, float min_y, float min_z,
-                               float max_x, float max_y, float max_z,
-                               float sx, float sy, float sz, float radius) {
-  return sphere_aabb_overlap(sx, sy, sz, radius, min_x, min_y, min_z, max_x, max_y, max_z);
-}
-
 static void reflect_velocity_off_normal(float* vx, float* vy, float* vz,
                                        float nx, float ny, float nz, float bounce_coeff) {
   float dot = (*vx) * nx + (*vy) * ny + (*vz) * nz;
@@ -164,14 +468,35 @@ static void obstacle_bounds(int i, float* out_min_x, float* out_min_y, float* ou
   }
 }
 
-/* Returns 1 if obstacle n (center + type already set) would touch any obstacle with index < n. */
-static int would_new_obstacle_touch_others(int n) {
+static int obstacle_grid_coord(float v, float origin) {
+  int c = (int)floorf((v - origin) / OBSTACLE_GRID_CELL_SIZE);
+  if (c < 0) c = 0;
+  if (c >= OBSTACLE_GRID_DIM) c = OBSTACLE_GRID_DIM - 1;
+  return c;
+}
+
+static int obstacle_grid_cell(float x, float z) {
+  return obstacle_grid_coord(z, obstacle_grid_origin_z) * OBSTACLE_GRID_DIM + obstacle_grid_coord(x, obstacle_grid_origin_x);
+}
+
+/* Cell range whose obstacles may touch the XZ rect [min, max] (rect grown by the largest obstacle half extent). */
+static void obstacle_grid_range(float min_x, float min_z, float max_x, float max_z,
+                                int* cx0, int* cz0, int* cx1, int* cz1) {
+  *cx0 = obstacle_grid_coord(min_x - OBSTACLE_MAX_HALF_EXTENT, obstacle_grid_origin_x);
+  *cz0 = obstacle_grid_coord(min_z - OBSTACLE_MAX_HALF_EXTENT, obstacle_grid_origin_z);
+  *cx1 = obstacle_grid_coord(max_x + OBSTACLE_MAX_HALF_EXTENT, obstacle_grid_origin_x);
+  *cz1 = obstacle_grid_coord(max_z + OBSTACLE_MAX_HALF_EXTENT, obstacle_grid_origin_z);
+}
+
+/* Returns 1 if obstacle n (center + type already set) would touch any obstacle in [first, n), testing each
+   one (O(n - first) per try). Used by the reference placer and for the few obstacles of a streamed chunk. */
+static int would_new_obstacle_touch_range(int first, int n) {
   const float margin = OBSTACLE_PLACEMENT_GAP * 0.5f + 1e-4f; /* half-gap + epsilon for float safety */
   float n_min_x, n_min_y, n_min_z, n_max_x, n_max_y, n_max_z;
   obstacle_bounds(n, &n_min_x, &n_min_y, &n_min_z, &n_max_x, &n_max_y, &n_max_z);
   n_min_x -= margin; n_min_y -= margin; n_min_z -= margin;
   n_max_x += margin; n_max_y += margin; n_max_z += margin;
-  for (int i = 0; i < n; i++) {
+  for (int i = first; i < n; i++) {
     float i_min_x, i_min_y, i_min_z, i_max_x, i_max_y, i_max_z;
     obstacle_bounds(i, &i_min_x, &i_min_y, &i_min_z, &i_max_x, &i_max_y, &i_max_z);
     i_min_x -= margin; i_min_y -= margin; i_min_z -= margin;
@@ -183,104 +508,776 @@ static int would_new_obstacle_touch_others(int n) {
   return 0;
 }
 
+#ifdef OBSTACLE_PLACEMENT_REFERENCE
+/* Reference placer check: tests obstacle n against every obstacle with index < n (O(n) per try). */
+static int would_new_obstacle_touch_others(int n) { return would_new_obstacle_touch_range(0, n); }
+#else
+/* Returns 1 if obstacle n (center + type already set) would touch any obstacle with index < n.
+   Only obstacles already linked into the placement grid are tested, via the cells around n. */
+static int would_new_obstacle_touch_others(int n) {
+  const float margin = OBSTACLE_PLACEMENT_GAP * 0.5f + 1e-4f; /* half-gap + epsilon for float safety */
+  float n_min_x, n_min_y, n_min_z, n_max_x, n_max_y, n_max_z;
+  obstacle_bounds(n, &n_min_x, &n_min_y, &n_min_z, &n_max_x, &n_max_y, &n_max_z);
+  n_min_x -= margin; n_min_y -= margin; n_min_z -= margin;
+  n_max_x += margin; n_max_y += margin; n_max_z += margin;
+  int cx0, cz0, cx1, cz1;
+  obstacle_grid_range(n_min_x - margin, n_min_z - margin, n_max_x + margin, n_max_z + margin, &cx0, &cz0, &cx1, &cz1);
+  for (int cz = cz0; cz <= cz1; cz++) {
+    for (int cx = cx0; cx <= cx1; cx++) {
+      for (int i = placement_cell_head[cz * OBSTACLE_GRID_DIM + cx]; i >= 0; i = placement_next[i]) {
+        float i_min_x, i_min_y, i_min_z, i_max_x, i_max_y, i_max_z;
+        obstacle_bounds(i, &i_min_x, &i_min_y, &i_min_z, &i_max_x, &i_max_y, &i_max_z);
+        i_min_x -= margin; i_min_y -= margin; i_min_z -= margin;
+        i_max_x += margin; i_max_y += margin; i_max_z += margin;  /* same margin as above */
+        if (aabb_overlap(n_min_x, n_min_y, n_min_z, n_max_x, n_max_y, n_max_z,
+                         i_min_x, i_min_y, i_min_z, i_max_x, i_max_y, i_max_z))
+          return 1;
+      }
+    }
+  }
+  return 0;
+}
+#endif
+
+/* Counting sort of obstacles into cells; filling in reverse keeps each cell's indices ascending.
+   Shapes are then copied into slot order so each cell is a contiguous run for the SIMD kernels. */
+static void obstacle_grid_build(void) {
+  int resident = 0;
+  memset(obstacle_grid_start, 0, sizeof(obstacle_grid_start));
+  for (int i = 0; i < NUM_OBSTACLES; i++) {
+    if (obstacle_types[i] == GAME_OBSTACLE_TYPE_EMPTY) continue;
+    obstacle_grid_start[obstacle_grid_cell(obstacle_centers[i].x, obstacle_centers[i].z)]++;
+    resident++;
+  }
+  for (int c = 1; c < OBSTACLE_GRID_CELLS; c++) obstacle_grid_start[c] += obstacle_grid_start[c - 1];
+  obstacle_grid_start[OBSTACLE_GRID_CELLS] = resident;
+  for (int i = NUM_OBSTACLES - 1; i >= 0; i--) {
+    if (obstacle_types[i] == GAME_OBSTACLE_TYPE_EMPTY) continue;
+    obstacle_grid_items[--obstacle_grid_start[obstacle_grid_cell(obstacle_centers[i].x, obstacle_centers[i].z)]] = i;
+  }
+  for (int k = 0; k < resident; k++) {
+    int i = obstacle_grid_items[k];
+    obstacle_bounds(i, &slot_min_x[k], &slot_min_y[k], &slot_min_z[k], &slot_max_x[k], &slot_max_y[k], &slot_max_z[k]);
+    slot_center_x[k] = obstacle_centers[i].x;
+    slot_center_y[k] = obstacle_centers[i].y;
+    slot_center_z[k] = obstacle_centers[i].z;
+    slot_is_sphere[k] = obstacle_types[i] == OBSTACLE_TYPE_SPHERE ? 1.f : 0.f;
+  }
+}
+
+/* First slot of a cell holding an obstacle index > after */
+static int obstacle_grid_slot_after(int cell, int after) {
+  int k = obstacle_grid_start[cell], end = obstacle_grid_start[cell + 1];
+  while (k < end && obstacle_grid_items[k] <= after) k++;
+  return k;
+}
+
 static int would_overlap_obstacle(float px, float py, float pz) {
   float h = PLAYER_HALF_EXTENT;
   float pmin_x = px - h, pmin_y = py - h, pmin_z = pz - h;
   float pmax_x = px + h, pmax_y = py + h, pmax_z = pz + h;
-  for (int i = 0; i < NUM_OBSTACLES; i++) {
-    Vec3 c = obstacle_centers[i];
-    int t = (int)obstacle_types[i];
-    if (t == OBSTACLE_TYPE_SPHERE) {
-      if (sphere_aabb_overlap(c.x, c.y, c.z, OBSTACLE_SPHERE_RADIUS,
-                              pmin_x, pmin_y, pmin_z, pmax_x, pmax_y, pmax_z)) return 1;
+  int cx0, cz0, cx1, cz1;
+  obstacle_grid_range(pmin_x, pmin_z, pmax_x, pmax_z, &cx0, &cz0, &cx1, &cz1);
+  for (int cz = cz0; cz <= cz1; cz++) {
+    for (int cx = cx0; cx <= cx1; cx++) {
+      int cell = cz * OBSTACLE_GRID_DIM + cx;
+      int end = obstacle_grid_start[cell + 1];
+      if (np_first_box_shape_hit(&obstacle_slots, obstacle_grid_start[cell], end,
+                                 pmin_x, pmin_y, pmin_z, pmax_x, pmax_y, pmax_z) < end) return 1;
+    }
+  }
+  return 0;
+}
+
+/* Lowest obstacle index > after whose AABB overlaps the box, or -1. Callers that resolve hits one at a
+   time see them in the same order as a full scan over all obstacles. */
+static int obstacle_grid_next_box_hit(int after, float min_x, float min_y, float min_z,
+                                      float max_x, float max_y, float max_z) {
+  int best = -1;
+  int cx0, cz0, cx1, cz1;
+  obstacle_grid_range(min_x, min_z, max_x, max_z, &cx0, &cz0, &cx1, &cz1);
+  for (int cz = cz0; cz <= cz1; cz++) {
+    for (int cx = cx0; cx <= cx1; cx++) {
+      int cell = cz * OBSTACLE_GRID_DIM + cx;
+      int end = obstacle_grid_start[cell + 1];
+      int k = np_first_box_aabb_hit(&obstacle_slots, obstacle_grid_slot_after(cell, after), end,
+                                    min_x, min_y, min_z, max_x, max_y, max_z);
+      if (k < end && (best < 0 || obstacle_grid_items[k] < best)) best = obstacle_grid_items[k];
+    }
+  }
+  return best;
+}
+
+/* Same as obstacle_grid_next_box_hit for a sphere: exact sphere test against spheres, AABB test otherwise. */
+static int obstacle_grid_next_sphere_hit(int after, float sx, float sy, float sz, float radius) {
+  int best = -1;
+  int cx0, cz0, cx1, cz1;
+  obstacle_grid_range(sx - radius, sz - radius, sx + radius, sz + radius, &cx0, &cz0, &cx1, &cz1);
+  for (int cz = cz0; cz <= cz1; cz++) {
+    for (int cx = cx0; cx <= cx1; cx++) {
+      int cell = cz * OBSTACLE_GRID_DIM + cx;
+      int end = obstacle_grid_start[cell + 1];
+      int k = np_first_sphere_shape_hit(&obstacle_slots, obstacle_grid_slot_after(cell, after), end, sx, sy, sz, radius);
+      if (k < end && (best < 0 || obstacle_grid_items[k] < best)) best = obstacle_grid_items[k];
+    }
+  }
+  return best;
+}
+
+static float obstacle_center_axis(int i, int axis) {
+  return axis == 0 ? obstacle_centers[i].x : (axis == 1 ? obstacle_centers[i].y : obstacle_centers[i].z);
+}
+
+/* Reorders bvh_items[begin, end) so the k-th smallest center along axis lands at k (quickselect) */
+static void bvh_select(int begin, int end, int k, int axis) {
+  while (end - begin > 1) {
+    float pivot = obstacle_center_axis(bvh_items[(begin + end) / 2], axis);
+    int i = begin, j = end - 1;
+    while (i <= j) {
+      while (obstacle_center_axis(bvh_items[i], axis) < pivot) i++;
+      while (obstacle_center_axis(bvh_items[j], axis) > pivot) j--;
+      if (i <= j) {
+        int tmp = bvh_items[i]; bvh_items[i] = bvh_items[j]; bvh_items[j] = tmp;
+        i++; j--;
+      }
+    }
+    if (k <= j) end = j + 1;
+    else if (k >= i) begin = i;
+    else return;
+  }
+}
+
+/* Median split along the longest axis of the centers; depth stays ~log2(NUM_OBSTACLES / BVH_LEAF_SIZE). */
+static int bvh_build_node(int begin, int end) {
+  int node = bvh_node_count++;
+  BvhNode* n = &bvh_nodes[node];
+  float c_min[3] = { 1e30f, 1e30f, 1e30f }, c_max[3] = { -1e30f, -1e30f, -1e30f };
+  n->min_x = n->min_y = n->min_z = 1e30f;
+  n->max_x = n->max_y = n->max_z = -1e30f;
+  for (int k = begin; k < end; k++) {
+    int i = bvh_items[k];
+    float min_x, min_y, min_z, max_x, max_y, max_z;
+    obstacle_bounds(i, &min_x, &min_y, &min_z, &max_x, &max_y, &max_z);
+    n->min_x = fminf(n->min_x, min_x); n->min_y = fminf(n->min_y, min_y); n->min_z = fminf(n->min_z, min_z);
+    n->max_x = fmaxf(n->max_x, max_x); n->max_y = fmaxf(n->max_y, max_y); n->max_z = fmaxf(n->max_z, max_z);
+    for (int a = 0; a < 3; a++) {
+      float c = obstacle_center_axis(i, a);
+      c_min[a] = fminf(c_min[a], c);
+      c_max[a] = fmaxf(c_max[a], c);
+    }
+  }
+  if (end - begin <= BVH_LEAF_SIZE) {
+    n->offset = begin;
+    n->count = end - begin;
+    return node;
+  }
+  int axis = 0;
+  if (c_max[1] - c_min[1] > c_max[axis] - c_min[axis]) axis = 1;
+  if (c_max[2] - c_min[2] > c_max[axis] - c_min[axis]) axis = 2;
+  int mid = (begin + end) / 2;
+  bvh_select(begin, end, mid, axis);
+  n->count = 0;
+  bvh_build_node(begin, mid);
+  n->offset = bvh_build_node(mid, end);
+  return node;
+}
+
+static void obstacle_bvh_build(void) {
+  int count = 0;
+  for (int i = 0; i < NUM_OBSTACLES; i++)
+    if (obstacle_types[i] != GAME_OBSTACLE_TYPE_EMPTY) bvh_items[count++] = i;
+  bvh_node_count = 0;
+  if (count > 0) bvh_build_node(0, count);
+}
+
+typedef struct {
+  Vec3 origin, dir, inv_dir; /* dir normalized */
+} Ray;
+
+/* Slab test; returns 1 and the entry distance (clamped to 0) if the ray meets the box before t_max */
+static int ray_aabb(const Ray* r, float min_x, float min_y, float min_z,
+                    float max_x, float max_y, float max_z, float t_max, float* t_enter) {
+  float tx0 = (min_x - r->origin.x) * r->inv_dir.x, tx1 = (max_x - r->origin.x) * r->inv_dir.x;
+  float ty0 = (min_y - r->origin.y) * r->inv_dir.y, ty1 = (max_y - r->origin.y) * r->inv_dir.y;
+  float tz0 = (min_z - r->origin.z) * r->inv_dir.z, tz1 = (max_z - r->origin.z) * r->inv_dir.z;
+  float t0 = fmaxf(fmaxf(fminf(tx0, tx1), fminf(ty0, ty1)), fmaxf(fminf(tz0, tz1), 0.f));
+  float t1 = fminf(fminf(fmaxf(tx0, tx1), fmaxf(ty0, ty1)), fminf(fmaxf(tz0, tz1), t_max));
+  *t_enter = t0;
+  return t0 <= t1;
+}
+
+/* Ray against one obstacle's collision shape (sphere, else its AABB, matching game_update).
+   A ray starting inside a shape hits it at distance 0 with the normal facing back along the ray. */
+static int ray_obstacle(const Ray* r, int i, float t_max, float* t_out, Vec3* n_out) {
+  Vec3 c = obstacle_centers[i];
+  if (obstacle_types[i] == OBSTACLE_TYPE_SPHERE) {
+    float ox = r->origin.x - c.x, oy = r->origin.y - c.y, oz = r->origin.z - c.z;
+    float b = ox * r->dir.x + oy * r->dir.y + oz * r->dir.z;
+    float cc = ox * ox + oy * oy + oz * oz - OBSTACLE_SPHERE_RADIUS * OBSTACLE_SPHERE_RADIUS;
+    if (cc <= 0.f) {
+      *t_out = 0.f;
+      vec3_set(n_out, -r->dir.x, -r->dir.y, -r->dir.z);
+      return 1;
+    }
+    float disc = b * b - cc;
+    if (b > 0.f || disc < 0.f) return 0;
+    float t = -b - sqrtf(disc);
+    if (t > t_max) return 0;
+    *t_out = t;
+    vec3_set(n_out, (ox + r->dir.x * t) / OBSTACLE_SPHERE_RADIUS, (oy + r->dir.y * t) / OBSTACLE_SPHERE_RADIUS,
+             (oz + r->dir.z * t) / OBSTACLE_SPHERE_RADIUS);
+    return 1;
+  }
+  float min_v[3], max_v[3];
+  obstacle_bounds(i, &min_v[0], &min_v[1], &min_v[2], &max_v[0], &max_v[1], &max_v[2]);
+  const float o[3] = { r->origin.x, r->origin.y, r->origin.z };
+  const float inv[3] = { r->inv_dir.x, r->inv_dir.y, r->inv_dir.z };
+  float t0 = -1e30f, t1 = t_max;
+  int axis = -1;
+  for (int a = 0; a < 3; a++) {
+    float ta = (min_v[a] - o[a]) * inv[a], tb = (max_v[a] - o[a]) * inv[a];
+    if (ta != ta) ta = -1e30f; /* origin on a slab plane with zero direction: inside that slab */
+    if (tb != tb) tb = 1e30f;
+    float near_t = fminf(ta, tb), far_t = fmaxf(ta, tb);
+    if (near_t > t0) { t0 = near_t; axis = a; }
+    if (far_t < t1) t1 = far_t;
+  }
+  if (t0 > t1 || t1 < 0.f) return 0;
+  if (t0 <= 0.f) {
+    *t_out = 0.f;
+    vec3_set(n_out, -r->dir.x, -r->dir.y, -r->dir.z);
+    return 1;
+  }
+  *t_out = t0;
+  vec3_set(n_out, 0.f, 0.f, 0.f);
+  float sign = inv[axis] > 0.f ? -1.f : 1.f;
+  if (axis == 0) n_out->x = sign; else if (axis == 1) n_out->y = sign; else n_out->z = sign;
+  return 1;
+}
+
+/* Closest obstacle hit before t_max (front-to-back traversal), or -1 */
+static int obstacle_bvh_raycast(const Ray* r, float t_max, float* t_out, Vec3* n_out) {
+  int best = -1;
+  int stack[BVH_STACK_SIZE];
+  int sp = 0;
+  float t;
+  if (bvh_node_count == 0) return -1;
+  const BvhNode* root = &bvh_nodes[0];
+  if (!ray_aabb(r, root->min_x, root->min_y, root->min_z, root->max_x, root->max_y, root->max_z, t_max, &t)) return -1;
+  int node = 0;
+  for (;;) {
+    const BvhNode* n = &bvh_nodes[node];
+    if (n->count > 0) {
+      for (int k = n->offset; k < n->offset + n->count; k++) {
+        Vec3 normal;
+        if (ray_obstacle(r, bvh_items[k], t_max, &t, &normal) && (best < 0 || t < t_max)) {
+          best = bvh_items[k];
+          t_max = t;
+          *t_out = t;
+          *n_out = normal;
+        }
+      }
     } else {
-      float o_min_x, o_min_y, o_min_z, o_max_x, o_max_y, o_max_z;
-      obstacle_bounds(i, &o_min_x, &o_min_y, &o_min_z, &o_max_x, &o_max_y, &o_max_z);
-      if (aabb_overlap(pmin_x, pmin_y, pmin_z, pmax_x, pmax_y, pmax_z,
-                      o_min_x, o_min_y, o_min_z, o_max_x, o_max_y, o_max_z)) return 1;
+      const BvhNode* a = &bvh_nodes[node + 1];
+      const BvhNode* b = &bvh_nodes[n->offset];
+      float ta, tb;
+      int hit_a = ray_aabb(r, a->min_x, a->min_y, a->min_z, a->max_x, a->max_y, a->max_z, t_max, &ta);
+      int hit_b = ray_aabb(r, b->min_x, b->min_y, b->min_z, b->max_x, b->max_y, b->max_z, t_max, &tb);
+      if (hit_a && hit_b) {
+        int near_node = ta <= tb ? node + 1 : n->offset;
+        stack[sp++] = ta <= tb ? n->offset : node + 1;
+        node = near_node;
+        continue;
+      }
+      if (hit_a) { node = node + 1; continue; }
+      if (hit_b) { node = n->offset; continue; }
+    }
+    /* Pop, skipping subtrees that start beyond the closest hit so far */
+    for (;;) {
+      if (sp == 0) return best;
+      node = stack[--sp];
+      n = &bvh_nodes[node];
+      if (ray_aabb(r, n->min_x, n->min_y, n->min_z, n->max_x, n->max_y, n->max_z, t_max, &t)) break;
     }
   }
+}
+
+/* First point along the ray below terrain_height, or 0 if none before t_max. Steps are sized so the ray
+   cannot cross a surface with slope <= TERRAIN_MAX_SLOPE (never shorter than TERRAIN_RAY_MIN_STEP), then
+   the crossing is refined by bisection. */
+static int terrain_raycast(const Ray* r, float t_max, float* t_out) {
+  float t0 = 0.f, t1 = t_max;
+  /* Only the slab of heights the terrain can reach matters */
+  if (fabsf(r->dir.y) > 1e-8f) {
+    float ta = (TERRAIN_MAX_ABS_HEIGHT - r->origin.y) / r->dir.y;
+    float tb = (-TERRAIN_MAX_ABS_HEIGHT - r->origin.y) / r->dir.y;
+    t0 = fmaxf(t0, fminf(ta, tb));
+    t1 = fminf(t1, fmaxf(ta, tb));
+  } else if (fabsf(r->origin.y) > TERRAIN_MAX_ABS_HEIGHT) {
+    return 0;
+  }
+  if (t0 > t1) return 0;
+  float horizontal = sqrtf(r->dir.x * r->dir.x + r->dir.z * r->dir.z);
+  float closing_rate = fmaxf(-r->dir.y, 0.f) + TERRAIN_MAX_SLOPE * horizontal; /* max drop of (ray y - terrain) per unit t */
+  float prev_t = t0;
+  float t = t0;
+  for (;;) {
+    float gap = r->origin.y + r->dir.y * t - terrain_height(r->origin.x + r->dir.x * t, r->origin.z + r->dir.z * t);
+    if (gap <= 0.f) break;
+    if (t >= t1) return 0;
+    prev_t = t;
+    float step = closing_rate > 1e-6f ? gap / closing_rate : t1 - t;
+    t = fminf(t + fmaxf(step, TERRAIN_RAY_MIN_STEP), t1);
+  }
+  if (t == t0) {
+    *t_out = t0;
+    return 1;
+  }
+  float lo = prev_t, hi = t;
+  for (int k = 0; k < 16; k++) {
+    float mid = 0.5f * (lo + hi);
+    float gap = r->origin.y + r->dir.y * mid - terrain_height(r->origin.x + r->dir.x * mid, r->origin.z + r->dir.z * mid);
+    if (gap <= 0.f) hi = mid; else lo = mid;
+  }
+  *t_out = hi;
+  return 1;
+}
+
+static Vec3 compute_front(void) {
+  float cp = cosf(state->pitch), sp = sinf(state->pitch), cy = cosf(state->yaw), sy = sinf(state->yaw);
+  Vec3 front = { cp * sy, sp, cp * cy };
+  vec3_normalize(&front);
+  return front;
+}
+
+/* Copy the values the renderer needs every frame into frame_block (one contiguous read from JS). */
+static void frame_block_publish(void) {
+  world->frame_block[GAME_FRAME_PLAYER_X] = state->player_position.x;
+  world->frame_block[GAME_FRAME_PLAYER_Y] = state->player_position.y;
+  world->frame_block[GAME_FRAME_PLAYER_Z] = state->player_position.z;
+  world->frame_block[GAME_FRAME_YAW] = state->yaw;
+  world->frame_block[GAME_FRAME_PITCH] = state->pitch;
+  world->frame_block[GAME_FRAME_FRONT_X] = world->front_dir.x;
+  world->frame_block[GAME_FRAME_FRONT_Y] = world->front_dir.y;
+  world->frame_block[GAME_FRAME_FRONT_Z] = world->front_dir.z;
+  world->frame_block[GAME_FRAME_IS_MOVING] = (float)state->is_moving;
+  world->frame_block[GAME_FRAME_IS_IN_AIR] = (float)state->is_in_air;
+  world->frame_block[GAME_FRAME_RUN_TIME] = state->run_time;
+  world->frame_block[GAME_FRAME_PROJECTILE_COUNT] = (float)state->projectile_count;
+  world->frame_block[GAME_FRAME_PREV_PLAYER_X] = state->prev_player_position.x;
+  world->frame_block[GAME_FRAME_PREV_PLAYER_Y] = state->prev_player_position.y;
+  world->frame_block[GAME_FRAME_PREV_PLAYER_Z] = state->prev_player_position.z;
+  world->frame_block[GAME_FRAME_ALPHA] = state->interpolation_alpha;
+  world->frame_block[GAME_FRAME_TICKS] = (float)world->ticks_last_update;
+  world->frame_block[GAME_FRAME_WORLD_VERSION] = (float)world_version;
+}
+
+#define PLACEMENT_MAX_ATTEMPTS 600
+/* Generates obstacle n somewhere in the XZ rect [min, max], away from the spawn point and the obstacles
+   before it: [first, n) when first >= 0, otherwise whatever is linked into the placement grid.
+   Draws from rng_state in a fixed order, so the same seed always yields the same obstacle. */
+static void obstacle_generate(int n, float min_x, float max_x, float min_z, float max_z, int first) {
+  const float spawn_radius_sq = 36.f;
+  int attempts = 0;
+  for (;;) {
+    if (attempts >= PLACEMENT_MAX_ATTEMPTS) break;
+    float x = rng_float(min_x, max_x);
+    float z = rng_float(min_z, max_z);
+    float dx = x - 0.f, dz = z - 3.f;
+    if (dx * dx + dz * dz < spawn_radius_sq) { attempts++; continue; }
+    obstacle_centers[n].x = x;
+    obstacle_centers[n].z = z;
+    obstacle_types[n] = (unsigned char)(rng_next() % 3); /* 0=cube, 1=sphere, 2=triangle */
+    /* Place obstacle so entire base clears terrain (sample under footprint to avoid clipping) */
+    {
+      float bottom_y = terrain_height_under_footprint(x, z, OBSTACLE_HALF_EXTENT);
+      int t = (int)obstacle_types[n];
+      if (t == OBSTACLE_TYPE_TRIANGLE)
+        obstacle_centers[n].y = bottom_y + OBSTACLE_TRIANGLE_HALF_Y;
+      else
+        obstacle_centers[n].y = bottom_y + OBSTACLE_HALF_EXTENT; /* cube or sphere */
+    }
+    if (!(first >= 0 ? would_new_obstacle_touch_range(first, n) : would_new_obstacle_touch_others(n))) break; /* gap OK */
+    attempts++;
+  }
+  obstacle_rotations[n] = rng_float(0.f, 6.28318530718f);
+  obstacle_rotation_speeds[n] = rng_float(0.5f, 3.f);
+  {
+    unsigned int r = (unsigned int)(rng_float(0.f, 255.f));
+    unsigned int g = (unsigned int)(rng_float(0.f, 255.f));
+    unsigned int b = (unsigned int)(rng_float(0.f, 255.f));
+    obstacle_colors[n] = (r << 16) | (g << 8) | b;
+  }
+}
+
+#if WORLD_STREAMING
+/* Per-chunk rng seed: a hash of (OBSTACLE_PLACEMENT_SEED, cx, cz), never 0 (xorshift fixed point) */
+static unsigned int world_chunk_seed(int cx, int cz) {
+  unsigned int h = OBSTACLE_PLACEMENT_SEED;
+  h ^= (unsigned int)cx * 0x9E3779B1u;
+  h = (h ^ (h >> 16)) * 0x85EBCA6Bu;
+  h ^= (unsigned int)cz * 0xC2B2AE35u;
+  h = (h ^ (h >> 13)) * 0x27D4EB2Fu;
+  h ^= h >> 16;
+  return h ? h : 1u;
+}
+
+/* Fills cache slot with chunk (cx, cz). Obstacles stay WORLD_CHUNK_INSET inside the chunk so they never
+   touch a neighbouring chunk's, which keeps every chunk a function of its coordinates alone. */
+static void world_chunk_generate(int slot, int cx, int cz) {
+  int first = slot * WORLD_CHUNK_OBSTACLES;
+  float x0 = (float)cx * WORLD_CHUNK_SIZE, z0 = (float)cz * WORLD_CHUNK_SIZE;
+  state->rng_state = world_chunk_seed(cx, cz);
+  for (int n = first; n < first + WORLD_CHUNK_OBSTACLES; n++)
+    obstacle_generate(n, x0 + WORLD_CHUNK_INSET, x0 + WORLD_CHUNK_SIZE - WORLD_CHUNK_INSET,
+                      z0 + WORLD_CHUNK_INSET, z0 + WORLD_CHUNK_SIZE - WORLD_CHUNK_INSET, first);
+  state->chunk_slot_x[slot] = cx;
+  state->chunk_slot_z[slot] = cz;
+  state->chunk_slot_used[slot] = 1;
+}
+
+static void world_chunk_evict(int slot) {
+  state->chunk_slot_used[slot] = 0;
+  for (int n = slot * WORLD_CHUNK_OBSTACLES; n < (slot + 1) * WORLD_CHUNK_OBSTACLES; n++)
+    obstacle_types[n] = GAME_OBSTACLE_TYPE_EMPTY;
+}
+
+static int world_chunk_resident(int cx, int cz) {
+  for (int slot = 0; slot < WORLD_CHUNK_SLOTS; slot++)
+    if (state->chunk_slot_used[slot] && state->chunk_slot_x[slot] == cx && state->chunk_slot_z[slot] == cz) return 1;
   return 0;
 }
 
-void game_init(void) {
+static void world_stream_reset(void) {
+  for (int slot = 0; slot < WORLD_CHUNK_SLOTS; slot++) world_chunk_evict(slot);
+  world_version = 0;
+}
+
+/* Re-centers the collision grid on the resident window and rebuilds it and the BVH */
+static void world_stream_rebuild(void) {
+  obstacle_grid_origin_x = (float)(state->world_center_cx - WORLD_CHUNK_RADIUS) * WORLD_CHUNK_SIZE;
+  obstacle_grid_origin_z = (float)(state->world_center_cz - WORLD_CHUNK_RADIUS) * WORLD_CHUNK_SIZE;
+  obstacle_grid_build();
+  obstacle_bvh_build();
+  world_version++;
+}
+
+/* When the player enters a new chunk: evict chunks outside the (2R + 1)^2 window around it, generate the
+   missing ones into free slots (lowest first), and re-center the collision grid and BVH on the window. */
+static void world_stream_update(void) {
+  int pcx = (int)floorf(state->player_position.x / WORLD_CHUNK_SIZE);
+  int pcz = (int)floorf(state->player_position.z / WORLD_CHUNK_SIZE);
+  if (world_version > 0 && pcx == state->world_center_cx && pcz == state->world_center_cz) return;
+  state->world_center_cx = pcx;
+  state->world_center_cz = pcz;
+  for (int slot = 0; slot < WORLD_CHUNK_SLOTS; slot++) {
+    if (state->chunk_slot_used[slot] && (abs(state->chunk_slot_x[slot] - pcx) > WORLD_CHUNK_RADIUS ||
+                                  abs(state->chunk_slot_z[slot] - pcz) > WORLD_CHUNK_RADIUS))
+      world_chunk_evict(slot);
+  }
+  int free_slot = 0;
+  for (int cz = pcz - WORLD_CHUNK_RADIUS; cz <= pcz + WORLD_CHUNK_RADIUS; cz++) {
+    for (int cx = pcx - WORLD_CHUNK_RADIUS; cx <= pcx + WORLD_CHUNK_RADIUS; cx++) {
+      if (world_chunk_resident(cx, cz)) continue;
+      while (state->chunk_slot_used[free_slot]) free_slot++;
+      world_chunk_generate(free_slot, cx, cz);
+#if !OBSTACLE_ROTATION_ANALYTIC
+      memcpy(&state->obstacle_rotations[free_slot * WORLD_CHUNK_OBSTACLES],
+             &obstacle_rotations[free_slot * WORLD_CHUNK_OBSTACLES], WORLD_CHUNK_OBSTACLES * sizeof(float));
+#endif
+    }
+  }
+  world_stream_rebuild();
+}
+
+/* After game_restore: regenerate the slots whose chunk differs from what the obstacle arrays hold (old_*),
+   keeping the restored rng_state, and rebuild the grid and BVH if anything changed. */
+static void world_stream_resync(const int* old_x, const int* old_z, const unsigned char* old_used) {
+  unsigned int rng = state->rng_state;
+  int changed = 0;
+  for (int slot = 0; slot < WORLD_CHUNK_SLOTS; slot++) {
+    int used = state->chunk_slot_used[slot];
+    if (used == old_used[slot] &&
+        (!used || (state->chunk_slot_x[slot] == old_x[slot] && state->chunk_slot_z[slot] == old_z[slot]))) continue;
+    if (used) world_chunk_generate(slot, state->chunk_slot_x[slot], state->chunk_slot_z[slot]);
+    else world_chunk_evict(slot);
+    changed = 1;
+  }
+  state->rng_state = rng;
+  if (changed) world_stream_rebuild();
+}
+#endif
+
+/* Makes w the active world. Streaming worlds share one set of obstacle slots, so the chunks in which the two
+   windows differ are regenerated, the same way game_restore does. */
+static void world_select(GameWorld* w) {
+  if (w == world) return;
+#if WORLD_STREAMING
+  const GameState* prev = state;
+  world = w;
+  state = &w->state;
+  world_stream_resync(prev->chunk_slot_x, prev->chunk_slot_z, prev->chunk_slot_used);
+#else
+  world = w;
+  state = &w->state;
+#endif
+}
+
+/* Puts the active world at the start of a match. The fixed obstacle layout is placed again when rebuild is
+   set (or nothing has been placed yet); otherwise the shared copy is kept and the world's rng continues
+   from where placement left it, exactly as after a full game_init. Streaming worlds always regenerate
+   their window around the spawn point. */
+static void world_reset(int rebuild) {
+#if TERRAIN_HEIGHTFIELD
+  if (!terrain_heightfield_built) terrain_heightfield_build();
+#endif
   float px = 0.f, pz = 3.f;
-  player_position.x = px;
-  player_position.z = pz;
-  player_position.y = terrain_height(px, pz) + PLAYER_HALF_EXTENT;
-  yaw = 0.f;
-  pitch = 0.f;
-  velocity_y = 0.f;
-  is_moving = 0;
-  is_in_air = 0;
-  run_time = 0.f;
-  keys_mask = 0;
-  pointer_locked = 0;
-  projectile_count = 0;
-  pending_mouse_dx = 0.f;
-  pending_mouse_dy = 0.f;
-  pending_shoot = 0;
+  state->version = GAME_STATE_VERSION;
+  state->size = (unsigned int)sizeof(GameState);
+  state->player_position.x = px;
+  state->player_position.z = pz;
+  state->player_position.y = terrain_height(px, pz) + PLAYER_HALF_EXTENT;
+  state->yaw = 0.f;
+  state->pitch = 0.f;
+  state->velocity_y = 0.f;
+  state->is_moving = 0;
+  state->is_in_air = 0;
+  state->run_time = 0.f;
+  state->sim_time = 0.0;
+  state->tick = 0;
+  world->keys_mask = 0;
+  state->projectile_count = 0;
+  world->pending_mouse_dx = 0.f;
+  world->pending_mouse_dy = 0.f;
+  world->pending_shoot = 0;
+  state->step_accumulator = 0.0;
+  state->interpolation_alpha = 1.f;
+  world->ticks_last_update = 0;
 
-  rng_state = 12345u;
-  {
+#if WORLD_STREAMING
+  (void)rebuild;
+  world_stream_reset();
+  world_stream_update();
+#else
+  if (!rebuild && world_version > 0) {
+    state->rng_state = placement_rng_end;
+  } else {
     const float span = FLOOR_HALF_SIZE - 2.f;
-    const float spawn_radius_sq = 36.f;
-    int n = 0;
-#define PLACEMENT_MAX_ATTEMPTS 600
-    while (n < NUM_OBSTACLES) {
-      int attempts = 0;
-      for (;;) {
-        if (attempts >= PLACEMENT_MAX_ATTEMPTS) break;
-        float x = rng_float(-span, span);
-        float z = rng_float(-span, span);
-        float dx = x - 0.f, dz = z - 3.f;
-        if (dx * dx + dz * dz < spawn_radius_sq) { attempts++; continue; }
-        obstacle_centers[n].x = x;
-        obstacle_centers[n].z = z;
-        obstacle_types[n] = (unsigned char)(rng_next() % 3); /* 0=cube, 1=sphere, 2=triangle */
-        /* Place obstacle so entire base clears terrain (sample under footprint to avoid clipping) */
-        {
-          float bottom_y = terrain_height_under_footprint(x, z, OBSTACLE_HALF_EXTENT);
-          int t = (int)obstacle_types[n];
-          if (t == OBSTACLE_TYPE_TRIANGLE)
-            obstacle_centers[n].y = bottom_y + OBSTACLE_TRIANGLE_HALF_Y;
-          else
-            obstacle_centers[n].y = bottom_y + OBSTACLE_HALF_EXTENT; /* cube or sphere */
+    state->rng_state = OBSTACLE_PLACEMENT_SEED;
+    for (int c = 0; c < OBSTACLE_GRID_CELLS; c++) placement_cell_head[c] = -1;
+    for (int n = 0; n < NUM_OBSTACLES; n++) {
+      obstacle_generate(n, -span, span, -span, span, -1);
+      int c = obstacle_grid_cell(obstacle_centers[n].x, obstacle_centers[n].z);
+      placement_next[n] = placement_cell_head[c];
+      placement_cell_head[c] = n;
+    }
+    obstacle_grid_build();
+    obstacle_bvh_build();
+    world_version = 1;
+    placement_rng_end = state->rng_state;
+  }
+#endif
+#if !OBSTACLE_ROTATION_ANALYTIC
+  memcpy(state->obstacle_rotations, obstacle_rotations, sizeof(obstacle_rotations));
+#endif
+  state->prev_player_position = state->player_position;
+  world->front_dir = compute_front();
+  frame_block_publish();
+}
+
+void game_init(void) {
+  world_select(&default_world);
+  pointer_locked = 0;
+  snapshot_ring_head = snapshot_ring_count = 0;
+  recording = 0;
+#if GAME_STATS
+  memset(&stats, 0, sizeof(stats));
+#endif
+  world_reset(1);
+}
+
+#if PROJECTILE_PAIR_COLLISIONS
+static int projectile_hash_cell(float v) { return (int)floorf(v / PROJECTILE_HASH_CELL_SIZE); }
+
+/* Rows of cells along X are hashed by (cy, cz) and laid out consecutively, so the three X neighbours of a
+   cell are one contiguous bucket range. */
+static int projectile_hash_bucket(int cx, int cy, int cz) {
+  unsigned int row = (unsigned int)cy * 19349663u ^ (unsigned int)cz * 83492791u;
+  return (int)((row + (unsigned int)cx) & (PROJECTILE_HASH_BUCKETS - 1));
+}
+
+/* Counting sort of live projectiles into hash buckets */
+static void projectile_hash_build(void) {
+  memset(projectile_hash_start, 0, sizeof(projectile_hash_start));
+  for (int i = 0; i < state->projectile_count; i++) {
+    if (projectile_removed[i]) continue;
+    Vec3 p = state->projectile_positions[i];
+    projectile_bucket[i] = projectile_hash_bucket(projectile_hash_cell(p.x), projectile_hash_cell(p.y), projectile_hash_cell(p.z));
+    projectile_hash_start[projectile_bucket[i]]++;
+  }
+  for (int b = 1; b <= PROJECTILE_HASH_BUCKETS; b++) projectile_hash_start[b] += projectile_hash_start[b - 1];
+  for (int i = state->projectile_count - 1; i >= 0; i--) {
+    if (projectile_removed[i]) continue;
+    projectile_hash_items[--projectile_hash_start[projectile_bucket[i]]] = i;
+  }
+}
+
+/* Equal-mass bounce between two overlapping projectiles: push apart along the contact normal and
+   exchange the approaching part of their velocities, scaled by the bounce coefficient. */
+static void projectile_pair_bounce(int i, int j) {
+  Vec3* pi = &state->projectile_positions[i];
+  Vec3* pj = &state->projectile_positions[j];
+  float dx = pj->x - pi->x, dy = pj->y - pi->y, dz = pj->z - pi->z;
+  float dist_sq = dx*dx + dy*dy + dz*dz;
+  float contact = 2.f * PROJECTILE_RADIUS;
+  if (dist_sq >= contact * contact) return;
+  STATS_ADD(pair_hits, 1);
+  float len = sqrtf(dist_sq);
+  float nx = 0.f, ny = 1.f, nz = 0.f;
+  if (len > 1e-6f) { nx = dx/len; ny = dy/len; nz = dz/len; }
+  float half_overlap = 0.5f * (contact - len);
+  pi->x -= nx * half_overlap; pi->y -= ny * half_overlap; pi->z -= nz * half_overlap;
+  pj->x += nx * half_overlap; pj->y += ny * half_overlap; pj->z += nz * half_overlap;
+  Vec3* vi = &state->projectile_velocities[i];
+  Vec3* vj = &state->projectile_velocities[j];
+  float approach = (vi->x - vj->x) * nx + (vi->y - vj->y) * ny + (vi->z - vj->z) * nz;
+  if (approach <= 0.f) return;
+  float impulse = 0.5f * (1.f + PROJECTILE_BOUNCE_COEFFICIENT) * approach;
+  vi->x -= nx * impulse; vi->y -= ny * impulse; vi->z -= nz * impulse;
+  vj->x += nx * impulse; vj->y += ny * impulse; vj->z += nz * impulse;
+}
+
+static void projectile_collide_range(int i, int begin, int end) {
+  for (int k = begin; k < end; k++) {
+    int j = projectile_hash_items[k];
+    if (j > i) {
+      STATS_ADD(pair_tests, 1);
+      projectile_pair_bounce(i, j);
+    }
+  }
+}
+
+/* Resolves touching pairs (i < j) in index order against the 27 cells around i (9 rows of 3). When cells
+   share a bucket a pair can be offered twice; the repeat is a no-op once the pair is separated. */
+static void projectile_pairs_collide(void) {
+  projectile_hash_build();
+  for (int i = 0; i < state->projectile_count; i++) {
+    if (projectile_removed[i]) continue;
+    Vec3 p = state->projectile_positions[i];
+    int cx = projectile_hash_cell(p.x), cy = projectile_hash_cell(p.y), cz = projectile_hash_cell(p.z);
+    for (int oz = -1; oz <= 1; oz++) {
+      for (int oy = -1; oy <= 1; oy++) {
+        int b = projectile_hash_bucket(cx - 1, cy + oy, cz + oz);
+        if (b + 3 <= PROJECTILE_HASH_BUCKETS) {
+          projectile_collide_range(i, projectile_hash_start[b], projectile_hash_start[b + 3]);
+        } else { /* row wraps around the table */
+          projectile_collide_range(i, projectile_hash_start[b], projectile_hash_start[PROJECTILE_HASH_BUCKETS]);
+          projectile_collide_range(i, projectile_hash_start[0], projectile_hash_start[b + 3 - PROJECTILE_HASH_BUCKETS]);
         }
-        if (!would_new_obstacle_touch_others(n)) break; /* gap OK */
-        attempts++;
-      }
-      obstacle_rotations[n] = rng_float(0.f, 6.28318530718f);
-      obstacle_rotation_speeds[n] = rng_float(0.5f, 3.f);
-      {
-        unsigned int r = (unsigned int)(rng_float(0.f, 255.f));
-        unsigned int g = (unsigned int)(rng_float(0.f, 255.f));
-        unsigned int b = (unsigned int)(rng_float(0.f, 255.f));
-        obstacle_colors[n] = (r << 16) | (g << 8) | b;
       }
-      n++;
     }
   }
 }
+#endif
 
-void game_update(float dt, unsigned int keys, float mouse_dx, float mouse_dy, int shoot) {
-  keys_mask = keys;
-  pending_mouse_dx = mouse_dx;
-  pending_mouse_dy = mouse_dy;
-  pending_shoot = shoot;
+/* Drops projectiles marked removed in one stable pass (survivors keep their relative order). */
+static void projectile_compact(void) {
+  int n = 0;
+  for (int i = 0; i < state->projectile_count; i++) {
+    if (projectile_removed[i]) continue;
+    if (n != i) {
+      state->projectile_positions[n] = state->projectile_positions[i];
+      state->projectile_velocities[n] = state->projectile_velocities[i];
+      state->projectile_prev_positions[n] = state->projectile_prev_positions[i];
+    }
+    n++;
+  }
+  STATS_ADD(removals, state->projectile_count - n);
+  state->projectile_count = n;
+}
 
-  if (dt > 0.1f) dt = 0.1f;
+#if !OBSTACLE_ROTATION_ANALYTIC
+static void obstacle_rotate_range(void* ctx, int begin, int end, int worker) {
+  float dt = *(const float*)ctx;
+  (void)worker;
+  float* rotations = state->obstacle_rotations;
+  for (int i = begin; i < end; i++) {
+    rotations[i] += obstacle_rotation_speeds[i] * dt;
+    if (rotations[i] > 6.28318530718f) {
+      rotations[i] -= 6.28318530718f;
+    }
+  }
+}
+#endif
 
-  /* Mouse */
-  yaw -= mouse_dx * MOUSE_SENSITIVITY;
-  pitch -= mouse_dy * MOUSE_SENSITIVITY;
-  if (pitch > MAX_PITCH_RAD) pitch = MAX_PITCH_RAD;
-  if (pitch < -MAX_PITCH_RAD) pitch = -MAX_PITCH_RAD;
+/* Jobs body: moves projectiles [begin, end), bounces them off terrain and obstacles and marks removals.
+   Each projectile only reads the world and writes its own slots, so chunks can run in any order. */
+static void projectile_update_range(void* ctx, int begin, int end, int worker) {
+  float dt = *(const float*)ctx;
+  (void)worker;
+  for (int i = begin; i < end; i++) {
+    Vec3* p = &state->projectile_positions[i];
+    Vec3* v = &state->projectile_velocities[i];
+    p->x += v->x * dt;
+    p->y += v->y * dt;
+    p->z += v->z * dt;
 
-  /* Front vector (normalized) */
-  float cp = cosf(pitch), sp = sinf(pitch), cy = cosf(yaw), sy = sinf(yaw);
-  Vec3 front = { cp * sy, sp, cp * cy };
-  vec3_normalize(&front);
+    int remove = 0;
+    float dx = p->x - state->player_position.x, dy = p->y - state->player_position.y, dz = p->z - state->player_position.z;
+    if (dx*dx + dy*dy + dz*dz > PROJECTILE_MAX_DIST * PROJECTILE_MAX_DIST) remove = 1;
+    if (p->y < -10.f) remove = 1; // Remove if too far below floor
+    
+    float pr = PROJECTILE_RADIUS;
+    float floor_top = terrain_height(p->x, p->z);
+    
+    /* Floor (terrain) collision and bounce */
+    if (p->y - pr < floor_top) {
+      p->y = floor_top + pr;
+      v->y = -v->y * PROJECTILE_BOUNCE_COEFFICIENT; // Bounce with energy loss
+      // Small friction on floor
+      v->x *= 0.95f;
+      v->z *= 0.95f;
+    }
+    
+    // Obstacle collision and bounce (grid candidates, visited in index order)
+    for (int j = -1; !remove;) {
+      j = obstacle_grid_next_sphere_hit(j, p->x, p->y, p->z, pr);
+      STATS_ADD(obstacle_queries, 1);
+      if (j < 0) break;
+      STATS_ADD(obstacle_hits, 1);
+      Vec3 c = obstacle_centers[j];
+      int t = (int)obstacle_types[j];
+      float nx = 0.f, ny = 1.f, nz = 0.f;
+      float dx = p->x - c.x, dy = p->y - c.y, dz = p->z - c.z;
+      float len = sqrtf(dx*dx + dy*dy + dz*dz);
+      if (len > 1e-6f) { nx = dx/len; ny = dy/len; nz = dz/len; }
+
+      float obs_r = (t == OBSTACLE_TYPE_SPHERE) ? OBSTACLE_SPHERE_RADIUS : OBSTACLE_HALF_EXTENT;
+      float overlap = pr + obs_r - len;
+      if (overlap > 0.f && len > 1e-6f) {
+        p->x += nx * overlap;
+        p->y += ny * overlap;
+        p->z += nz * overlap;
+      }
+      reflect_velocity_off_normal(&v->x, &v->y, &v->z, nx, ny, nz, PROJECTILE_BOUNCE_COEFFICIENT);
+      float speed_sq = v->x*v->x + v->y*v->y + v->z*v->z;
+      if (speed_sq < 1.f) remove = 1;
+    }
+    projectile_removed[i] = (unsigned char)remove;
+  }
+}
+
+/* One simulation step of dt seconds with the latched input (keys_mask, pending_shoot, front_dir). */
+static void game_tick(float dt) {
+  unsigned int keys = world->keys_mask;
+  Vec3 front = world->front_dir;
+  state->sim_time += (double)dt;
+  state->tick++;
+  STATS_ADD(ticks, 1);
+  STATS_TIMER(move_start);
+
+  state->prev_player_position = state->player_position;
+  memcpy(state->projectile_prev_positions, state->projectile_positions, (size_t)state->projectile_count * sizeof(Vec3));
 
   Vec3 front_xz = { front.x, 0.f, front.z };
   vec3_normalize(&front_xz);
@@ -298,33 +1295,43 @@ void game_update(float dt, unsigned int keys, float mouse_dx, float mouse_dy, in
   if (keys & 4)  { vx -= right.x * move_speed * dt; vz -= right.z * move_speed * dt; }       /* A */
   if (keys & 8)  { vx += right.x * move_speed * dt; vz += right.z * move_speed * dt; }       /* D */
 
-  float new_x = player_position.x + vx;
-  if (!would_overlap_obstacle(new_x, player_position.y, player_position.z))
-    player_position.x = new_x;
-  float new_z = player_position.z + vz;
-  if (!would_overlap_obstacle(player_position.x, player_position.y, new_z))
-    player_position.z = new_z;
+  float new_x = state->player_position.x + vx;
+  if (!would_overlap_obstacle(new_x, state->player_position.y, state->player_position.z))
+    state->player_position.x = new_x;
+  float new_z = state->player_position.z + vz;
+  if (!would_overlap_obstacle(state->player_position.x, state->player_position.y, new_z))
+    state->player_position.z = new_z;
+  STATS_ADD(obstacle_queries, 2);
 
-  is_moving = (vx * vx + vz * vz > 1e-6f);
+  state->is_moving = (vx * vx + vz * vz > 1e-6f);
+  STATS_PHASE(move_ns, "move", move_start);
 
-  float floor_y = terrain_height(player_position.x, player_position.z);
+  STATS_TIMER(vertical_start);
+
+  float floor_y = terrain_height(state->player_position.x, state->player_position.z);
   float player_feet = floor_y + PLAYER_HALF_EXTENT;
 
   /* Jump */
-  if ((keys & 16) && player_position.y <= player_feet + 0.001f && velocity_y <= 0.f)
-    velocity_y = JUMP_SPEED;
+  if ((keys & 16) && state->player_position.y <= player_feet + 0.001f && state->velocity_y <= 0.f)
+    state->velocity_y = JUMP_SPEED;
 
-  velocity_y -= GRAVITY * dt;
-  player_position.y += velocity_y * dt;
+  state->velocity_y -= GRAVITY * dt;
+  state->player_position.y += state->velocity_y * dt;
 
-  if (player_position.y < player_feet) {
-    player_position.y = player_feet;
-    velocity_y = 0.f;
+  if (state->player_position.y < player_feet) {
+    state->player_position.y = player_feet;
+    state->velocity_y = 0.f;
   }
 
   /* Obstacle collision (vertical) */
   float h = PLAYER_HALF_EXTENT;
-  for (int i = 0; i < NUM_OBSTACLES; i++) {
+  for (int i = -1;;) {
+    i = obstacle_grid_next_box_hit(i,
+          state->player_position.x - h, state->player_position.y - h, state->player_position.z - h,
+          state->player_position.x + h, state->player_position.y + h, state->player_position.z + h);
+    STATS_ADD(obstacle_queries, 1);
+    if (i < 0) break;
+    STATS_ADD(obstacle_hits, 1);
     Vec3 c = obstacle_centers[i];
     int t = (int)obstacle_types[i];
     float o_top, o_bottom;
@@ -338,173 +1345,260 @@ void game_update(float dt, unsigned int keys, float mouse_dx, float mouse_dy, in
       o_top = c.y + OBSTACLE_TRIANGLE_HALF_Y;
       o_bottom = c.y - OBSTACLE_TRIANGLE_HALF_Y;
     }
-    float o_min_x, o_min_y, o_min_z, o_max_x, o_max_y, o_max_z;
-    obstacle_bounds(i, &o_min_x, &o_min_y, &o_min_z, &o_max_x, &o_max_y, &o_max_z);
-    if (!aabb_overlap(
-          player_position.x - h, player_position.y - h, player_position.z - h,
-          player_position.x + h, player_position.y + h, player_position.z + h,
-          o_min_x, o_min_y, o_min_z, o_max_x, o_max_y, o_max_z))
-      continue;
-    if (velocity_y <= 0.f) {
-      player_position.y = o_top + h;
-      velocity_y = 0.f;
+    if (state->velocity_y <= 0.f) {
+      state->player_position.y = o_top + h;
+      state->velocity_y = 0.f;
     } else {
       float land = (o_bottom - h) > floor_y ? (o_bottom - h) : floor_y;
-      player_position.y = land + h;
-      velocity_y = 0.f;
+      state->player_position.y = land + h;
+      state->velocity_y = 0.f;
     }
   }
 
-  is_in_air = (player_position.y > player_feet + 0.001f);
+  state->is_in_air = (state->player_position.y > player_feet + 0.001f);
+  STATS_PHASE(vertical_ns, "vertical", vertical_start);
 
+  STATS_TIMER(world_start);
+#if WORLD_STREAMING
+  world_stream_update();
+#else
   /* Clamp to floor bounds */
   float margin = FLOOR_HALF_SIZE - PLAYER_HALF_EXTENT;
-  if (player_position.x < -margin) player_position.x = -margin;
-  if (player_position.x > margin)  player_position.x = margin;
-  if (player_position.z < -margin) player_position.z = -margin;
-  if (player_position.z > margin)  player_position.z = margin;
+  if (state->player_position.x < -margin) state->player_position.x = -margin;
+  if (state->player_position.x > margin)  state->player_position.x = margin;
+  if (state->player_position.z < -margin) state->player_position.z = -margin;
+  if (state->player_position.z > margin)  state->player_position.z = margin;
+#endif
+  STATS_PHASE(world_ns, "world", world_start);
 
-  if (is_moving && !is_in_air) run_time += dt;
+  if (state->is_moving && !state->is_in_air) state->run_time += dt;
 
   /* Shoot */
-  if (pending_shoot && projectile_count < MAX_PROJECTILES) {
-    Projectile* p = &projectiles[projectile_count++];
-    p->x = player_position.x;
-    p->y = player_position.y;
-    p->z = player_position.z;
-    p->vx = front.x * PROJECTILE_SPEED;
-    p->vy = front.y * PROJECTILE_SPEED;
-    p->vz = front.z * PROJECTILE_SPEED;
-  }
-
-  /* Update projectiles */
-  for (int i = projectile_count - 1; i >= 0; i--) {
-    Projectile* p = &projectiles[i];
-    p->x += p->vx * dt;
-    p->y += p->vy * dt;
-    p->z += p->vz * dt;
+  STATS_TIMER(projectile_start);
+  if (world->pending_shoot && state->projectile_count < MAX_PROJECTILES) {
+    STATS_ADD(spawns, 1);
+    Vec3* p = &state->projectile_positions[state->projectile_count];
+    Vec3* v = &state->projectile_velocities[state->projectile_count];
+    state->projectile_prev_positions[state->projectile_count] = state->player_position;
+    state->projectile_count++;
+    *p = state->player_position;
+    v->x = front.x * PROJECTILE_SPEED;
+    v->y = front.y * PROJECTILE_SPEED;
+    v->z = front.z * PROJECTILE_SPEED;
+  }
+  world->pending_shoot = 0; /* one shot per press, even when the pool is full */
 
-    int remove = 0;
-    float dx = p->x - player_position.x, dy = p->y - player_position.y, dz = p->z - player_position.z;
-    if (dx*dx + dy*dy + dz*dz > PROJECTILE_MAX_DIST * PROJECTILE_MAX_DIST) remove = 1;
-    if (p->y < -10.f) remove = 1; // Remove if too far below floor
-    
-    float pr = PROJECTILE_RADIUS;
-    float floor_top = terrain_height(p->x, p->z);
-    
-    /* Floor (terrain) collision and bounce */
-    if (p->y - pr < floor_top) {
-      p->y = floor_top + pr;
-      p->vy = -p->vy * PROJECTILE_BOUNCE_COEFFICIENT; // Bounce with energy loss
-      // Small friction on floor
-      p->vx *= 0.95f;
-      p->vz *= 0.95f;
-    }
-    
-    // Obstacle collision and bounce
-    for (int j = 0; j < NUM_OBSTACLES && !remove; j++) {
-      Vec3 c = obstacle_centers[j];
-      int t = (int)obstacle_types[j];
-      int hit = 0;
-      float nx = 0.f, ny = 1.f, nz = 0.f;
-      float o_min_x, o_min_y, o_min_z, o_max_x, o_max_y, o_max_z;
-      obstacle_bounds(j, &o_min_x, &o_min_y, &o_min_z, &o_max_x, &o_max_y, &o_max_z);
-      
-      if (t == OBSTACLE_TYPE_SPHERE) {
-        if (sphere_sphere_overlap(p->x, p->y, p->z, pr, c.x, c.y, c.z, OBSTACLE_SPHERE_RADIUS)) {
-          hit = 1;
-          float dx = p->x - c.x, dy = p->y - c.y, dz = p->z - c.z;
-          float len = sqrtf(dx*dx + dy*dy + dz*dz);
-          if (len > 1e-6f) { nx = dx/len; ny = dy/len; nz = dz/len; }
-        }
-      } else {
-        if (sphere_aabb_overlap(p->x, p->y, p->z, pr, o_min_x, o_min_y, o_min_z, o_max_x, o_max_y, o_max_z)) {
-          hit = 1;
-          float dx = p->x - c.x, dy = p->y - c.y, dz = p->z - c.z;
-          float len = sqrtf(dx*dx + dy*dy + dz*dz);
-          if (len > 1e-6f) { nx = dx/len; ny = dy/len; nz = dz/len; }
-        }
-      }
-      
-      if (hit) {
-        float obs_r = (t == OBSTACLE_TYPE_SPHERE) ? OBSTACLE_SPHERE_RADIUS : OBSTACLE_HALF_EXTENT;
-        float dx = p->x - c.x, dy = p->y - c.y, dz = p->z - c.z;
-        float len = sqrtf(dx*dx + dy*dy + dz*dz);
-        float overlap = pr + obs_r - len;
-        if (overlap > 0.f && len > 1e-6f) {
-          p->x += nx * overlap;
-          p->y += ny * overlap;
-          p->z += nz * overlap;
-        }
-        reflect_velocity_off_normal(&p->vx, &p->vy, &p->vz, nx, ny, nz, PROJECTILE_BOUNCE_COEFFICIENT);
-        float speed_sq = p->vx*p->vx + p->vy*p->vy + p->vz*p->vz;
-        if (speed_sq < 1.f) remove = 1;
-      }
-    }
-    
-    if (remove) {
-      projectiles[i] = projectiles[--projectile_count];
+  /* Update projectiles: move, bounce off terrain and obstacles, mark removals */
+  jobs_parallel_for(state->projectile_count, PROJECTILE_JOB_CHUNK, projectile_update_range, &dt);
+  STATS_PHASE(projectile_ns, "projectiles", projectile_start);
+
+#if PROJECTILE_PAIR_COLLISIONS
+  STATS_TIMER(pair_start);
+  projectile_pairs_collide();
+  STATS_PHASE(projectile_pair_ns, "projectile_pairs", pair_start);
+#endif
+  STATS_TIMER(compact_start);
+  projectile_compact();
+  STATS_PHASE(projectile_ns, "projectile_compact", compact_start);
+
+#if !OBSTACLE_ROTATION_ANALYTIC
+  /* Update obstacle rotations */
+  STATS_TIMER(rotation_start);
+  jobs_parallel_for(NUM_OBSTACLES, ROTATION_JOB_CHUNK, obstacle_rotate_range, &dt);
+  STATS_PHASE(rotation_ns, "rotation", rotation_start);
+#endif
+}
+
+/* Mouse look is applied once per call so the camera tracks input at display rate. In fixed-step mode the
+   frame time is banked and simulated in whole fixed_step ticks (at most max_catchup_steps per call; any
+   further backlog is dropped), and interpolation_alpha says how far rendering is past the last tick. */
+static void record_update(float dt, unsigned int keys, float mouse_dx, float mouse_dy, int shoot) {
+  unsigned char flags = (unsigned char)((keys & GAME_RECORD_KEYS) | (shoot ? GAME_RECORD_SHOOT : 0) |
+                                        (mouse_dx != 0.f || mouse_dy != 0.f ? GAME_RECORD_MOUSE : 0));
+  int bytes = 1 + 4 + ((flags & GAME_RECORD_MOUSE) ? 8 : 0);
+  if (record_size + bytes > GAME_RECORD_CAPACITY) {
+    recording = 0;
+    return;
+  }
+  unsigned char* out = record_log + record_size;
+  out[0] = flags;
+  memcpy(out + 1, &dt, 4);
+  if (flags & GAME_RECORD_MOUSE) {
+    memcpy(out + 5, &mouse_dx, 4);
+    memcpy(out + 9, &mouse_dy, 4);
+  }
+  record_size += bytes;
+}
+
+/* game_update for the active world */
+static void world_update(float dt, unsigned int keys, float mouse_dx, float mouse_dy, int shoot) {
+  world->keys_mask = keys;
+  world->pending_mouse_dx = mouse_dx;
+  world->pending_mouse_dy = mouse_dy;
+  if (shoot) world->pending_shoot = 1; /* latched until a tick fires it */
+
+  /* Mouse */
+  state->yaw -= mouse_dx * MOUSE_SENSITIVITY;
+  state->pitch -= mouse_dy * MOUSE_SENSITIVITY;
+  if (state->pitch > MAX_PITCH_RAD) state->pitch = MAX_PITCH_RAD;
+  if (state->pitch < -MAX_PITCH_RAD) state->pitch = -MAX_PITCH_RAD;
+
+  /* Front vector (normalized) */
+  world->front_dir = compute_front();
+
+  if (fixed_step <= 0.f) {
+    if (dt > 0.1f) dt = 0.1f;
+    game_tick(dt);
+    world->ticks_last_update = 1;
+    state->interpolation_alpha = 1.f;
+  } else {
+    if (dt > 0.f) state->step_accumulator += (double)dt;
+    world->ticks_last_update = 0;
+    while (state->step_accumulator >= (double)fixed_step && world->ticks_last_update < max_catchup_steps) {
+      game_tick(fixed_step);
+      state->step_accumulator -= (double)fixed_step;
+      world->ticks_last_update++;
     }
+    if (state->step_accumulator >= (double)fixed_step) state->step_accumulator = fmod(state->step_accumulator, (double)fixed_step);
+    state->interpolation_alpha = (float)(state->step_accumulator / (double)fixed_step);
   }
 
-  /* Update obstacle rotations */
-  for (int i = 0; i < NUM_OBSTACLES; i++) {
-    obstacle_rotations[i] += obstacle_rotation_speeds[i] * dt;
-    if (obstacle_rotations[i] > 6.28318530718f) {
-      obstacle_rotations[i] -= 6.28318530718f;
+  frame_block_publish();
+  STATS_ADD(projectiles, state->projectile_count);
+}
+
+void game_update(float dt, unsigned int keys, float mouse_dx, float mouse_dy, int shoot) {
+#if GAME_STATS
+  unsigned int updates = stats.updates + 1;
+  memset(&stats, 0, sizeof(stats));
+  stats.updates = updates;
+#endif
+  STATS_TIMER(update_start);
+  if (recording) record_update(dt, keys, mouse_dx, mouse_dy, shoot);
+  world_update(dt, keys, mouse_dx, mouse_dy, shoot);
+  STATS_PHASE(update_ns, "game_update", update_start);
+}
+
+/* Worlds (game.h). A created world gets its own arena and starts where game_init would put it; the obstacle
+   layout, terrain and collision structures are shared, so a world costs little more than sizeof(GameState). */
+GameWorld* game_world_default(void) { return &default_world; }
+
+GameWorld* game_world_create(void) {
+  GameWorld* w = (GameWorld*)calloc(1, sizeof(GameWorld));
+  if (!w) return 0;
+  world_select(w);
+  world_reset(0);
+  world_select(&default_world);
+  return w;
+}
+
+void game_world_destroy(GameWorld* w) {
+  if (w && w != &default_world) free(w);
+}
+
+void game_world_update(GameWorld* w, float dt, unsigned int keys_mask, float mouse_dx, float mouse_dy, int shoot) {
+  GameInput in = { dt, keys_mask, mouse_dx, mouse_dy, shoot };
+  game_worlds_update(&w, 1, &in);
+}
+
+typedef struct { unsigned int key; int index; } WorldOrder;
+
+static int world_order_cmp(const void* a, const void* b) {
+  const WorldOrder* x = (const WorldOrder*)a;
+  const WorldOrder* y = (const WorldOrder*)b;
+  if (x->key != y->key) return x->key < y->key ? -1 : 1;
+  return x->index - y->index;
+}
+
+/* Worlds are stepped in order of the grid cell (streaming: the window) their player is in, so consecutive
+   worlds read the same obstacle and terrain lines while they are still cached, and streaming worlds that
+   share a window skip the resync. Worlds never read each other, so the order does not change any result.
+   Stats cover the whole batch. */
+void game_worlds_update(GameWorld* const* worlds, int n, const GameInput* inputs) {
+#if GAME_STATS
+  unsigned int updates = stats.updates + 1;
+  memset(&stats, 0, sizeof(stats));
+  stats.updates = updates;
+#endif
+  STATS_TIMER(update_start);
+  WorldOrder* order = n > 1 ? (WorldOrder*)malloc((size_t)n * sizeof(WorldOrder)) : 0;
+  if (order) {
+    for (int i = 0; i < n; i++) {
+      const GameState* s = &worlds[i]->state;
+#if WORLD_STREAMING
+      order[i].key = ((unsigned int)s->world_center_cz << 16) ^ ((unsigned int)s->world_center_cx & 0xffffu);
+#else
+      order[i].key = (unsigned int)obstacle_grid_cell(s->player_position.x, s->player_position.z);
+#endif
+      order[i].index = i;
     }
+    qsort(order, (size_t)n, sizeof(WorldOrder), world_order_cmp);
   }
+  for (int k = 0; k < n; k++) {
+    int i = order ? order[k].index : k;
+    const GameInput* in = &inputs[i];
+    world_select(worlds[i]);
+    world_update(in->dt, in->keys_mask, in->mouse_dx, in->mouse_dy, in->shoot);
+  }
+  world_select(&default_world);
+  free(order);
+  STATS_PHASE(update_ns, "game_worlds_update", update_start);
 }
 
+const float* game_world_get_frame(const GameWorld* w) { return w->frame_block; }
+
+int game_set_thread_count(int threads) { return jobs_init(threads); }
+
+void game_set_fixed_timestep(float hz, int max_steps) {
+  fixed_step = hz > 0.f ? 1.f / hz : 0.f;
+  fixed_step_hz = hz > 0.f ? hz : 0.f;
+  max_catchup_steps = max_steps > 0 ? max_steps : 1;
+  state->step_accumulator = 0.0;
+  state->interpolation_alpha = 1.f;
+}
+float game_get_interpolation_alpha(void) { return state->interpolation_alpha; }
+
 void game_get_player_position(float* x, float* y, float* z) {
-  *x = player_position.x; *y = player_position.y; *z = player_position.z;
+  *x = state->player_position.x; *y = state->player_position.y; *z = state->player_position.z;
 }
-float game_get_player_x(void) { return player_position.x; }
-float game_get_player_y(void) { return player_position.y; }
-float game_get_player_z(void) { return player_position.z; }
+float game_get_player_x(void) { return state->player_position.x; }
+float game_get_player_y(void) { return state->player_position.y; }
+float game_get_player_z(void) { return state->player_position.z; }
 
 void game_get_player_rotation(float* yaw_out, float* pitch_out) {
-  *yaw_out = yaw; *pitch_out = pitch;
+  *yaw_out = state->yaw; *pitch_out = state->pitch;
 }
-float game_get_player_yaw(void) { return yaw; }
-float game_get_player_pitch(void) { return pitch; }
+float game_get_player_yaw(void) { return state->yaw; }
+float game_get_player_pitch(void) { return state->pitch; }
 
 void game_get_front(float* x, float* y, float* z) {
-  float cp = cosf(pitch), sp = sinf(pitch), cy = cosf(yaw), sy = sinf(yaw);
-  Vec3 front = { cp * sy, sp, cp * cy };
-  vec3_normalize(&front);
-  *x = front.x; *y = front.y; *z = front.z;
-}
-float game_get_front_x(void) {
-  float cp = cosf(pitch), sp = sinf(pitch), cy = cosf(yaw), sy = sinf(yaw);
-  Vec3 front = { cp * sy, sp, cp * cy };
-  vec3_normalize(&front);
-  return front.x;
-}
-float game_get_front_y(void) {
-  float cp = cosf(pitch), sp = sinf(pitch), cy = cosf(yaw), sy = sinf(yaw);
-  Vec3 front = { cp * sy, sp, cp * cy };
-  vec3_normalize(&front);
-  return front.y;
-}
-float game_get_front_z(void) {
-  float cp = cosf(pitch), sp = sinf(pitch), cy = cosf(yaw), sy = sinf(yaw);
-  Vec3 front = { cp * sy, sp, cp * cy };
-  vec3_normalize(&front);
-  return front.z;
+  *x = world->front_dir.x; *y = world->front_dir.y; *z = world->front_dir.z;
 }
+float game_get_front_x(void) { return world->front_dir.x; }
+float game_get_front_y(void) { return world->front_dir.y; }
+float game_get_front_z(void) { return world->front_dir.z; }
 
-int game_get_projectile_count(void) { return projectile_count; }
+int game_get_projectile_count(void) { return state->projectile_count; }
+
+int game_spawn_projectile(float x, float y, float z, float vx, float vy, float vz) {
+  if (state->projectile_count >= MAX_PROJECTILES) return -1;
+  int i = state->projectile_count++;
+  vec3_set(&state->projectile_positions[i], x, y, z);
+  vec3_set(&state->projectile_velocities[i], vx, vy, vz);
+  state->projectile_prev_positions[i] = state->projectile_positions[i];
+  projectile_removed[i] = 0;
+  world->frame_block[GAME_FRAME_PROJECTILE_COUNT] = (float)state->projectile_count;
+  return i;
+}
 
 void game_get_projectile(int i, float* x, float* y, float* z, float* vx, float* vy, float* vz) {
-  if (i < 0 || i >= projectile_count) return;
-  Projectile* p = &projectiles[i];
-  *x = p->x; *y = p->y; *z = p->z;
-  *vx = p->vx; *vy = p->vy; *vz = p->vz;
+  if (i < 0 || i >= state->projectile_count) return;
+  *x = state->projectile_positions[i].x; *y = state->projectile_positions[i].y; *z = state->projectile_positions[i].z;
+  *vx = state->projectile_velocities[i].x; *vy = state->projectile_velocities[i].y; *vz = state->projectile_velocities[i].z;
 }
-float game_get_projectile_x(int i) { return (i >= 0 && i < projectile_count) ? projectiles[i].x : 0.f; }
-float game_get_projectile_y(int i) { return (i >= 0 && i < projectile_count) ? projectiles[i].y : 0.f; }
-float game_get_projectile_z(int i) { return (i >= 0 && i < projectile_count) ? projectiles[i].z : 0.f; }
+float game_get_projectile_x(int i) { return (i >= 0 && i < state->projectile_count) ? state->projectile_positions[i].x : 0.f; }
+float game_get_projectile_y(int i) { return (i >= 0 && i < state->projectile_count) ? state->projectile_positions[i].y : 0.f; }
+float game_get_projectile_z(int i) { return (i >= 0 && i < state->projectile_count) ? state->projectile_positions[i].z : 0.f; }
 
 int game_get_obstacle_count(void) { return NUM_OBSTACLES; }
 
@@ -517,10 +1611,616 @@ void game_get_obstacle(int i, float* x, float* y, float* z) {
 float game_get_obstacle_x(int i) { return (i >= 0 && i < NUM_OBSTACLES) ? obstacle_centers[i].x : 0.f; }
 float game_get_obstacle_y(int i) { return (i >= 0 && i < NUM_OBSTACLES) ? obstacle_centers[i].y : 0.f; }
 float game_get_obstacle_z(int i) { return (i >= 0 && i < NUM_OBSTACLES) ? obstacle_centers[i].z : 0.f; }
-float game_get_obstacle_rotation(int i) { return (i >= 0 && i < NUM_OBSTACLES) ? obstacle_rotations[i] : 0.f; }
+/* Rotations at game_get_obstacle_rotation_time 0: the placed ones, or the active world's in reference mode */
+static const float* obstacle_rotation_base(void) {
+#if OBSTACLE_ROTATION_ANALYTIC
+  return obstacle_rotations;
+#else
+  return state->obstacle_rotations;
+#endif
+}
+/* Rotation is a pure function of time: base + speed * t, wrapped to [0, 2pi), evaluated only when asked for. */
+float game_get_obstacle_rotation(int i) {
+  if (i < 0 || i >= NUM_OBSTACLES) return 0.f;
+#if OBSTACLE_ROTATION_ANALYTIC
+  return (float)fmod((double)obstacle_rotations[i] + (double)obstacle_rotation_speeds[i] * state->sim_time, 6.283185307179586);
+#else
+  return state->obstacle_rotations[i];
+#endif
+}
+/* Time to advance GAME_BUFFER_OBSTACLE_ROTATIONS by: rotation = rotations[i] + speeds[i] * t.
+   In fixed-step mode this is the interpolated render time, between the last two ticks. */
+double game_get_obstacle_rotation_time(void) {
+#if OBSTACLE_ROTATION_ANALYTIC
+  double t = state->sim_time - (1.0 - (double)state->interpolation_alpha) * (double)fixed_step;
+  return t > 0.0 ? t : 0.0;
+#else
+  return 0.0;
+#endif
+}
+double game_get_sim_time(void) { return state->sim_time; }
 unsigned int game_get_obstacle_color(int i) { return (i >= 0 && i < NUM_OBSTACLES) ? obstacle_colors[i] : 0x808080; }
 int game_get_obstacle_type(int i) { return (i >= 0 && i < NUM_OBSTACLES) ? (int)obstacle_types[i] : 0; }
 
-int game_get_is_moving(void) { return is_moving; }
-int game_get_is_in_air(void) { return is_in_air; }
-float game_get_run_time(void) { return run_time; }
+float game_get_terrain_height(float x, float z) { return terrain_height(x, z); }
+void game_get_terrain_normal(float x, float z, float* nx, float* ny, float* nz) { terrain_normal(x, z, nx, ny, nz); }
+float game_get_terrain_max_error(void) {
+#if TERRAIN_HEIGHTFIELD
+  return terrain_max_error;
+#else
+  return 0.f;
+#endif
+}
+
+/* Closest hit along the ray within max_dist (direction need not be normalized). On a miss the distance is
+   max_dist and the normal is zero. */
+int game_raycast(float ox, float oy, float oz, float dx, float dy, float dz, float max_dist,
+                 float* out_dist, float* out_nx, float* out_ny, float* out_nz) {
+  Ray r;
+  float len = sqrtf(dx * dx + dy * dy + dz * dz);
+  int hit = GAME_RAY_MISS;
+  float t = max_dist, t_terrain;
+  Vec3 n = { 0.f, 0.f, 0.f };
+  if (len > 1e-10f && max_dist > 0.f) {
+    vec3_set(&r.origin, ox, oy, oz);
+    vec3_set(&r.dir, dx / len, dy / len, dz / len);
+    vec3_set(&r.inv_dir, 1.f / r.dir.x, 1.f / r.dir.y, 1.f / r.dir.z);
+    hit = obstacle_bvh_raycast(&r, max_dist, &t, &n);
+    if (terrain_raycast(&r, t, &t_terrain) && (hit < 0 || t_terrain < t)) {
+      hit = GAME_RAY_TERRAIN;
+      t = t_terrain;
+      terrain_normal(ox + r.dir.x * t, oz + r.dir.z * t, &n.x, &n.y, &n.z);
+    }
+  }
+  *out_dist = t;
+  *out_nx = n.x; *out_ny = n.y; *out_nz = n.z;
+  return hit;
+}
+
+int game_raycast_batch(int count) {
+  int hits = 0;
+  if (count > GAME_MAX_RAYS) count = GAME_MAX_RAYS;
+  for (int i = 0; i < count; i++) {
+    const RayQuery* q = &ray_queries[i];
+    RayHit* h = &ray_hits[i];
+    h->hit = game_raycast(q->origin_x, q->origin_y, q->origin_z, q->dir_x, q->dir_y, q->dir_z, q->max_dist,
+                          &h->dist, &h->normal_x, &h->normal_y, &h->normal_z);
+    if (h->hit != GAME_RAY_MISS) hits++;
+  }
+  return hits;
+}
+
+/* Frustum + distance culling over the BVH. A node box (grown by OBSTACLE_CULL_RADIUS) fully inside a plane
+   drops that plane for its whole subtree, so obstacles deep inside the view are accepted without tests.
+   Survivors are bucketed by type and distance LOD, then written out list by list with their matrices. */
+int game_cull_obstacles(void) {
+  const float* planes = cull_params + GAME_CULL_PLANES;
+  float eye_x = cull_params[GAME_CULL_EYE_X], eye_y = cull_params[GAME_CULL_EYE_Y], eye_z = cull_params[GAME_CULL_EYE_Z];
+  float max_dist = cull_params[GAME_CULL_MAX_DIST];
+  float node_dist_sq = max_dist > 0.f ? max_dist * max_dist : 1e30f;
+  float item_dist_sq = max_dist > 0.f ? (max_dist + OBSTACLE_CULL_RADIUS) * (max_dist + OBSTACLE_CULL_RADIUS) : 1e30f;
+  float lod_dist_sq[GAME_LOD_LEVELS - 1];
+  for (int l = 0; l < GAME_LOD_LEVELS - 1; l++) {
+    float d = cull_params[GAME_CULL_LOD_DIST + l];
+    lod_dist_sq[l] = d > 0.f ? d * d : 1e30f;
+  }
+  int stack[BVH_STACK_SIZE];
+  unsigned char stack_mask[BVH_STACK_SIZE];
+  int sp = 0, count = 0;
+  if (bvh_node_count > 0) { stack[0] = 0; stack_mask[0] = 0x3f; sp = 1; }
+  while (sp > 0) {
+    sp--;
+    const BvhNode* n = &bvh_nodes[stack[sp]];
+    unsigned int mask = stack_mask[sp];
+    float ex = 0.5f * (n->max_x - n->min_x) + OBSTACLE_CULL_RADIUS;
+    float ey = 0.5f * (n->max_y - n->min_y) + OBSTACLE_CULL_RADIUS;
+    float ez = 0.5f * (n->max_z - n->min_z) + OBSTACLE_CULL_RADIUS;
+    float cx = 0.5f * (n->min_x + n->max_x), cy = 0.5f * (n->min_y + n->max_y), cz = 0.5f * (n->min_z + n->max_z);
+    float dx = fmaxf(fabsf(eye_x - cx) - ex, 0.f), dy = fmaxf(fabsf(eye_y - cy) - ey, 0.f), dz = fmaxf(fabsf(eye_z - cz) - ez, 0.f);
+    if (dx * dx + dy * dy + dz * dz > node_dist_sq) continue;
+    int outside = 0;
+    for (int p = 0; p < 6 && !outside; p++) {
+      if (!(mask & (1u << p))) continue;
+      const float* pl = planes + p * 4;
+      float s = pl[0] * cx + pl[1] * cy + pl[2] * cz + pl[3];
+      float r = fabsf(pl[0]) * ex + fabsf(pl[1]) * ey + fabsf(pl[2]) * ez;
+      if (s + r < 0.f) outside = 1;
+      else if (s - r >= 0.f) mask &= ~(1u << p);
+    }
+    if (outside) continue;
+    if (n->count == 0) {
+      int node = (int)(n - bvh_nodes);
+      stack[sp] = n->offset; stack_mask[sp] = (unsigned char)mask; sp++;
+      stack[sp] = node + 1; stack_mask[sp] = (unsigned char)mask; sp++;
+      continue;
+    }
+    for (int k = n->offset; k < n->offset + n->count; k++) {
+      int i = bvh_items[k];
+      Vec3 c = obstacle_centers[i];
+      float ox = c.x - eye_x, oy = c.y - eye_y, oz = c.z - eye_z;
+      float d_sq = ox * ox + oy * oy + oz * oz;
+      if (d_sq > item_dist_sq) continue;
+      int visible = 1;
+      for (int p = 0; p < 6 && visible; p++) {
+        const float* pl = planes + p * 4;
+        if ((mask & (1u << p)) && pl[0] * c.x + pl[1] * c.y + pl[2] * c.z + pl[3] < -OBSTACLE_CULL_RADIUS) visible = 0;
+      }
+      if (!visible) continue;
+      int lod = 0;
+      while (lod < GAME_LOD_LEVELS - 1 && d_sq >= lod_dist_sq[lod]) lod++;
+      cull_candidates[count] = i;
+      cull_candidate_lists[count] = (unsigned char)(obstacle_types[i] * GAME_LOD_LEVELS + lod);
+      count++;
+    }
+  }
+
+  int fill[GAME_CULL_LISTS];
+  int offset = 0;
+  for (int l = 0; l < GAME_CULL_LISTS; l++) visible_lists[l].count = 0;
+  for (int k = 0; k < count; k++) visible_lists[cull_candidate_lists[k]].count++;
+  for (int l = 0; l < GAME_CULL_LISTS; l++) {
+    visible_lists[l].offset = fill[l] = offset;
+    offset += visible_lists[l].count;
+  }
+  double t = game_get_obstacle_rotation_time();
+  const float* rotations = obstacle_rotation_base();
+  for (int k = 0; k < count; k++) {
+    int i = cull_candidates[k];
+    int slot = fill[cull_candidate_lists[k]]++;
+    float rot = (float)fmod((double)rotations[i] + (double)obstacle_rotation_speeds[i] * t, 6.283185307179586);
+    float co = cosf(rot), si = sinf(rot);
+    float* m = visible_matrices[slot];
+    visible_indices[slot] = i;
+    m[0] = co;  m[1] = 0.f; m[2] = -si;  m[3] = 0.f;
+    m[4] = 0.f; m[5] = 1.f; m[6] = 0.f;  m[7] = 0.f;
+    m[8] = si;  m[9] = 0.f; m[10] = co;  m[11] = 0.f;
+    m[12] = obstacle_centers[i].x; m[13] = obstacle_centers[i].y; m[14] = obstacle_centers[i].z; m[15] = 1.f;
+  }
+  return count;
+}
+
+int game_get_world_version(void) { return world_version; }
+float game_get_world_half_size(void) {
+#if WORLD_STREAMING
+  return 0.f;
+#else
+  return FLOOR_HALF_SIZE;
+#endif
+}
+
+static size_t state_snapshot_size(int projectile_count) {
+  return STATE_HEADER_SIZE + (size_t)projectile_count * STATE_PROJECTILE_ARRAYS * sizeof(Vec3);
+}
+
+int game_get_state_size(void) { return (int)state_snapshot_size(MAX_PROJECTILES); }
+
+int game_snapshot(void* buf) {
+  unsigned char* out = (unsigned char*)buf;
+  size_t live = (size_t)state->projectile_count * sizeof(Vec3);
+  memcpy(out, state, STATE_HEADER_SIZE);
+  out += STATE_HEADER_SIZE;
+  memcpy(out, state->projectile_positions, live);
+  memcpy(out + live, state->projectile_velocities, live);
+  memcpy(out + 2 * live, state->projectile_prev_positions, live);
+  return (int)state_snapshot_size(state->projectile_count);
+}
+
+/* The arena comes back in a few memcpys; only derived data is refreshed afterwards (look direction, frame
+   block and, when streaming, any chunks that differ). */
+int game_restore(const void* buf) {
+  const GameState* s = (const GameState*)buf;
+  if (!s || s->version != GAME_STATE_VERSION || s->size != sizeof(GameState) ||
+      s->projectile_count < 0 || s->projectile_count > MAX_PROJECTILES) return 0;
+#if WORLD_STREAMING
+  int old_x[WORLD_CHUNK_SLOTS], old_z[WORLD_CHUNK_SLOTS];
+  unsigned char old_used[WORLD_CHUNK_SLOTS];
+  memcpy(old_x, state->chunk_slot_x, sizeof(old_x));
+  memcpy(old_z, state->chunk_slot_z, sizeof(old_z));
+  memcpy(old_used, state->chunk_slot_used, sizeof(old_used));
+#endif
+  const unsigned char* in = (const unsigned char*)buf + STATE_HEADER_SIZE;
+  size_t live = (size_t)s->projectile_count * sizeof(Vec3);
+  memcpy(state, s, STATE_HEADER_SIZE);
+  memcpy(state->projectile_positions, in, live);
+  memcpy(state->projectile_velocities, in + live, live);
+  memcpy(state->projectile_prev_positions, in + 2 * live, live);
+#if WORLD_STREAMING
+  world_stream_resync(old_x, old_z, old_used);
+#endif
+  world->front_dir = compute_front();
+  world->ticks_last_update = 0;
+  frame_block_publish();
+  return 1;
+}
+
+unsigned int game_get_tick(void) { return state->tick; }
+
+static size_t snapshot_ring_oldest_offset(void) {
+  return snapshot_ring_offset[(snapshot_ring_head - snapshot_ring_count + GAME_SNAPSHOT_RING) % GAME_SNAPSHOT_RING];
+}
+
+unsigned int game_snapshot_push(void) {
+  size_t size = SNAPSHOT_ALIGNED(state_snapshot_size(state->projectile_count));
+  size_t at = 0;
+  if (snapshot_ring_count > 0) {
+    int newest = (snapshot_ring_head - 1 + GAME_SNAPSHOT_RING) % GAME_SNAPSHOT_RING;
+    at = snapshot_ring_offset[newest] + snapshot_ring_size[newest];
+  }
+  if (at + size > SNAPSHOT_POOL_BYTES) {
+    /* Wrap: entries between here and the pool's end are the oldest, drop them before reusing the start */
+    while (snapshot_ring_count > 0 && snapshot_ring_oldest_offset() >= at) snapshot_ring_count--;
+    at = 0;
+  }
+  /* Entries ahead of `at` are in age order, so the oldest is always the next one in the way */
+  while (snapshot_ring_count > 0 &&
+         (snapshot_ring_count == GAME_SNAPSHOT_RING ||
+          (snapshot_ring_oldest_offset() >= at && snapshot_ring_oldest_offset() < at + size))) {
+    snapshot_ring_count--;
+  }
+  snapshot_ring_offset[snapshot_ring_head] = at;
+  snapshot_ring_size[snapshot_ring_head] = size;
+  game_snapshot((unsigned char*)snapshot_pool + at);
+  snapshot_ring_head = (snapshot_ring_head + 1) % GAME_SNAPSHOT_RING;
+  snapshot_ring_count++;
+  return state->tick;
+}
+
+int game_snapshot_rewind(int back) {
+  if (back < 0 || back >= snapshot_ring_count) return 0;
+  int slot = (snapshot_ring_head - 1 - back + GAME_SNAPSHOT_RING) % GAME_SNAPSHOT_RING;
+  snapshot_ring_head = (slot + 1) % GAME_SNAPSHOT_RING;
+  snapshot_ring_count -= back;
+  return game_restore((unsigned char*)snapshot_pool + snapshot_ring_offset[slot]);
+}
+
+int game_get_snapshot_count(void) { return snapshot_ring_count; }
+
+/* The log starts from a fresh game_init, so replays need nothing but the log itself */
+void game_record_start(void) {
+  unsigned int header[4] = { GAME_RECORD_MAGIC, GAME_RECORD_VERSION, 0u, (unsigned int)max_catchup_steps };
+  memcpy(&header[2], &fixed_step_hz, 4);
+  game_init();
+  memcpy(record_log, header, GAME_RECORD_HEADER_BYTES);
+  record_size = GAME_RECORD_HEADER_BYTES;
+  recording = 1;
+}
+
+int game_record_stop(void) {
+  recording = 0;
+  return record_size;
+}
+
+int game_get_record_size(void) { return record_size; }
+
+/* Field by field (no struct padding) and only live projectiles, so builds that leave different garbage
+   in dead slots still hash equal. */
+static unsigned long long state_hash(const GameState* s) {
+  const float scalars[] = {
+    s->player_position.x, s->player_position.y, s->player_position.z,
+    s->prev_player_position.x, s->prev_player_position.y, s->prev_player_position.z,
+    s->yaw, s->pitch, s->velocity_y, s->run_time, s->interpolation_alpha
+  };
+  const int ints[] = { (int)s->tick, (int)s->rng_state, s->is_moving, s->is_in_air, s->projectile_count };
+  const double times[] = { s->sim_time, s->step_accumulator };
+  size_t live = (size_t)s->projectile_count * sizeof(Vec3);
+  unsigned long long h = 0x243F6A8885A308D3ull;
+  h = hash_bytes(h, scalars, sizeof(scalars));
+  h = hash_bytes(h, ints, sizeof(ints));
+  h = hash_bytes(h, times, sizeof(times));
+  h = hash_bytes(h, s->projectile_positions, live);
+  h = hash_bytes(h, s->projectile_velocities, live);
+  h = hash_bytes(h, s->projectile_prev_positions, live);
+#if WORLD_STREAMING
+  h = hash_bytes(h, s->chunk_slot_x, sizeof(s->chunk_slot_x));
+  h = hash_bytes(h, s->chunk_slot_z, sizeof(s->chunk_slot_z));
+  h = hash_bytes(h, s->chunk_slot_used, sizeof(s->chunk_slot_used));
+#endif
+#if !OBSTACLE_ROTATION_ANALYTIC
+  h = hash_bytes(h, s->obstacle_rotations, sizeof(s->obstacle_rotations));
+#endif
+  return h;
+}
+
+unsigned long long game_state_hash(void) { return state_hash(state); }
+unsigned long long game_world_state_hash(const GameWorld* w) { return state_hash(&w->state); }
+
+/* Replication (netcode.h). Positions go as 1/256 units offset by NET_POS_OFFSET, enough for the fixed floor
+   and a long walk through a streamed world; angles are signed turns wrapped to their field width. */
+#define NET_POS_OFFSET 8192.f
+#define NET_POS_SCALE 256.f
+enum { NET_POS, NET_ANGLE };
+
+static const NetSchema net_schemas[GAME_NET_CLASSES] = {
+  { 6, { 22, 22, 22, 16, 16, 32 }, { 6, 6, 6, 4, 4, 5 } },               /* player: x, y, z, yaw, pitch, time */
+  { 3, { 22, 22, 22 }, { 6, 6, 6 } },                                     /* projectiles: x, y, z */
+  { 7, { 22, 22, 22, 16, 32, 24, 2 }, { 6, 6, 6, 4, -1, -1, -1 } },       /* obstacles: x, y, z, rotation, speed, color, type */
+};
+static const unsigned char net_kinds[GAME_NET_CLASSES][NET_MAX_FIELDS] = {
+  { NET_POS, NET_POS, NET_POS, NET_ANGLE, NET_ANGLE },
+  { NET_POS, NET_POS, NET_POS },
+  { NET_POS, NET_POS, NET_POS, NET_ANGLE },
+};
+static const int net_capacities[GAME_NET_CLASSES] = {
+  1, MAX_PROJECTILES, GAME_NET_MAX_OBSTACLES < NUM_OBSTACLES ? GAME_NET_MAX_OBSTACLES : NUM_OBSTACLES
+};
+
+typedef struct {
+  GameWorld* world;       /* 0 = closed */
+  float view_x, view_z;   /* interest circle, when view_radius > 0 */
+  float view_radius;
+  unsigned int next_seq;  /* seq of the next snapshot, from 1 */
+  unsigned int acked;     /* newest acknowledged seq, 0 = none */
+  NetHistory history;
+} NetClient;
+
+struct GameNetReplica {
+  unsigned int latest; /* seq of the newest decoded snapshot */
+  NetHistory history;
+};
+
+static NetClient net_clients[GAME_NET_MAX_CLIENTS];
+
+static unsigned int net_quantize(float v, int kind, int bits) {
+  unsigned int max = (1u << bits) - 1u;
+  if (kind == NET_ANGLE) {
+    float turns = fmodf(v * (1.f / 6.28318530718f), 1.f);
+    return (unsigned int)(int)floorf(turns * (float)(1u << bits) + 0.5f) & max;
+  }
+  float q = (v + NET_POS_OFFSET) * NET_POS_SCALE + 0.5f;
+  return q <= 0.f ? 0u : q >= (float)max ? max : (unsigned int)q;
+}
+
+static float net_dequantize(unsigned int q, int kind, int bits) {
+  if (kind == NET_POS) return (float)q * (1.f / NET_POS_SCALE) - NET_POS_OFFSET;
+  int turns = q >= 1u << (bits - 1) ? (int)q - (1 << bits) : (int)q; /* [-pi, pi), so pitch keeps its sign */
+  return (float)turns * (6.28318530718f / (float)(1u << bits));
+}
+
+static unsigned int* net_push(NetFrame* f, int cls, unsigned int id, int count, const float* values) {
+  const NetSchema* s = &net_schemas[cls];
+  unsigned int* v = net_entities_push(&f->classes[cls], s, id);
+  if (v) {
+    for (int i = 0; i < count; i++) v[i] = net_quantize(values[i], net_kinds[cls][i], s->bits[i]);
+  }
+  return v;
+}
+
+/* Interest filter: projectiles and resident obstacles within the view radius in XZ, in index order. A
+   linear pass over the obstacles keeps them sorted by id, which a grid walk would not, and costs about as
+   much as sorting its result. Runs on the client's world, so a streamed world's own chunks are read. */
+static void net_capture(const NetClient* c, NetFrame* f) {
+  float cx = c->view_radius > 0.f ? c->view_x : state->player_position.x;
+  float cz = c->view_radius > 0.f ? c->view_z : state->player_position.z;
+  float r = c->view_radius > 0.f ? c->view_radius : GAME_NET_VIEW_RADIUS;
+  float r_sq = r * r;
+
+  float player[5] = { state->player_position.x, state->player_position.y, state->player_position.z, state->yaw,
+                      state->pitch };
+  unsigned int* q = net_push(f, GAME_NET_PLAYER, 0, 5, player);
+#if OBSTACLE_ROTATION_ANALYTIC
+  q[GAME_NET_TIME] = (unsigned int)(state->sim_time * 1000.0 + 0.5);
+#else
+  q[GAME_NET_TIME] = 0; /* the rotations already are the current ones */
+#endif
+  const float* rotations = obstacle_rotation_base();
+  for (int i = 0; i < state->projectile_count; i++) {
+    const Vec3* p = &state->projectile_positions[i];
+    float dx = p->x - cx, dz = p->z - cz;
+    if (dx * dx + dz * dz > r_sq) continue;
+    float v[3] = { p->x, p->y, p->z };
+    net_push(f, GAME_NET_PROJECTILES, (unsigned int)i, 3, v);
+  }
+  for (int i = 0; i < NUM_OBSTACLES; i++) {
+    const Vec3* o = &obstacle_centers[i];
+    float dx = o->x - cx, dz = o->z - cz;
+    if (obstacle_types[i] == GAME_OBSTACLE_TYPE_EMPTY || dx * dx + dz * dz > r_sq) continue;
+    float v[4] = { o->x, o->y, o->z, rotations[i] };
+    q = net_push(f, GAME_NET_OBSTACLES, (unsigned int)i, 4, v);
+    if (!q) break;
+    memcpy(&q[GAME_NET_SPEED], &obstacle_rotation_speeds[i], sizeof(float));
+    q[GAME_NET_COLOR] = obstacle_colors[i] & 0xFFFFFFu;
+    q[GAME_NET_TYPE] = obstacle_types[i];
+  }
+}
+
+static NetClient* net_client(int client) {
+  return client >= 0 && client < GAME_NET_MAX_CLIENTS && net_clients[client].world ? &net_clients[client] : 0;
+}
+
+int game_net_client_open(const GameWorld* w) {
+  for (int i = 0; i < GAME_NET_MAX_CLIENTS; i++) {
+    NetClient* c = &net_clients[i];
+    if (c->world) continue;
+    if (!net_history_init(&c->history, GAME_NET_CLASSES, net_schemas, net_capacities)) return -1;
+    c->world = w ? (GameWorld*)w : &default_world;
+    c->view_radius = 0.f;
+    c->next_seq = 1;
+    c->acked = 0;
+    return i;
+  }
+  return -1;
+}
+
+void game_net_client_close(int client) {
+  NetClient* c = net_client(client);
+  if (!c) return;
+  net_history_free(&c->history);
+  c->world = 0;
+}
+
+void game_net_client_view(int client, float x, float z, float radius) {
+  NetClient* c = net_client(client);
+  if (!c) return;
+  c->view_x = x;
+  c->view_z = z;
+  c->view_radius = radius > 0.f ? radius : 0.f;
+}
+
+int game_net_encode(int client, unsigned char* out, int capacity) {
+  NetClient* c = net_client(client);
+  if (!c) return -1;
+  unsigned int seq = c->next_seq;
+  const NetFrame* base = c->acked && seq - c->acked < NET_HISTORY ? net_history_find(&c->history, c->acked) : 0;
+  world_select(c->world);
+  NetFrame* f = net_history_claim(&c->history, seq, state->tick);
+  net_capture(c, f);
+  world_select(&default_world);
+  int bytes = net_encode_frame(&c->history, base, f, out, capacity);
+  if (bytes < 0) {
+    f->seq = 0;
+    return -1;
+  }
+  c->next_seq++;
+  return bytes;
+}
+
+void game_net_ack(int client, unsigned int seq) {
+  NetClient* c = net_client(client);
+  if (c && seq > c->acked && seq < c->next_seq && net_history_find(&c->history, seq)) c->acked = seq;
+}
+
+GameNetReplica* game_net_replica_create(void) {
+  GameNetReplica* r = (GameNetReplica*)malloc(sizeof(GameNetReplica));
+  if (!r) return 0;
+  r->latest = 0;
+  if (!net_history_init(&r->history, GAME_NET_CLASSES, net_schemas, net_capacities)) {
+    free(r);
+    return 0;
+  }
+  return r;
+}
+
+void game_net_replica_destroy(GameNetReplica* r) {
+  if (!r) return;
+  net_history_free(&r->history);
+  free(r);
+}
+
+unsigned int game_net_replica_apply(GameNetReplica* r, const unsigned char* data, int size) {
+  const NetFrame* f = net_decode_frame(&r->history, data, size);
+  if (!f) return 0;
+  if (f->seq > r->latest) r->latest = f->seq;
+  return f->seq;
+}
+
+unsigned int game_net_replica_tick(const GameNetReplica* r) {
+  const NetFrame* f = net_history_find(&r->history, r->latest);
+  return f ? f->tick : 0;
+}
+
+int game_net_replica_count(const GameNetReplica* r, int cls) {
+  const NetFrame* f = net_history_find(&r->history, r->latest);
+  return f && cls >= 0 && cls < GAME_NET_CLASSES ? f->classes[cls].count : 0;
+}
+
+unsigned int game_net_replica_id(const GameNetReplica* r, int cls, int i) {
+  const NetFrame* f = net_history_find(&r->history, r->latest);
+  if (!f || cls < 0 || cls >= GAME_NET_CLASSES || i < 0 || i >= f->classes[cls].count) return 0;
+  return f->classes[cls].ids[i];
+}
+
+float game_net_replica_field(const GameNetReplica* r, int cls, int i, int field) {
+  const NetFrame* f = net_history_find(&r->history, r->latest);
+  if (!f || cls < 0 || cls >= GAME_NET_CLASSES || i < 0 || i >= f->classes[cls].count || field < 0 ||
+      field >= net_schemas[cls].fields)
+    return 0.f;
+  const unsigned int* v = &f->classes[cls].values[(size_t)i * (size_t)net_schemas[cls].fields];
+  if (cls == GAME_NET_PLAYER && field == GAME_NET_TIME) return (float)v[field] * 0.001f;
+  if (cls == GAME_NET_OBSTACLES && field >= GAME_NET_SPEED) {
+    float speed;
+    memcpy(&speed, &v[GAME_NET_SPEED], sizeof(float));
+    return field == GAME_NET_SPEED ? speed : (float)v[field];
+  }
+  float value = net_dequantize(v[field], net_kinds[cls][field], net_schemas[cls].bits[field]);
+  if (cls == GAME_NET_OBSTACLES && field == GAME_NET_ROTATION) {
+    /* base + speed * time of this snapshot, as game_get_obstacle_rotation */
+    const unsigned int* player = f->classes[GAME_NET_PLAYER].count ? f->classes[GAME_NET_PLAYER].values : 0;
+    double t = player ? (double)player[GAME_NET_TIME] * 0.001 : 0.0;
+    float speed;
+    memcpy(&speed, &v[GAME_NET_SPEED], sizeof(float));
+    double a = fmod((double)value + (double)speed * t, 6.283185307179586);
+    value = (float)(a < 0.0 ? a + 6.283185307179586 : a);
+  }
+  return value;
+}
+
+#if GAME_STATS
+const GameStats* game_get_stats(void) { return &stats; }
+
+#ifndef __EMSCRIPTEN__
+int game_trace_begin(const char* path) { return stats_trace_open(path); }
+void game_trace_end(void) { stats_trace_close(); }
+#endif
+#else
+const GameStats* game_get_stats(void) { return 0; }
+#endif
+
+int game_get_is_moving(void) { return state->is_moving; }
+int game_get_is_in_air(void) { return state->is_in_air; }
+float game_get_run_time(void) { return state->run_time; }
+
+/* Buffer export: raw pointers into WASM memory so JS can wrap them once as typed-array views.
+   Pointers are stable for the lifetime of the module (static storage, no memory growth). */
+const void* game_get_buffer(int id) {
+  switch (id) {
+    case GAME_BUFFER_OBSTACLE_POSITIONS: return obstacle_centers;
+    case GAME_BUFFER_OBSTACLE_ROTATIONS: return obstacle_rotation_base();
+    case GAME_BUFFER_OBSTACLE_ROTATION_SPEEDS: return obstacle_rotation_speeds;
+    case GAME_BUFFER_OBSTACLE_COLORS: return obstacle_colors;
+    case GAME_BUFFER_OBSTACLE_TYPES: return obstacle_types;
+    case GAME_BUFFER_PROJECTILE_POSITIONS: return state->projectile_positions;
+    case GAME_BUFFER_PROJECTILE_VELOCITIES: return state->projectile_velocities;
+    case GAME_BUFFER_PROJECTILE_PREV_POSITIONS: return state->projectile_prev_positions;
+    case GAME_BUFFER_RAYS: return ray_queries;
+    case GAME_BUFFER_RAY_HITS: return ray_hits;
+    case GAME_BUFFER_CULL_PARAMS: return cull_params;
+    case GAME_BUFFER_VISIBLE_INDICES: return visible_indices;
+    case GAME_BUFFER_VISIBLE_MATRICES: return visible_matrices;
+    case GAME_BUFFER_VISIBLE_LISTS: return visible_lists;
+    case GAME_BUFFER_RECORD: return record_log;
+    case GAME_BUFFER_FRAME: return world->frame_block;
+    default: return 0;
+  }
+}
+int game_get_buffer_stride(int id) {
+  switch (id) {
+    case GAME_BUFFER_OBSTACLE_POSITIONS: return (int)sizeof(obstacle_centers[0]);
+    case GAME_BUFFER_OBSTACLE_ROTATIONS: return (int)sizeof(obstacle_rotations[0]);
+    case GAME_BUFFER_OBSTACLE_ROTATION_SPEEDS: return (int)sizeof(obstacle_rotation_speeds[0]);
+    case GAME_BUFFER_OBSTACLE_COLORS: return (int)sizeof(obstacle_colors[0]);
+    case GAME_BUFFER_OBSTACLE_TYPES: return (int)sizeof(obstacle_types[0]);
+    case GAME_BUFFER_PROJECTILE_POSITIONS: return (int)sizeof(state->projectile_positions[0]);
+    case GAME_BUFFER_PROJECTILE_VELOCITIES: return (int)sizeof(state->projectile_velocities[0]);
+    case GAME_BUFFER_PROJECTILE_PREV_POSITIONS: return (int)sizeof(state->projectile_prev_positions[0]);
+    case GAME_BUFFER_RAYS: return (int)sizeof(ray_queries[0]);
+    case GAME_BUFFER_RAY_HITS: return (int)sizeof(ray_hits[0]);
+    case GAME_BUFFER_CULL_PARAMS: return (int)sizeof(cull_params);
+    case GAME_BUFFER_VISIBLE_INDICES: return (int)sizeof(visible_indices[0]);
+    case GAME_BUFFER_VISIBLE_MATRICES: return (int)sizeof(visible_matrices[0]);
+    case GAME_BUFFER_VISIBLE_LISTS: return (int)sizeof(visible_lists[0]);
+    case GAME_BUFFER_RECORD: return (int)sizeof(record_log[0]);
+    case GAME_BUFFER_FRAME: return (int)sizeof(world->frame_block);
+    default: return 0;
+  }
+}
+int game_get_buffer_count(int id) {
+  switch (id) {
+    case GAME_BUFFER_OBSTACLE_POSITIONS:
+    case GAME_BUFFER_OBSTACLE_ROTATIONS:
+    case GAME_BUFFER_OBSTACLE_ROTATION_SPEEDS:
+    case GAME_BUFFER_OBSTACLE_COLORS:
+    case GAME_BUFFER_OBSTACLE_TYPES:
+    case GAME_BUFFER_VISIBLE_INDICES:
+    case GAME_BUFFER_VISIBLE_MATRICES: return NUM_OBSTACLES;
+    case GAME_BUFFER_PROJECTILE_POSITIONS:
+    case GAME_BUFFER_PROJECTILE_VELOCITIES:
+    case GAME_BUFFER_PROJECTILE_PREV_POSITIONS: return MAX_PROJECTILES;
+    case GAME_BUFFER_RAYS:
+    case GAME_BUFFER_RAY_HITS: return GAME_MAX_RAYS;
+    case GAME_BUFFER_VISIBLE_LISTS: return GAME_CULL_LISTS;
+    case GAME_BUFFER_RECORD: return GAME_RECORD_CAPACITY;
+    case GAME_BUFFER_CULL_PARAMS:
+    case GAME_BUFFER_FRAME: return 1;
+    default: return 0;
+  }
+}
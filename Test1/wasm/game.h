@@ -5,11 +5,136 @@
 extern "C" {
 #endif
 
-#define MAX_PROJECTILES 64
+#ifndef PROJECTILE_HIGH_VOLUME
+#define PROJECTILE_HIGH_VOLUME 0  /* 1 = bullet-hell build: 16k projectiles that also bounce off each other */
+#endif
+#ifndef MAX_PROJECTILES
+#define MAX_PROJECTILES (PROJECTILE_HIGH_VOLUME ? 16384 : 64)
+#endif
+#ifndef WORLD_STREAMING
+#define WORLD_STREAMING 0  /* 1 = unbounded world streamed in chunks around the player */
+#endif
+#define WORLD_CHUNK_OBSTACLES 32  /* obstacles per streamed chunk */
+#define WORLD_CHUNK_SLOTS     64  /* resident chunk cache; obstacle i belongs to slot i / WORLD_CHUNK_OBSTACLES */
+#ifndef NUM_OBSTACLES
+#if WORLD_STREAMING
+#define NUM_OBSTACLES (WORLD_CHUNK_SLOTS * WORLD_CHUNK_OBSTACLES)
+#else
 #define NUM_OBSTACLES 8000
+#endif
+#endif
+#define GAME_STATE_VERSION 2  /* bump whenever the snapshot layout (GameState in game.c) changes */
+#ifndef GAME_SNAPSHOT_RING
+#define GAME_SNAPSHOT_RING 64  /* snapshots kept for game_snapshot_rewind */
+#endif
+#ifndef GAME_SNAPSHOT_RING_BYTES
+/* Cap on the ring's static byte pool; 0 = room for GAME_SNAPSHOT_RING full-size snapshots */
+#define GAME_SNAPSHOT_RING_BYTES (PROJECTILE_HIGH_VOLUME ? (4 << 20) : 0)
+#endif
+#ifndef GAME_STATS
+#define GAME_STATS 0  /* 1 = time game_update phases and count their work into GameStats (game_get_stats) */
+#endif
+#define GAME_OBSTACLE_TYPE_EMPTY 255  /* obstacle slot with no resident chunk: no collision, not drawn */
+
+/* Buffers exposed by game_get_buffer (element layout in brackets) */
+#define GAME_BUFFER_OBSTACLE_POSITIONS        0  /* float[3] x, y, z */
+#define GAME_BUFFER_OBSTACLE_ROTATIONS        1  /* float, radians around Y; add speed * game_get_obstacle_rotation_time() */
+#define GAME_BUFFER_OBSTACLE_COLORS           2  /* uint32 0xRRGGBB */
+#define GAME_BUFFER_OBSTACLE_TYPES            3  /* uint8 0=cube, 1=sphere, 2=triangle, GAME_OBSTACLE_TYPE_EMPTY */
+#define GAME_BUFFER_PROJECTILE_POSITIONS      4  /* float[3]; live count in GAME_FRAME_PROJECTILE_COUNT */
+#define GAME_BUFFER_PROJECTILE_VELOCITIES     5  /* float[3] */
+#define GAME_BUFFER_FRAME                     6  /* float[GAME_FRAME_FLOATS], refreshed by game_init/game_update */
+#define GAME_BUFFER_OBSTACLE_ROTATION_SPEEDS  7  /* float, radians per second */
+#define GAME_BUFFER_PROJECTILE_PREV_POSITIONS 8  /* float[3], positions before the last tick (interpolate with GAME_FRAME_ALPHA) */
+#define GAME_BUFFER_RAYS                      9  /* float[7] origin xyz, direction xyz, max distance; input of game_raycast_batch */
+#define GAME_BUFFER_RAY_HITS                  10 /* int32 hit, float distance, float[3] normal; output of game_raycast_batch */
+#define GAME_BUFFER_CULL_PARAMS               11 /* float[GAME_CULL_FLOATS]; input of game_cull_obstacles */
+#define GAME_BUFFER_VISIBLE_INDICES           12 /* int32 obstacle index, grouped by cull list */
+#define GAME_BUFFER_VISIBLE_MATRICES          13 /* float[16] column-major rotation-Y + translation, same order as the indices */
+#define GAME_BUFFER_VISIBLE_LISTS             14 /* int32 offset, int32 count into the two buffers above, per cull list */
+#define GAME_BUFFER_RECORD                    15 /* uint8 input log; game_get_record_size() bytes are in use */
+#define GAME_BUFFER_COUNT                     16
+
+/* Ray casts report the obstacle index hit, or one of these */
+#define GAME_RAY_MISS    (-1)
+#define GAME_RAY_TERRAIN (-2)
+#define GAME_MAX_RAYS    1024 /* rays per game_raycast_batch call */
+
+/* Float offsets inside the GAME_BUFFER_CULL_PARAMS block. Planes have unit normals pointing inwards (three.js Frustum):
+   a point p is inside when nx * p.x + ny * p.y + nz * p.z + d >= 0. */
+#define GAME_LOD_LEVELS        3
+#define GAME_CULL_PLANES       0  /* 6 planes: nx, ny, nz, d */
+#define GAME_CULL_EYE_X        24 /* camera position, for distance culling and LOD */
+#define GAME_CULL_EYE_Y        25
+#define GAME_CULL_EYE_Z        26
+#define GAME_CULL_MAX_DIST     27 /* <= 0: no distance limit */
+#define GAME_CULL_LOD_DIST     28 /* GAME_LOD_LEVELS - 1 ascending distances where the next LOD starts; <= 0: unused */
+#define GAME_CULL_FLOATS       (GAME_CULL_LOD_DIST + GAME_LOD_LEVELS - 1)
+#define GAME_CULL_LISTS        (3 * GAME_LOD_LEVELS) /* list = type * GAME_LOD_LEVELS + lod; a type's lists are adjacent */
+
+/* Input log written between game_record_start and game_record_stop, replayed headlessly by native/replay.c.
+   Little-endian. Header: u32 GAME_RECORD_MAGIC, u32 GAME_RECORD_VERSION, f32 fixed-step Hz (0 = variable),
+   i32 max catch-up steps. Then one record per game_update: u8 flags (keys_mask in the low 6 bits), f32 dt,
+   and f32 mouse_dx, mouse_dy only when GAME_RECORD_MOUSE is set. */
+#define GAME_RECORD_MAGIC        0x50523154u /* "T1RP" */
+#define GAME_RECORD_VERSION      1
+#define GAME_RECORD_HEADER_BYTES 16
+#define GAME_RECORD_KEYS         63
+#define GAME_RECORD_SHOOT        64
+#define GAME_RECORD_MOUSE        128
+#ifndef GAME_RECORD_CAPACITY
+#define GAME_RECORD_CAPACITY     (1 << 20) /* bytes (~1 h of 60 fps input); recording stops when full */
+#endif
+
+/* Phase timings and work counters of the last game_update, returned by game_get_stats in GAME_STATS builds.
+   Every field is a uint32, so JS can view it as a Uint32Array in field order. Times are nanoseconds summed
+   over all ticks the update ran. */
+typedef struct {
+  unsigned int updates;            /* game_update calls since game_init */
+  unsigned int ticks;              /* ticks run by the last game_update */
+  unsigned int update_ns;          /* whole game_update */
+  unsigned int move_ns;            /* horizontal movement against obstacles */
+  unsigned int vertical_ns;        /* jump, gravity, terrain and obstacle landing */
+  unsigned int world_ns;           /* chunk streaming or floor clamp */
+  unsigned int projectile_ns;      /* spawn, integrate, terrain/obstacle bounces, compaction */
+  unsigned int projectile_pair_ns; /* projectile-projectile hash and bounces (PROJECTILE_PAIR_COLLISIONS) */
+  unsigned int rotation_ns;        /* obstacle rotation integration (OBSTACLE_ROTATION_ANALYTIC=0 only) */
+  unsigned int obstacle_queries;   /* grid queries by the player and projectiles */
+  unsigned int obstacle_hits;      /* obstacle contacts resolved */
+  unsigned int pair_tests;         /* projectile pairs offered by the spatial hash */
+  unsigned int pair_hits;          /* projectile pairs that touched */
+  unsigned int spawns;             /* projectiles fired */
+  unsigned int removals;           /* projectiles expired or stopped */
+  unsigned int projectiles;        /* live after the update */
+} GameStats;
+#define GAME_STATS_FIELDS 16
+
+/* Float offsets inside the GAME_BUFFER_FRAME block */
+#define GAME_FRAME_PLAYER_X         0
+#define GAME_FRAME_PLAYER_Y         1
+#define GAME_FRAME_PLAYER_Z         2
+#define GAME_FRAME_YAW              3
+#define GAME_FRAME_PITCH            4
+#define GAME_FRAME_FRONT_X          5
+#define GAME_FRAME_FRONT_Y          6
+#define GAME_FRAME_FRONT_Z          7
+#define GAME_FRAME_IS_MOVING        8
+#define GAME_FRAME_IS_IN_AIR        9
+#define GAME_FRAME_RUN_TIME         10
+#define GAME_FRAME_PROJECTILE_COUNT 11
+#define GAME_FRAME_PREV_PLAYER_X    12 /* player position before the last tick */
+#define GAME_FRAME_PREV_PLAYER_Y    13
+#define GAME_FRAME_PREV_PLAYER_Z    14
+#define GAME_FRAME_ALPHA            15 /* render at prev + (current - prev) * alpha; 1 in variable-step mode */
+#define GAME_FRAME_TICKS            16 /* simulation ticks run by the last game_update */
+#define GAME_FRAME_WORLD_VERSION    17 /* changes whenever obstacles are streamed in or out */
+#define GAME_FRAME_FLOATS           18
 
 void game_init(void);
 void game_update(float dt, unsigned int keys_mask, float mouse_dx, float mouse_dy, int shoot);
+void game_set_fixed_timestep(float hz, int max_steps); /* hz <= 0: one variable step per game_update (default) */
+int game_set_thread_count(int threads); /* threads for parallel phases incl. the caller; returns the count in use (1 unless GAME_THREADS) */
+float game_get_interpolation_alpha(void);
 void game_get_player_position(float* x, float* y, float* z);
 float game_get_player_x(void);
 float game_get_player_y(void);
@@ -22,6 +147,7 @@ float game_get_front_x(void);
 float game_get_front_y(void);
 float game_get_front_z(void);
 int game_get_projectile_count(void);
+int game_spawn_projectile(float x, float y, float z, float vx, float vy, float vz); /* slot index, or -1 when full */
 void game_get_projectile(int i, float* x, float* y, float* z, float* vx, float* vy, float* vz);
 float game_get_projectile_x(int i);
 float game_get_projectile_y(int i);
@@ -32,11 +158,102 @@ float game_get_obstacle_x(int i);
 float game_get_obstacle_y(int i);
 float game_get_obstacle_z(int i);
 float game_get_obstacle_rotation(int i);
+double game_get_obstacle_rotation_time(void);
+double game_get_sim_time(void);
 unsigned int game_get_obstacle_color(int i);
 int game_get_obstacle_type(int i);
+float game_get_terrain_height(float x, float z);
+void game_get_terrain_normal(float x, float z, float* nx, float* ny, float* nz);
+float game_get_terrain_max_error(void); /* heightfield vs analytic terrain; 0 in reference mode */
+int game_raycast(float ox, float oy, float oz, float dx, float dy, float dz, float max_dist,
+                 float* out_dist, float* out_nx, float* out_ny, float* out_nz);
+int game_raycast_batch(int count); /* GAME_BUFFER_RAYS[0, count) -> GAME_BUFFER_RAY_HITS; returns rays that hit */
+int game_cull_obstacles(void); /* GAME_BUFFER_CULL_PARAMS -> GAME_BUFFER_VISIBLE_*; returns visible obstacles */
+int game_get_world_version(void);
+float game_get_world_half_size(void); /* 0 = unbounded (WORLD_STREAMING) */
+int game_get_state_size(void);             /* most bytes game_snapshot writes (a full projectile array) */
+int game_snapshot(void* buf);              /* copies all mutable simulation state to buf; returns bytes written */
+int game_restore(const void* buf);         /* 1 on success, 0 if buf is from another version or build config */
+unsigned int game_get_tick(void);          /* ticks simulated since game_init */
+unsigned int game_snapshot_push(void);     /* current state into the ring, dropping the oldest for room; returns its tick */
+int game_snapshot_rewind(int back);        /* restores the snapshot pushed `back` pushes ago (0 = newest), drops newer ones */
+int game_get_snapshot_count(void);         /* snapshots held in the ring */
+void game_record_start(void);          /* restarts the game (game_init) and logs every game_update from here */
+int game_record_stop(void);            /* returns the log size in bytes */
+int game_get_record_size(void);
+unsigned long long game_state_hash(void); /* 64-bit hash of all simulation state (live entries only) */
+const GameStats* game_get_stats(void); /* 0 unless built with GAME_STATS */
+#if GAME_STATS && !defined(__EMSCRIPTEN__)
+int game_trace_begin(const char* path); /* native only: write every timed phase to a Chrome trace (chrome://tracing) */
+void game_trace_end(void);
+#endif
 int game_get_is_moving(void);
 int game_get_is_in_air(void);
 float game_get_run_time(void);
+const void* game_get_buffer(int id);
+int game_get_buffer_stride(int id); /* bytes between consecutive elements */
+int game_get_buffer_count(int id);  /* elements the buffer holds (capacity) */
+
+/* Worlds: independent simulations in one process, e.g. headless matches for bots or load tests. Everything
+   above acts on the default world. Worlds share the obstacle layout, terrain and collision structures
+   (read-only); each one owns a snapshot-sized arena, so about game_get_state_size() bytes plus a frame
+   block. Snapshots, the rewind ring and input recording serve the default world only. WORLD_STREAMING
+   worlds share one set of chunk slots, so stepping worlds whose windows differ regenerates chunks each time. */
+typedef struct GameWorld GameWorld;
+typedef struct {
+  float dt;
+  unsigned int keys_mask;
+  float mouse_dx, mouse_dy;
+  int shoot;
+} GameInput; /* the arguments of one game_update */
+GameWorld* game_world_default(void);
+GameWorld* game_world_create(void);    /* a new world in its game_init state; 0 when out of memory */
+void game_world_destroy(GameWorld* w); /* no-op for the default world */
+void game_world_update(GameWorld* w, float dt, unsigned int keys_mask, float mouse_dx, float mouse_dy, int shoot);
+void game_worlds_update(GameWorld* const* worlds, int n, const GameInput* inputs); /* inputs[i] drives worlds[i] */
+const float* game_world_get_frame(const GameWorld* w); /* float[GAME_FRAME_FLOATS], as GAME_BUFFER_FRAME */
+unsigned long long game_world_state_hash(const GameWorld* w);
+
+/* Replication: per-client snapshots of a world, quantized and bit-packed as deltas against the newest snapshot
+   the client acknowledged (netcode.h), so a server sends only what changed. A client receives the projectiles
+   and obstacles within a radius of its view point in XZ (default: the world's player, GAME_NET_VIEW_RADIUS).
+   Obstacles go as base rotation and speed, which never change, so one at rest costs a bit per snapshot; the
+   replica evaluates rotation = base + speed * time itself. A replica decodes the packets on the client and
+   reads the newest snapshot back. Entity ids are projectile and obstacle indices of the server world. */
+#ifndef GAME_NET_MAX_CLIENTS
+#define GAME_NET_MAX_CLIENTS 16
+#endif
+#ifndef GAME_NET_MAX_OBSTACLES
+#define GAME_NET_MAX_OBSTACLES 2048 /* per snapshot; further obstacles in view wait for a later one */
+#endif
+#define GAME_NET_VIEW_RADIUS 64.f
+#define GAME_NET_PLAYER 0      /* entity classes, each with its fields */
+#define GAME_NET_PROJECTILES 1
+#define GAME_NET_OBSTACLES 2
+#define GAME_NET_CLASSES 3
+#define GAME_NET_X 0           /* all classes */
+#define GAME_NET_Y 1
+#define GAME_NET_Z 2
+#define GAME_NET_YAW 3         /* player */
+#define GAME_NET_PITCH 4
+#define GAME_NET_TIME 5        /* seconds of sim time, to ms; 0 when OBSTACLE_ROTATION_ANALYTIC=0 */
+#define GAME_NET_ROTATION 3    /* obstacles: radians at the snapshot's GAME_NET_TIME */
+#define GAME_NET_SPEED 4       /* radians per second, exact */
+#define GAME_NET_COLOR 5       /* 0xRRGGBB, exact as a float */
+#define GAME_NET_TYPE 6
+typedef struct GameNetReplica GameNetReplica;
+int game_net_client_open(const GameWorld* w); /* w = 0: the default world; returns the client, or -1 */
+void game_net_client_close(int client);
+void game_net_client_view(int client, float x, float z, float radius); /* radius <= 0: back to following the player */
+int game_net_encode(int client, unsigned char* out, int capacity); /* the world now; bytes, or -1 if out is too small */
+void game_net_ack(int client, unsigned int seq);                    /* seq from game_net_replica_apply */
+GameNetReplica* game_net_replica_create(void);
+void game_net_replica_destroy(GameNetReplica* r);
+unsigned int game_net_replica_apply(GameNetReplica* r, const unsigned char* data, int size); /* seq to ack, 0 = undecodable */
+unsigned int game_net_replica_tick(const GameNetReplica* r); /* ticks simulated at the newest snapshot */
+int game_net_replica_count(const GameNetReplica* r, int cls);
+unsigned int game_net_replica_id(const GameNetReplica* r, int cls, int i);
+float game_net_replica_field(const GameNetReplica* r, int cls, int i, int field);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,204 @@
+#ifndef NARROWPHASE_H
+#define NARROWPHASE_H
+
+/* Batched narrowphase kernels over structure-of-arrays obstacle shapes.
+   Each kernel scans slots [begin, end) NP_LANES at a time and returns the first slot that hits, or end.
+   The vector path is picked at build time: WASM SIMD128 (emcc -msimd128), AVX (8 lanes), SSE2, else scalar;
+   -DNP_NO_SIMD forces the scalar path.
+   Arrays must have NP_PADDING readable floats past the last slot; lanes past end are masked off.
+   Lane math matches the scalar tests in game.c operation for operation, so results are bit-identical. */
+
+#if defined(NP_NO_SIMD)
+#define NP_SCALAR 1
+#define NP_LANES 1
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define NP_LANES 4
+typedef v128_t np_vf;
+#define np_load(p)      wasm_v128_load(p)
+#define np_set1(x)      wasm_f32x4_splat(x)
+#define np_add(a, b)    wasm_f32x4_add(a, b)
+#define np_sub(a, b)    wasm_f32x4_sub(a, b)
+#define np_mul(a, b)    wasm_f32x4_mul(a, b)
+#define np_min(a, b)    wasm_f32x4_pmin(a, b)
+#define np_max(a, b)    wasm_f32x4_pmax(a, b)
+#define np_lt(a, b)     wasm_f32x4_lt(a, b)
+#define np_and(a, b)    wasm_v128_and(a, b)
+#define np_or(a, b)     wasm_v128_or(a, b)
+#define np_andnot(m, a) wasm_v128_andnot(a, m) /* a & ~m */
+#define np_bits(m)      ((unsigned int)wasm_i32x4_bitmask(m))
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define NP_LANES 8
+typedef __m256 np_vf;
+#define np_load(p)      _mm256_loadu_ps(p)
+#define np_set1(x)      _mm256_set1_ps(x)
+#define np_add(a, b)    _mm256_add_ps(a, b)
+#define np_sub(a, b)    _mm256_sub_ps(a, b)
+#define np_mul(a, b)    _mm256_mul_ps(a, b)
+#define np_min(a, b)    _mm256_min_ps(a, b)
+#define np_max(a, b)    _mm256_max_ps(a, b)
+#define np_lt(a, b)     _mm256_cmp_ps(a, b, _CMP_LT_OQ)
+#define np_and(a, b)    _mm256_and_ps(a, b)
+#define np_or(a, b)     _mm256_or_ps(a, b)
+#define np_andnot(m, a) _mm256_andnot_ps(m, a)
+#define np_bits(m)      ((unsigned int)_mm256_movemask_ps(m))
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define NP_LANES 4
+typedef __m128 np_vf;
+#define np_load(p)      _mm_loadu_ps(p)
+#define np_set1(x)      _mm_set1_ps(x)
+#define np_add(a, b)    _mm_add_ps(a, b)
+#define np_sub(a, b)    _mm_sub_ps(a, b)
+#define np_mul(a, b)    _mm_mul_ps(a, b)
+#define np_min(a, b)    _mm_min_ps(a, b)
+#define np_max(a, b)    _mm_max_ps(a, b)
+#define np_lt(a, b)     _mm_cmplt_ps(a, b)
+#define np_and(a, b)    _mm_and_ps(a, b)
+#define np_or(a, b)     _mm_or_ps(a, b)
+#define np_andnot(m, a) _mm_andnot_ps(m, a)
+#define np_bits(m)      ((unsigned int)_mm_movemask_ps(m))
+#else
+#define NP_SCALAR 1
+#define NP_LANES 1
+#endif
+
+#define NP_PADDING 8
+
+/* Obstacle shapes in slot order. Spheres (is_sphere = 1) use their center and radius, everything else its AABB. */
+typedef struct {
+  float* min_x; float* min_y; float* min_z;
+  float* max_x; float* max_y; float* max_z;
+  float* center_x; float* center_y; float* center_z;
+  float* is_sphere; /* 1.0f or 0.0f */
+  float sphere_radius;
+} NpShapes;
+
+#ifndef NP_SCALAR
+static inline unsigned int np_lane_mask(int remaining) {
+  return remaining >= NP_LANES ? (1u << NP_LANES) - 1u : (1u << remaining) - 1u;
+}
+
+static inline int np_first_bit(unsigned int bits) {
+  int i = 0;
+  while (!(bits & 1u)) { bits >>= 1; i++; }
+  return i;
+}
+
+/* Squared distance from point (px, py, pz) to lanes' AABBs */
+static inline np_vf np_point_aabb_dist_sq(np_vf px, np_vf py, np_vf pz,
+                                          np_vf min_x, np_vf min_y, np_vf min_z,
+                                          np_vf max_x, np_vf max_y, np_vf max_z) {
+  np_vf dx = np_sub(px, np_max(min_x, np_min(px, max_x)));
+  np_vf dy = np_sub(py, np_max(min_y, np_min(py, max_y)));
+  np_vf dz = np_sub(pz, np_max(min_z, np_min(pz, max_z)));
+  return np_add(np_add(np_mul(dx, dx), np_mul(dy, dy)), np_mul(dz, dz));
+}
+
+static inline np_vf np_box_aabb_overlap(const NpShapes* s, int k, const np_vf* bmin, const np_vf* bmax) {
+  np_vf m = np_and(np_lt(bmin[0], np_load(s->max_x + k)), np_lt(np_load(s->min_x + k), bmax[0]));
+  m = np_and(m, np_and(np_lt(bmin[1], np_load(s->max_y + k)), np_lt(np_load(s->min_y + k), bmax[1])));
+  return np_and(m, np_and(np_lt(bmin[2], np_load(s->max_z + k)), np_lt(np_load(s->min_z + k), bmax[2])));
+}
+#endif
+
+/* First slot whose AABB overlaps the box (strict overlap on all three axes). */
+static inline int np_first_box_aabb_hit(const NpShapes* s, int begin, int end,
+                                        float min_x, float min_y, float min_z,
+                                        float max_x, float max_y, float max_z) {
+#ifdef NP_SCALAR
+  for (int k = begin; k < end; k++) {
+    if (min_x < s->max_x[k] && max_x > s->min_x[k] &&
+        min_y < s->max_y[k] && max_y > s->min_y[k] &&
+        min_z < s->max_z[k] && max_z > s->min_z[k]) return k;
+  }
+  return end;
+#else
+  np_vf bmin[3] = { np_set1(min_x), np_set1(min_y), np_set1(min_z) };
+  np_vf bmax[3] = { np_set1(max_x), np_set1(max_y), np_set1(max_z) };
+  for (int k = begin; k < end; k += NP_LANES) {
+    unsigned int bits = np_bits(np_box_aabb_overlap(s, k, bmin, bmax)) & np_lane_mask(end - k);
+    if (bits) return k + np_first_bit(bits);
+  }
+  return end;
+#endif
+}
+
+/* First slot whose shape overlaps the box: spheres by closest point in the box, others by AABB overlap. */
+static inline int np_first_box_shape_hit(const NpShapes* s, int begin, int end,
+                                         float min_x, float min_y, float min_z,
+                                         float max_x, float max_y, float max_z) {
+#ifdef NP_SCALAR
+  float r_sq = s->sphere_radius * s->sphere_radius;
+  for (int k = begin; k < end; k++) {
+    if (s->is_sphere[k] > 0.5f) {
+      float cx = s->center_x[k], cy = s->center_y[k], cz = s->center_z[k];
+      float dx = cx - (cx < min_x ? min_x : (cx > max_x ? max_x : cx));
+      float dy = cy - (cy < min_y ? min_y : (cy > max_y ? max_y : cy));
+      float dz = cz - (cz < min_z ? min_z : (cz > max_z ? max_z : cz));
+      if (dx*dx + dy*dy + dz*dz < r_sq) return k;
+    } else if (min_x < s->max_x[k] && max_x > s->min_x[k] &&
+               min_y < s->max_y[k] && max_y > s->min_y[k] &&
+               min_z < s->max_z[k] && max_z > s->min_z[k]) {
+      return k;
+    }
+  }
+  return end;
+#else
+  np_vf bmin[3] = { np_set1(min_x), np_set1(min_y), np_set1(min_z) };
+  np_vf bmax[3] = { np_set1(max_x), np_set1(max_y), np_set1(max_z) };
+  np_vf r_sq = np_set1(s->sphere_radius * s->sphere_radius);
+  np_vf half = np_set1(0.5f);
+  for (int k = begin; k < end; k += NP_LANES) {
+    np_vf sphere = np_lt(half, np_load(s->is_sphere + k));
+    np_vf box_hit = np_box_aabb_overlap(s, k, bmin, bmax);
+    np_vf d_sq = np_point_aabb_dist_sq(np_load(s->center_x + k), np_load(s->center_y + k), np_load(s->center_z + k),
+                                       bmin[0], bmin[1], bmin[2], bmax[0], bmax[1], bmax[2]);
+    np_vf hit = np_or(np_and(sphere, np_lt(d_sq, r_sq)), np_andnot(sphere, box_hit));
+    unsigned int bits = np_bits(hit) & np_lane_mask(end - k);
+    if (bits) return k + np_first_bit(bits);
+  }
+  return end;
+#endif
+}
+
+/* First slot whose shape overlaps the sphere: sphere-sphere against spheres, sphere-AABB otherwise. */
+static inline int np_first_sphere_shape_hit(const NpShapes* s, int begin, int end,
+                                            float sx, float sy, float sz, float radius) {
+  float sum_r = radius + s->sphere_radius;
+#ifdef NP_SCALAR
+  for (int k = begin; k < end; k++) {
+    if (s->is_sphere[k] > 0.5f) {
+      float dx = sx - s->center_x[k], dy = sy - s->center_y[k], dz = sz - s->center_z[k];
+      if (dx*dx + dy*dy + dz*dz < sum_r * sum_r) return k;
+    } else {
+      float dx = sx - (sx < s->min_x[k] ? s->min_x[k] : (sx > s->max_x[k] ? s->max_x[k] : sx));
+      float dy = sy - (sy < s->min_y[k] ? s->min_y[k] : (sy > s->max_y[k] ? s->max_y[k] : sy));
+      float dz = sz - (sz < s->min_z[k] ? s->min_z[k] : (sz > s->max_z[k] ? s->max_z[k] : sz));
+      if (dx*dx + dy*dy + dz*dz < radius * radius) return k;
+    }
+  }
+  return end;
+#else
+  np_vf px = np_set1(sx), py = np_set1(sy), pz = np_set1(sz);
+  np_vf r_sq = np_set1(radius * radius), sum_sq = np_set1(sum_r * sum_r);
+  np_vf half = np_set1(0.5f);
+  for (int k = begin; k < end; k += NP_LANES) {
+    np_vf sphere = np_lt(half, np_load(s->is_sphere + k));
+    np_vf dx = np_sub(px, np_load(s->center_x + k));
+    np_vf dy = np_sub(py, np_load(s->center_y + k));
+    np_vf dz = np_sub(pz, np_load(s->center_z + k));
+    np_vf c_sq = np_add(np_add(np_mul(dx, dx), np_mul(dy, dy)), np_mul(dz, dz));
+    np_vf b_sq = np_point_aabb_dist_sq(px, py, pz,
+                                       np_load(s->min_x + k), np_load(s->min_y + k), np_load(s->min_z + k),
+                                       np_load(s->max_x + k), np_load(s->max_y + k), np_load(s->max_z + k));
+    np_vf hit = np_or(np_and(sphere, np_lt(c_sq, sum_sq)), np_andnot(sphere, np_lt(b_sq, r_sq)));
+    unsigned int bits = np_bits(hit) & np_lane_mask(end - k);
+    if (bits) return k + np_first_bit(bits);
+  }
+  return end;
+#endif
+}
+
+#endif /* NARROWPHASE_H */
@@ -0,0 +1,173 @@
+/* Headless benchmark of the whole core: times every game_init and game_update call and prints one JSON
+   line of percentiles per run, so results can be appended to a file and compared across commits.
+   Build natively from Test1/wasm with `make bench` (`make sweep` runs the standard configurations), or
+     cc -O2 -I. -I../../shared native/bench.c game.c -o bench -lm
+   Usage: bench [--ticks N] [--init-runs K] [--replay LOG] [--projectiles P] [--fixed HZ] [--tag STR]
+     --ticks N        game_update calls to time (default 2000); with --replay, at most N records
+     --init-runs K    game_init calls to time (default 5)
+     --replay LOG     drive updates from an input log (game_record_start) instead of the scripted walk
+     --projectiles P  keep at least P projectiles alive (capped by MAX_PROJECTILES); refills happen
+                      between timed updates through game_spawn_projectile
+     --fixed HZ       fixed simulation step (0 = variable, the default); ignored with --replay
+     --threads T      workers for the parallel phases (GAME_THREADS builds: make scaling)
+     --tag STR        copied into the output, e.g. the commit id
+     --trace FILE     Chrome trace of every timed phase (GAME_STATS builds: make bench DEFS=-DGAME_STATS=1)
+   GAME_STATS builds also report the mean GameStats of the timed updates under "stats". */
+#include "game.h"
+#include "native/input_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if GAME_STATS
+static const char* const stats_names[GAME_STATS_FIELDS] = {
+  "updates", "ticks", "update_ns", "move_ns", "vertical_ns", "world_ns", "projectile_ns", "projectile_pair_ns",
+  "rotation_ns", "obstacle_queries", "obstacle_hits", "pair_tests", "pair_hits", "spawns", "removals", "projectiles"
+};
+#endif
+
+static long long now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+static int cmp_ns(const void* a, const void* b) {
+  long long x = *(const long long*)a, y = *(const long long*)b;
+  return (x > y) - (x < y);
+}
+
+/* Sorts samples in place and prints {"p50":..,"p90":..,"p99":..,"max":..,"mean":..} (nearest rank) */
+static void print_percentiles(long long* samples, int n) {
+  if (n <= 0) {
+    printf("null");
+    return;
+  }
+  qsort(samples, (size_t)n, sizeof(long long), cmp_ns);
+  long long sum = 0;
+  for (int i = 0; i < n; i++) sum += samples[i];
+  printf("{\"p50\":%lld,\"p90\":%lld,\"p99\":%lld,\"max\":%lld,\"mean\":%lld}", samples[(n - 1) * 50 / 100],
+         samples[(n - 1) * 90 / 100], samples[(n - 1) * 99 / 100], samples[n - 1], sum / n);
+}
+
+static unsigned int bench_rng = 0x9E3779B9u;
+static float bench_float(float min_val, float max_val) {
+  bench_rng = bench_rng * 1664525u + 1013904223u;
+  return min_val + (max_val - min_val) * (float)(bench_rng >> 8) * (1.f / 16777216.f);
+}
+
+/* Fills up to `target` live projectiles around the player, flying outward in random directions */
+static void top_up_projectiles(int target) {
+  float px = game_get_player_x(), py = game_get_player_y(), pz = game_get_player_z();
+  while (game_get_projectile_count() < target) {
+    float x = px + bench_float(-20.f, 20.f), z = pz + bench_float(-20.f, 20.f);
+    if (game_spawn_projectile(x, py + bench_float(0.5f, 4.f), z, bench_float(-25.f, 25.f), bench_float(-2.f, 6.f),
+                              bench_float(-25.f, 25.f)) < 0)
+      break;
+  }
+}
+
+int main(int argc, char** argv) {
+  int ticks = 2000, init_runs = 5, projectiles = 0, threads = 1;
+  float fixed_hz = 0.f;
+  const char* log_path = 0;
+  const char* tag = "";
+  const char* trace_path = 0;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--ticks") && i + 1 < argc) ticks = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--init-runs") && i + 1 < argc) init_runs = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--replay") && i + 1 < argc) log_path = argv[++i];
+    else if (!strcmp(argv[i], "--projectiles") && i + 1 < argc) projectiles = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--fixed") && i + 1 < argc) fixed_hz = (float)atof(argv[++i]);
+    else if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--tag") && i + 1 < argc) tag = argv[++i];
+    else if (!strcmp(argv[i], "--trace") && i + 1 < argc) trace_path = argv[++i];
+    else {
+      fprintf(stderr, "usage: %s [--ticks N] [--init-runs K] [--replay LOG] [--projectiles P] [--fixed HZ] [--tag STR]"
+              " [--threads T] [--trace FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (init_runs < 1) init_runs = 1;
+  if (ticks < 0) ticks = 0;
+  if (projectiles > MAX_PROJECTILES) projectiles = MAX_PROJECTILES;
+  threads = game_set_thread_count(threads);
+#if GAME_STATS
+  if (trace_path && !game_trace_begin(trace_path)) {
+    fprintf(stderr, "%s: cannot write trace\n", trace_path);
+    return 2;
+  }
+  double stats_sum[GAME_STATS_FIELDS] = { 0 };
+#else
+  if (trace_path) {
+    fprintf(stderr, "--trace needs a GAME_STATS=1 build\n");
+    return 2;
+  }
+#endif
+
+  InputLog log;
+  if (log_path) {
+    if (!input_log_open(&log, log_path)) return 2;
+    fixed_hz = log.fixed_hz;
+  }
+  game_set_fixed_timestep(fixed_hz, log_path ? log.max_steps : 0);
+
+  long long* init_ns = (long long*)malloc(sizeof(long long) * (size_t)init_runs);
+  long long* update_ns = (long long*)malloc(sizeof(long long) * (size_t)(ticks > 0 ? ticks : 1));
+  if (!init_ns || !update_ns) return 2;
+  for (int i = 0; i < init_runs; i++) {
+    long long t0 = now_ns();
+    game_init();
+    init_ns[i] = now_ns() - t0;
+  }
+
+  /* Scripted input: walk forward, alternate strafing, jump and sprint now and then, sweep the view and
+     shoot every fifth update, with a jittered dt like a real frame loop */
+  int updates = 0;
+  long long live_projectiles = 0;
+  for (int k = 0; k < ticks; k++) {
+    InputFrame in;
+    if (log_path) {
+      if (!input_log_next(&log, &in)) break;
+    } else {
+      in.keys = 1 | ((k / 97) % 2 ? 8 : 4) | ((k % 53) < 3 ? 16 : 0) | ((k / 300) % 2 ? 32 : 0); /* W, D/A, Space, Shift */
+      in.mouse_dx = (float)((k / 40) % 3 - 1) * 7.f;
+      in.mouse_dy = (float)((k / 70) % 3 - 1) * 2.f;
+      in.shoot = (k % 5) == 0;
+      in.dt = 1.f / 60.f + (float)(k % 7) * 0.002f;
+    }
+    if (projectiles > 0) top_up_projectiles(projectiles);
+    live_projectiles += game_get_projectile_count();
+    long long t0 = now_ns();
+    game_update(in.dt, in.keys, in.mouse_dx, in.mouse_dy, in.shoot);
+    update_ns[updates++] = now_ns() - t0;
+#if GAME_STATS
+    const unsigned int* fields = (const unsigned int*)game_get_stats();
+    for (int f = 0; f < GAME_STATS_FIELDS; f++) stats_sum[f] += fields[f];
+#endif
+  }
+#if GAME_STATS
+  game_trace_end();
+#endif
+
+  printf("{\"game\":\"test1\",\"tag\":\"%s\",\"input\":\"%s\",\"num_obstacles\":%d,\"max_projectiles\":%d,"
+         "\"projectiles\":%d,\"avg_live_projectiles\":%lld,\"fixed_hz\":%g,\"threads\":%d,\"ticks\":%d,\"init_ns\":",
+         tag, log_path ? "replay" : "scripted", NUM_OBSTACLES, MAX_PROJECTILES, projectiles,
+         updates ? live_projectiles / updates : 0, (double)fixed_hz, threads, updates);
+  print_percentiles(init_ns, init_runs);
+  printf(",\"update_ns\":");
+  print_percentiles(update_ns, updates);
+#if GAME_STATS
+  printf(",\"stats\":{");
+  for (int f = 1; f < GAME_STATS_FIELDS; f++)
+    printf("%s\"%s\":%.1f", f > 1 ? "," : "", stats_names[f], updates ? stats_sum[f] / updates : 0.0);
+  printf("}");
+#endif
+  printf(",\"hash\":\"%016llx\"}\n", game_state_hash());
+
+  if (log_path) input_log_close(&log);
+  free(init_ns);
+  free(update_ns);
+  return 0;
+}
@@ -0,0 +1,136 @@
+/* Narrowphase microbenchmark: batched SoA kernels (narrowphase.h) vs the per-obstacle scalar tests they replaced.
+   Build natively from Test1/wasm, e.g.
+     cc -O2 -I. native/bench_narrowphase.c -o bench_narrowphase -lm                 (SSE2)
+     cc -O2 -mavx -I. native/bench_narrowphase.c -o bench_narrowphase_avx -lm       (AVX, 8 lanes)
+     cc -O2 -DNP_NO_SIMD -I. native/bench_narrowphase.c -o bench_narrowphase_scalar -lm
+   Every query scans all shapes and counts hits, so both sides do the same amount of work. */
+#include "narrowphase.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define SHAPES 4096
+#define QUERIES 4096
+#define HALF_EXTENT 0.5f
+#define TRIANGLE_HALF_Y 0.25f
+#define SPHERE_RADIUS 0.5f
+#define QUERY_RADIUS 0.15f
+
+typedef struct { float x, y, z; } Vec3;
+
+static Vec3 centers[SHAPES];
+static unsigned char types[SHAPES]; /* 0=cube, 1=sphere, 2=triangle */
+static float min_x[SHAPES + NP_PADDING], min_y[SHAPES + NP_PADDING], min_z[SHAPES + NP_PADDING];
+static float max_x[SHAPES + NP_PADDING], max_y[SHAPES + NP_PADDING], max_z[SHAPES + NP_PADDING];
+static float center_x[SHAPES + NP_PADDING], center_y[SHAPES + NP_PADDING], center_z[SHAPES + NP_PADDING];
+static float is_sphere[SHAPES + NP_PADDING];
+static Vec3 queries[QUERIES];
+
+static unsigned int rng_state = 12345u;
+static float rng_float(float min_val, float max_val) {
+  unsigned int x = rng_state;
+  x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+  rng_state = x;
+  return min_val + (max_val - min_val) * ((float)(x % 65536u) / 65536.f);
+}
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* The pre-SIMD path: AABB rebuilt from the type on every test, branchy scalar overlap tests */
+static void bounds_from_type(int i, float* mn, float* mx) {
+  float hy = types[i] == 2 ? TRIANGLE_HALF_Y : HALF_EXTENT;
+  mn[0] = centers[i].x - HALF_EXTENT; mn[1] = centers[i].y - hy; mn[2] = centers[i].z - HALF_EXTENT;
+  mx[0] = centers[i].x + HALF_EXTENT; mx[1] = centers[i].y + hy; mx[2] = centers[i].z + HALF_EXTENT;
+}
+
+static int scalar_sphere_hits(float sx, float sy, float sz, float r) {
+  int hits = 0;
+  for (int i = 0; i < SHAPES; i++) {
+    float mn[3], mx[3];
+    bounds_from_type(i, mn, mx);
+    if (types[i] == 1) {
+      float dx = sx - centers[i].x, dy = sy - centers[i].y, dz = sz - centers[i].z;
+      float sum_r = r + SPHERE_RADIUS;
+      if (dx*dx + dy*dy + dz*dz < sum_r * sum_r) hits++;
+    } else {
+      float cx = sx < mn[0] ? mn[0] : (sx > mx[0] ? mx[0] : sx);
+      float cy = sy < mn[1] ? mn[1] : (sy > mx[1] ? mx[1] : sy);
+      float cz = sz < mn[2] ? mn[2] : (sz > mx[2] ? mx[2] : sz);
+      float dx = sx - cx, dy = sy - cy, dz = sz - cz;
+      if (dx*dx + dy*dy + dz*dz < r * r) hits++;
+    }
+  }
+  return hits;
+}
+
+static int scalar_box_hits(const float* bmin, const float* bmax) {
+  int hits = 0;
+  for (int i = 0; i < SHAPES; i++) {
+    float mn[3], mx[3];
+    bounds_from_type(i, mn, mx);
+    if (bmin[0] < mx[0] && bmax[0] > mn[0] && bmin[1] < mx[1] && bmax[1] > mn[1] &&
+        bmin[2] < mx[2] && bmax[2] > mn[2]) hits++;
+  }
+  return hits;
+}
+
+int main(void) {
+  const float span = 40.f;
+  for (int i = 0; i < SHAPES; i++) {
+    centers[i].x = rng_float(-span, span);
+    centers[i].y = rng_float(0.f, 2.f);
+    centers[i].z = rng_float(-span, span);
+    types[i] = (unsigned char)(rng_float(0.f, 3.f));
+    float mn[3], mx[3];
+    bounds_from_type(i, mn, mx);
+    min_x[i] = mn[0]; min_y[i] = mn[1]; min_z[i] = mn[2];
+    max_x[i] = mx[0]; max_y[i] = mx[1]; max_z[i] = mx[2];
+    center_x[i] = centers[i].x; center_y[i] = centers[i].y; center_z[i] = centers[i].z;
+    is_sphere[i] = types[i] == 1 ? 1.f : 0.f;
+  }
+  for (int q = 0; q < QUERIES; q++) {
+    queries[q].x = rng_float(-span, span);
+    queries[q].y = rng_float(0.f, 2.f);
+    queries[q].z = rng_float(-span, span);
+  }
+  NpShapes shapes = { min_x, min_y, min_z, max_x, max_y, max_z, center_x, center_y, center_z, is_sphere, SPHERE_RADIUS };
+
+  double t0 = now_sec();
+  long scalar_sphere = 0, scalar_box = 0;
+  for (int q = 0; q < QUERIES; q++)
+    scalar_sphere += scalar_sphere_hits(queries[q].x, queries[q].y, queries[q].z, QUERY_RADIUS);
+  double t1 = now_sec();
+  for (int q = 0; q < QUERIES; q++) {
+    float bmin[3] = { queries[q].x - HALF_EXTENT, queries[q].y - HALF_EXTENT, queries[q].z - HALF_EXTENT };
+    float bmax[3] = { queries[q].x + HALF_EXTENT, queries[q].y + HALF_EXTENT, queries[q].z + HALF_EXTENT };
+    scalar_box += scalar_box_hits(bmin, bmax);
+  }
+  double t2 = now_sec();
+
+  long batched_sphere = 0, batched_box = 0;
+  for (int q = 0; q < QUERIES; q++) {
+    for (int k = 0; (k = np_first_sphere_shape_hit(&shapes, k, SHAPES, queries[q].x, queries[q].y, queries[q].z,
+                                                   QUERY_RADIUS)) < SHAPES; k++)
+      batched_sphere++;
+  }
+  double t3 = now_sec();
+  for (int q = 0; q < QUERIES; q++) {
+    Vec3 c = queries[q];
+    for (int k = 0; (k = np_first_box_aabb_hit(&shapes, k, SHAPES, c.x - HALF_EXTENT, c.y - HALF_EXTENT, c.z - HALF_EXTENT,
+                                               c.x + HALF_EXTENT, c.y + HALF_EXTENT, c.z + HALF_EXTENT)) < SHAPES; k++)
+      batched_box++;
+  }
+  double t4 = now_sec();
+
+  double tests = (double)SHAPES * QUERIES;
+  printf("lanes %d, %d shapes x %d queries\n", NP_LANES, SHAPES, QUERIES);
+  printf("sphere vs shapes: scalar %.2f ns/test, batched %.2f ns/test, speedup %.2fx (hits %ld / %ld)\n",
+         (t1 - t0) * 1e9 / tests, (t3 - t2) * 1e9 / tests, (t1 - t0) / (t3 - t2), scalar_sphere, batched_sphere);
+  printf("box vs AABBs:     scalar %.2f ns/test, batched %.2f ns/test, speedup %.2fx (hits %ld / %ld)\n",
+         (t2 - t1) * 1e9 / tests, (t4 - t3) * 1e9 / tests, (t2 - t1) / (t4 - t3), scalar_box, batched_box);
+  return (scalar_sphere == batched_sphere && scalar_box == batched_box) ? 0 : 1;
+}
@@ -0,0 +1,297 @@
+/* Loopback replication benchmark: runs the default world on bench's scripted input and, every update, encodes a
+   snapshot for C clients, drops packets and acks at the given rate, decodes the rest into one replica per
+   client and checks it against the world. Client 0 follows the player; client c > 0 watches a fixed circle
+   of GAME_NET_VIEW_RADIUS, c * VIEW_STEP along +x from the spawn point. Prints one JSON line with bytes per
+   packet, encode and decode percentiles, and the size of client 0's snapshot without a baseline
+   ("full_bytes").
+   Build natively from Test1/wasm with `make net_loopback` (`make net` runs it), or
+     cc -O2 -I. -I../../shared native/net_loopback.c game.c -o net_loopback -lm
+   Usage: net_loopback [--ticks N] [--clients C] [--loss PCT] [--latency L] [--reorder PCT] [--tag STR]
+     --ticks N    updates (default 600)
+     --clients C  clients (default 4)
+     --loss PCT   share of packets and of acks lost (default 5)
+     --latency L  updates before an ack reaches the server (default 4)
+     --reorder PCT  share of the packets that get through arriving 1..MAX_DELAY updates late instead, each
+                    first as a cut-short copy (default 0)
+     --tag STR    copied into the output, e.g. the commit id
+   "mismatches" counts replicated values off by more than their quantization, replicas holding the wrong
+   projectiles or obstacles, late packets that move a replica back to an older tick and cut-short copies that
+   decode; it must be 0, and so must "decode_failures" (packets arriving in order that do not decode). "stale"
+   counts late packets the replica rejected: NET_HISTORY or more behind, or beaten to their slot.
+   Before the run a fixed case applies one client's packets out of order with cut-short copies among them
+   ("out_of_order_failures", see out_of_order_case). Exits 1 unless all three counts are 0. */
+#include "game.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define PACKET_CAPACITY (1 << 20)
+#define VIEW_STEP 96.f
+#define MAX_LATENCY 64
+#define MAX_DELAY 24 /* past NET_HISTORY, so some late packets are too old to keep */
+#define ORDER_PACKETS 20 /* more than NET_HISTORY, so late packets share slots with newer ones */
+
+static long long now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+static int cmp_ns(const void* a, const void* b) {
+  long long x = *(const long long*)a, y = *(const long long*)b;
+  return (x > y) - (x < y);
+}
+
+/* Sorts samples in place and prints {"p50":..,"p90":..,"p99":..,"max":..,"mean":..} (nearest rank) */
+static void print_percentiles(long long* samples, int n) {
+  if (n <= 0) {
+    printf("null");
+    return;
+  }
+  qsort(samples, (size_t)n, sizeof(long long), cmp_ns);
+  long long sum = 0;
+  for (int i = 0; i < n; i++) sum += samples[i];
+  printf("{\"p50\":%lld,\"p90\":%lld,\"p99\":%lld,\"max\":%lld,\"mean\":%lld}", samples[(n - 1) * 50 / 100],
+         samples[(n - 1) * 90 / 100], samples[(n - 1) * 99 / 100], samples[n - 1], sum / n);
+}
+
+static unsigned int loss_rng = 0x2545F491u;
+static int lost(int percent) {
+  loss_rng = loss_rng * 1664525u + 1013904223u;
+  return (int)((loss_rng >> 8) % 100u) < percent;
+}
+
+static int off(float got, float want, float tolerance) { return !(fabsf(got - want) <= tolerance); }
+
+static int off_angle(float got, float want, float tolerance) {
+  float d = fmodf(got - want, 6.28318530718f);
+  if (d > 3.14159265359f) d -= 6.28318530718f;
+  if (d < -3.14159265359f) d += 6.28318530718f;
+  return !(fabsf(d) <= tolerance);
+}
+
+/* Checks the replica's newest snapshot against the world it was just taken from */
+static int verify(const GameNetReplica* r, float cx, float cz, float radius) {
+  int bad = 0;
+  float pos_tol = 0.5f / 256.f + 0.002f; /* half a quantum plus float rounding of the offset */
+  float angle_tol = 3.14159265359f / 65536.f + 1e-4f;
+  float x, y, z, yaw, pitch;
+  game_get_player_position(&x, &y, &z);
+  game_get_player_rotation(&yaw, &pitch);
+  bad += game_net_replica_count(r, GAME_NET_PLAYER) != 1;
+  bad += off(game_net_replica_field(r, GAME_NET_PLAYER, 0, GAME_NET_X), x, pos_tol);
+  bad += off(game_net_replica_field(r, GAME_NET_PLAYER, 0, GAME_NET_Y), y, pos_tol);
+  bad += off(game_net_replica_field(r, GAME_NET_PLAYER, 0, GAME_NET_Z), z, pos_tol);
+  bad += off_angle(game_net_replica_field(r, GAME_NET_PLAYER, 0, GAME_NET_YAW), yaw, angle_tol);
+  bad += off_angle(game_net_replica_field(r, GAME_NET_PLAYER, 0, GAME_NET_PITCH), pitch, angle_tol);
+
+  float r_sq = radius * radius;
+  int n = game_net_replica_count(r, GAME_NET_PROJECTILES), expected = 0;
+  for (int i = 0; i < game_get_projectile_count(); i++) {
+    float dx = game_get_projectile_x(i) - cx, dz = game_get_projectile_z(i) - cz;
+    expected += dx * dx + dz * dz <= r_sq;
+  }
+  bad += n != expected;
+  for (int i = 0; i < n; i++) {
+    int id = (int)game_net_replica_id(r, GAME_NET_PROJECTILES, i);
+    bad += off(game_net_replica_field(r, GAME_NET_PROJECTILES, i, GAME_NET_X), game_get_projectile_x(id), pos_tol);
+    bad += off(game_net_replica_field(r, GAME_NET_PROJECTILES, i, GAME_NET_Y), game_get_projectile_y(id), pos_tol);
+    bad += off(game_net_replica_field(r, GAME_NET_PROJECTILES, i, GAME_NET_Z), game_get_projectile_z(id), pos_tol);
+  }
+
+  n = game_net_replica_count(r, GAME_NET_OBSTACLES);
+  expected = 0;
+  for (int i = 0; i < game_get_obstacle_count(); i++) {
+    float dx = game_get_obstacle_x(i) - cx, dz = game_get_obstacle_z(i) - cz;
+    expected += game_get_obstacle_type(i) != GAME_OBSTACLE_TYPE_EMPTY && dx * dx + dz * dz <= r_sq;
+  }
+  bad += n != (expected < GAME_NET_MAX_OBSTACLES ? expected : GAME_NET_MAX_OBSTACLES);
+  for (int i = 0; i < n; i++) {
+    int id = (int)game_net_replica_id(r, GAME_NET_OBSTACLES, i);
+    bad += off(game_net_replica_field(r, GAME_NET_OBSTACLES, i, GAME_NET_X), game_get_obstacle_x(id), pos_tol);
+    bad += off(game_net_replica_field(r, GAME_NET_OBSTACLES, i, GAME_NET_Y), game_get_obstacle_y(id), pos_tol);
+    bad += off(game_net_replica_field(r, GAME_NET_OBSTACLES, i, GAME_NET_Z), game_get_obstacle_z(id), pos_tol);
+    /* the base rotation's quantization plus the snapshot time's (1 ms) times the speed (< 3 rad/s) */
+    bad += off_angle(game_net_replica_field(r, GAME_NET_OBSTACLES, i, GAME_NET_ROTATION), game_get_obstacle_rotation(id),
+                     angle_tol + 3.f * 0.0005f + 1e-4f);
+    bad += (unsigned int)game_net_replica_field(r, GAME_NET_OBSTACLES, i, GAME_NET_COLOR) != game_get_obstacle_color(id);
+    bad += (int)game_net_replica_field(r, GAME_NET_OBSTACLES, i, GAME_NET_TYPE) != game_get_obstacle_type(id);
+  }
+  return bad;
+}
+
+/* Encodes ORDER_PACKETS updates for a client following the player and applies some of them out of order,
+   with cut-short copies of the newest packet and of a packet not yet received, and a late packet whose
+   history slot holds the newest snapshot. The replica's tick must never go back, no cut-short copy may
+   decode, and the replica must end on the last packet, matching the world. Returns the failures. */
+static int out_of_order_case(unsigned char* packet) {
+  static const int order[] = { 0, 2, 1, 5, 3, -5, 4, 18, 2, -19, 17, 19, 3 }; /* -k: packet k cut to half */
+  unsigned char* sent[ORDER_PACKETS];
+  int sizes[ORDER_PACKETS], bad = 0;
+  game_init();
+  int id = game_net_client_open(0);
+  GameNetReplica* r = game_net_replica_create();
+  if (id < 0 || !r) return 1;
+  for (int k = 0; k < ORDER_PACKETS; k++) {
+    game_update(1.f / 60.f, 1 | 8, 7.f, 0.f, 1);
+    sizes[k] = game_net_encode(id, packet, PACKET_CAPACITY);
+    sent[k] = (unsigned char*)malloc(sizes[k] > 0 ? (size_t)sizes[k] : 1);
+    if (sizes[k] <= 0 || !sent[k]) return 1;
+    memcpy(sent[k], packet, (size_t)sizes[k]);
+  }
+  unsigned int tick = 0;
+  for (size_t o = 0; o < sizeof(order) / sizeof(order[0]); o++) {
+    int k = order[o] < 0 ? -order[o] : order[o];
+    unsigned int seq = game_net_replica_apply(r, sent[k], order[o] < 0 ? sizes[k] / 2 : sizes[k]);
+    bad += order[o] < 0 && seq != 0;
+    bad += game_net_replica_tick(r) < tick;
+    tick = game_net_replica_tick(r);
+  }
+  bad += verify(r, game_get_player_x(), game_get_player_z(), GAME_NET_VIEW_RADIUS);
+  for (int k = 0; k < ORDER_PACKETS; k++) free(sent[k]);
+  game_net_replica_destroy(r);
+  game_net_client_close(id);
+  return bad;
+}
+
+typedef struct {
+  int due;
+  int client;
+  unsigned int seq;
+} Ack;
+
+typedef struct {
+  int due;
+  int client;
+  int size;
+  unsigned char* data;
+} Late;
+
+int main(int argc, char** argv) {
+  int ticks = 600, clients = 4, loss = 5, latency = 4, reorder = 0;
+  const char* tag = "";
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--ticks") && i + 1 < argc) ticks = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--clients") && i + 1 < argc) clients = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--loss") && i + 1 < argc) loss = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--latency") && i + 1 < argc) latency = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--reorder") && i + 1 < argc) reorder = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--tag") && i + 1 < argc) tag = argv[++i];
+    else {
+      fprintf(stderr, "usage: %s [--ticks N] [--clients C] [--loss PCT] [--latency L] [--reorder PCT] [--tag STR]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (ticks < 0) ticks = 0;
+  if (clients < 1) clients = 1;
+  if (clients > GAME_NET_MAX_CLIENTS - 1) clients = GAME_NET_MAX_CLIENTS - 1; /* one more measures full snapshots */
+  if (latency < 0) latency = 0;
+  if (latency > MAX_LATENCY - 1) latency = MAX_LATENCY - 1;
+
+  unsigned char* packet = (unsigned char*)malloc(PACKET_CAPACITY);
+  if (!packet) return 2;
+  int order_failures = out_of_order_case(packet);
+
+  game_init();
+  int ids[GAME_NET_MAX_CLIENTS];
+  GameNetReplica* replicas[GAME_NET_MAX_CLIENTS];
+  for (int c = 0; c < clients; c++) {
+    ids[c] = game_net_client_open(0);
+    replicas[c] = game_net_replica_create();
+    if (ids[c] < 0 || !replicas[c]) return 2;
+    if (c > 0) game_net_client_view(ids[c], (float)c * VIEW_STEP, 3.f, GAME_NET_VIEW_RADIUS);
+  }
+  int full_client = game_net_client_open(0); /* never acks, so every snapshot is coded without a baseline */
+
+  int samples = ticks * clients;
+  long long* bytes = (long long*)malloc(sizeof(long long) * (size_t)(samples > 0 ? samples : 1));
+  long long* encode_ns = (long long*)malloc(sizeof(long long) * (size_t)(samples > 0 ? samples : 1));
+  long long* decode_ns = (long long*)malloc(sizeof(long long) * (size_t)(samples > 0 ? samples : 1));
+  Ack* acks = (Ack*)malloc(sizeof(Ack) * (size_t)(MAX_LATENCY * clients));
+  Late* late = (Late*)malloc(sizeof(Late) * (size_t)(MAX_DELAY * clients));
+  if (!bytes || !encode_ns || !decode_ns || !acks || !late) return 2;
+  int encoded = 0, decoded = 0, failures = 0, mismatches = 0, pending = 0, held = 0, delivered_late = 0, stale = 0;
+  long long full_bytes = 0, entities = 0;
+
+  for (int k = 0; k < ticks; k++) {
+    /* bench's scripted input */
+    unsigned int keys = 1 | ((k / 97) % 2 ? 8 : 4) | ((k % 53) < 3 ? 16 : 0) | ((k / 300) % 2 ? 32 : 0);
+    float dt = 1.f / 60.f + (float)(k % 7) * 0.002f;
+    game_update(dt, keys, (float)((k / 40) % 3 - 1) * 7.f, (float)((k / 70) % 3 - 1) * 2.f, (k % 5) == 0);
+
+    for (int a = 0; a < pending; a++) {
+      if (acks[a].due > k) continue;
+      game_net_ack(ids[acks[a].client], acks[a].seq);
+      acks[a--] = acks[--pending];
+    }
+    for (int l = 0; l < held; l++) {
+      if (late[l].due > k) continue;
+      GameNetReplica* r = replicas[late[l].client];
+      unsigned int tick = game_net_replica_tick(r);
+      mismatches += game_net_replica_apply(r, late[l].data, late[l].size / 2) != 0;
+      unsigned int seq = game_net_replica_apply(r, late[l].data, late[l].size);
+      mismatches += game_net_replica_tick(r) < tick;
+      delivered_late++;
+      stale += !seq;
+      if (seq && !lost(loss) && pending < MAX_LATENCY * clients) acks[pending++] = (Ack){ k + latency, late[l].client, seq };
+      free(late[l].data);
+      late[l--] = late[--held];
+    }
+    for (int c = 0; c < clients; c++) {
+      long long t0 = now_ns();
+      int n = game_net_encode(ids[c], packet, PACKET_CAPACITY);
+      encode_ns[encoded] = now_ns() - t0;
+      if (n < 0) return 2;
+      bytes[encoded++] = n;
+      if (lost(loss)) continue;
+      if (lost(reorder) && held < MAX_DELAY * clients) {
+        late[held] = (Late){ k + 1 + (int)(loss_rng % MAX_DELAY), c, n, (unsigned char*)malloc((size_t)n) };
+        if (!late[held].data) return 2;
+        memcpy(late[held++].data, packet, (size_t)n);
+        continue;
+      }
+      t0 = now_ns();
+      unsigned int seq = game_net_replica_apply(replicas[c], packet, n);
+      decode_ns[decoded++] = now_ns() - t0;
+      if (!seq) {
+        failures++;
+        continue;
+      }
+      float cx = c > 0 ? (float)c * VIEW_STEP : game_get_player_x(), cz = c > 0 ? 3.f : game_get_player_z();
+      mismatches += verify(replicas[c], cx, cz, GAME_NET_VIEW_RADIUS);
+      for (int cls = 0; cls < GAME_NET_CLASSES; cls++) entities += game_net_replica_count(replicas[c], cls);
+      if (!lost(loss) && pending < MAX_LATENCY * clients) acks[pending++] = (Ack){ k + latency, c, seq };
+    }
+    full_bytes += game_net_encode(full_client, packet, PACKET_CAPACITY);
+  }
+
+  printf("{\"game\":\"test1\",\"tag\":\"%s\",\"clients\":%d,\"ticks\":%d,\"loss\":%d,\"latency\":%d,\"num_obstacles\":%d,"
+         "\"max_projectiles\":%d,\"entities\":%lld,\"full_bytes\":%lld,\"bytes\":",
+         tag, clients, ticks, loss, latency, NUM_OBSTACLES, MAX_PROJECTILES, decoded ? entities / decoded : 0,
+         ticks ? full_bytes / ticks : 0);
+  print_percentiles(bytes, encoded);
+  printf(",\"encode_ns\":");
+  print_percentiles(encode_ns, encoded);
+  printf(",\"decode_ns\":");
+  print_percentiles(decode_ns, decoded);
+  printf(",\"reorder\":%d,\"late\":%d,\"stale\":%d", reorder, delivered_late, stale);
+  printf(",\"decode_failures\":%d,\"mismatches\":%d,\"out_of_order_failures\":%d,\"hash\":\"%016llx\"}\n",
+         failures, mismatches, order_failures, game_state_hash());
+
+  for (int c = 0; c < clients; c++) {
+    game_net_client_close(ids[c]);
+    game_net_replica_destroy(replicas[c]);
+  }
+  game_net_client_close(full_client);
+  free(bytes);
+  free(encode_ns);
+  free(decode_ns);
+  free(packet);
+  free(acks);
+  for (int l = 0; l < held; l++) free(late[l].data);
+  free(late);
+  return failures || mismatches || order_failures;
+}
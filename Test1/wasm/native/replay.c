@@ -0,0 +1,75 @@
+/* Headless replay of an input log recorded with game_record_start (format in game.h).
+   Build natively from Test1/wasm with `make replay`, or
+     cc -O2 -I. -I../../shared native/replay.c game.c -o replay -lm
+   Usage: replay LOG [-o HASHES] [-c HASHES]
+     -o HASHES  write one line per update: update index, tick, 64-bit state hash
+     -c HASHES  compare against such a file and report the first update that diverges (exit status 1)
+   Always prints the update count, final hash and time per game_update, so captured sessions double as
+   load tests. */
+#include "game.h"
+#include "native/input_log.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv) {
+  const char* log_path = 0;
+  const char* out_path = 0;
+  const char* cmp_path = 0;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-o") && i + 1 < argc) out_path = argv[++i];
+    else if (!strcmp(argv[i], "-c") && i + 1 < argc) cmp_path = argv[++i];
+    else log_path = argv[i];
+  }
+  if (!log_path) {
+    fprintf(stderr, "usage: %s LOG [-o HASHES] [-c HASHES]\n", argv[0]);
+    return 2;
+  }
+  InputLog log;
+  if (!input_log_open(&log, log_path)) return 2;
+  FILE* out = out_path ? fopen(out_path, "w") : 0;
+  FILE* cmp = cmp_path ? fopen(cmp_path, "r") : 0;
+  if ((out_path && !out) || (cmp_path && !cmp)) {
+    fprintf(stderr, "cannot open hash file\n");
+    return 2;
+  }
+
+  game_set_fixed_timestep(log.fixed_hz, log.max_steps);
+  game_init();
+  int updates = 0, diverged = -1;
+  unsigned long long hash = game_state_hash();
+  double total = 0.0, worst = 0.0;
+  InputFrame in;
+  while (input_log_next(&log, &in)) {
+    double t0 = now_sec();
+    game_update(in.dt, in.keys, in.mouse_dx, in.mouse_dy, in.shoot);
+    double t = now_sec() - t0;
+    total += t;
+    if (t > worst) worst = t;
+    hash = game_state_hash();
+    if (out) fprintf(out, "%d %u %016llx\n", updates, game_get_tick(), hash);
+    if (cmp && diverged < 0) {
+      int index;
+      unsigned int tick;
+      unsigned long long expected;
+      if (fscanf(cmp, "%d %u %llx", &index, &tick, &expected) != 3 || expected != hash || tick != game_get_tick()) {
+        diverged = updates;
+        fprintf(stderr, "diverged at update %d (tick %u): hash %016llx\n", updates, game_get_tick(), hash);
+      }
+    }
+    updates++;
+  }
+  if (log.pos != log.size) fprintf(stderr, "%s: %ld trailing bytes ignored (truncated record)\n", log_path, log.size - log.pos);
+  printf("updates %d, ticks %u, final hash %016llx, game_update avg %.2f us, worst %.2f us\n", updates,
+         game_get_tick(), hash, updates ? total * 1e6 / updates : 0.0, worst * 1e6);
+  if (out) fclose(out);
+  if (cmp) fclose(cmp);
+  input_log_close(&log);
+  return diverged >= 0 ? 1 : 0;
+}
@@ -0,0 +1,192 @@
+// Textured backdrop behind the 2D canvas: a WebGL canvas (#backdrop) tiles the scene textures and scrolls with
+// the background. The textures ship as PNGs plus GPU-compressed KTX2 copies written by `make textures`
+// (shared/texpack.c): BC1 for desktop GPUs, ETC2 for mobile ones. The KTX2 files carry their whole mip chain
+// and upload without a decode; without a matching extension, or when the file is missing, the PNG is used
+// instead. Without WebGL createBackdrop returns null and js/game.js keeps its flat background.
+
+// Bands of the backdrop, bottom up from `bottom` px (height 0: the rest of the screen). Layers scroll at
+// `parallax` times the background speed and are darkened by `tint` so the sprites stay readable.
+const BACKDROP_LAYERS = [
+  { name: 'RockTile', bottom: 0, height: 96, tile: 128, parallax: 1, tint: 0.55 },
+  { name: 'GrassTile', bottom: 96, height: 24, tile: 128, parallax: 1, tint: 0.6 },
+  { name: 'BricksWall', bottom: 120, height: 0, tile: 256, parallax: 0.5, tint: 0.3 }
+];
+
+const BACKDROP_VERTEX_SHADER = `
+attribute vec2 a_position;
+void main() { gl_Position = vec4(a_position, 0.0, 1.0); }`;
+
+// Texel (0, 0) is the image's top-left for both the KTX2 levels and the PNG upload (no UNPACK_FLIP_Y)
+const BACKDROP_FRAGMENT_SHADER = `
+precision mediump float;
+uniform sampler2D u_texture;
+uniform vec2 u_origin;   // screen px (from the top-left) of texel (0, 0) of a tile
+uniform float u_tile;    // tile size in px
+uniform float u_height;  // canvas height in px
+uniform float u_tint;
+uniform float u_encode;  // 1 for sRGB texture formats, which sample as linear
+void main() {
+  vec2 px = vec2(gl_FragCoord.x, u_height - gl_FragCoord.y);
+  vec3 c = texture2D(u_texture, (px - u_origin) / u_tile).rgb;
+  c = mix(c, pow(c, vec3(1.0 / 2.2)), u_encode);
+  gl_FragColor = vec4(c * u_tint, 1.0);
+}`;
+
+// Minimal KTX2 reader for texpack's output: one 2D image without supercompression, levels from the level index
+function parseKtx2Levels(buffer, vkFormat) {
+  const dv = new DataView(buffer);
+  const identifier = [0xab, 0x4b, 0x54, 0x58, 0x20, 0x32, 0x30, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a];
+  if (buffer.byteLength < 80 || identifier.some((b, i) => dv.getUint8(i) !== b)) throw new Error('not a KTX2 file');
+  const format = dv.getUint32(12, true);
+  if (format !== vkFormat || dv.getUint32(44, true) !== 0) throw new Error('unexpected vkFormat ' + format);
+  const width = dv.getUint32(20, true);
+  const height = dv.getUint32(24, true);
+  const levelCount = Math.max(1, dv.getUint32(40, true));
+  const levels = [];
+  for (let i = 0; i < levelCount; i++) {
+    const offset = Number(dv.getBigUint64(80 + 24 * i, true));
+    const length = Number(dv.getBigUint64(88 + 24 * i, true));
+    levels.push({ data: new Uint8Array(buffer, offset, length), width: Math.max(1, width >> i), height: Math.max(1, height >> i) });
+  }
+  return levels;
+}
+
+// canvas: the backdrop canvas, sized like the game canvas by the caller. Returns { draw(scroll) } or null.
+function createBackdrop(canvas) {
+  const gl = canvas.getContext('webgl2', { alpha: false, antialias: false }) ||
+             canvas.getContext('webgl', { alpha: false, antialias: false });
+  if (!gl) return null;
+  const isWebGL2 = typeof WebGL2RenderingContext !== 'undefined' && gl instanceof WebGL2RenderingContext;
+
+  // The KTX2 variant this GPU samples: sRGB BC1 (vkFormat 132) or sRGB ETC2 RGB (vkFormat 148)
+  const variant = (() => {
+    const s3tc = gl.getExtension('WEBGL_compressed_texture_s3tc');
+    const s3tcSrgb = gl.getExtension('WEBGL_compressed_texture_s3tc_srgb');
+    if (s3tc && s3tcSrgb) return { suffix: 'bc1', vkFormat: 132, internalFormat: s3tcSrgb.COMPRESSED_SRGB_S3TC_DXT1_EXT };
+    const etc = gl.getExtension('WEBGL_compressed_texture_etc');
+    if (etc) return { suffix: 'etc2', vkFormat: 148, internalFormat: etc.COMPRESSED_SRGB8_ETC2 };
+    return null;
+  })();
+
+  const compile = (type, source) => {
+    const shader = gl.createShader(type);
+    gl.shaderSource(shader, source);
+    gl.compileShader(shader);
+    if (!gl.getShaderParameter(shader, gl.COMPILE_STATUS)) throw new Error(gl.getShaderInfoLog(shader));
+    return shader;
+  };
+  const program = gl.createProgram();
+  try {
+    gl.attachShader(program, compile(gl.VERTEX_SHADER, BACKDROP_VERTEX_SHADER));
+    gl.attachShader(program, compile(gl.FRAGMENT_SHADER, BACKDROP_FRAGMENT_SHADER));
+  } catch (err) {
+    console.warn('Backdrop shader failed, using the flat background:', err.message);
+    return null;
+  }
+  gl.bindAttribLocation(program, 0, 'a_position');
+  gl.linkProgram(program);
+  if (!gl.getProgramParameter(program, gl.LINK_STATUS)) {
+    console.warn('Backdrop program failed, using the flat background:', gl.getProgramInfoLog(program));
+    return null;
+  }
+  const uniforms = {};
+  for (const name of ['u_texture', 'u_origin', 'u_tile', 'u_height', 'u_tint', 'u_encode']) {
+    uniforms[name] = gl.getUniformLocation(program, name);
+  }
+
+  // One triangle over the whole viewport; each band is cut out of it with the scissor
+  gl.bindBuffer(gl.ARRAY_BUFFER, gl.createBuffer());
+  gl.bufferData(gl.ARRAY_BUFFER, new Float32Array([-1, -1, 3, -1, -1, 3]), gl.STATIC_DRAW);
+  gl.enableVertexAttribArray(0);
+  gl.vertexAttribPointer(0, 2, gl.FLOAT, false, 0, 0);
+
+  const newTexture = () => {
+    const tex = gl.createTexture();
+    gl.bindTexture(gl.TEXTURE_2D, tex);
+    gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_WRAP_S, gl.REPEAT);
+    gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_WRAP_T, gl.REPEAT);
+    gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_MIN_FILTER, gl.LINEAR_MIPMAP_LINEAR);
+    gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_MAG_FILTER, gl.LINEAR);
+    return tex;
+  };
+
+  // Loads Assets/Textures/<name> into layer.texture; until then the layer shows the clear color
+  const loadLayer = (layer) => {
+    const base = document.baseURI || window.location.href;
+    const pngUrl = new URL(`Assets/Textures/${layer.name}.png`, base).href;
+    const loadPng = () => {
+      const image = new Image();
+      image.onload = () => {
+        const tex = newTexture();
+        // WebGL1 has no sRGB texture format: sample the encoded values as they are
+        const internalFormat = isWebGL2 ? gl.SRGB8_ALPHA8 : gl.RGBA;
+        gl.texImage2D(gl.TEXTURE_2D, 0, internalFormat, gl.RGBA, gl.UNSIGNED_BYTE, image);
+        gl.generateMipmap(gl.TEXTURE_2D);
+        layer.texture = tex;
+        layer.encode = isWebGL2 ? 1 : 0;
+        console.log('Loaded texture:', pngUrl, image.width, 'x', image.height);
+      };
+      image.onerror = (err) => { console.error('Texture failed to load:', pngUrl, err); };
+      image.src = pngUrl;
+    };
+    if (!variant) {
+      loadPng();
+      return;
+    }
+    const ktx2Url = new URL(`Assets/Textures/${layer.name}.${variant.suffix}.ktx2`, base).href;
+    fetch(ktx2Url)
+      .then((res) => {
+        if (!res.ok) throw new Error('HTTP ' + res.status);
+        return res.arrayBuffer();
+      })
+      .then((buffer) => {
+        const levels = parseKtx2Levels(buffer, variant.vkFormat);
+        const tex = newTexture();
+        levels.forEach((level, i) => {
+          gl.compressedTexImage2D(gl.TEXTURE_2D, i, variant.internalFormat, level.width, level.height, 0, level.data);
+        });
+        if (levels.length === 1) gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_MIN_FILTER, gl.LINEAR);
+        layer.texture = tex;
+        layer.encode = 1;
+        console.log('Loaded texture:', ktx2Url, levels[0].width, 'x', levels[0].height);
+      })
+      .catch((err) => {
+        console.warn('KTX2 texture unavailable, using the PNG:', ktx2Url, err.message || err);
+        loadPng();
+      });
+  };
+
+  const layers = BACKDROP_LAYERS.map((layer) => ({ ...layer, texture: null, encode: 0 }));
+  layers.forEach(loadLayer);
+
+  return {
+    // scroll: px the background has moved left so far (unwrapped)
+    draw(scroll) {
+      const width = canvas.width;
+      const height = canvas.height;
+      gl.viewport(0, 0, width, height);
+      gl.disable(gl.SCISSOR_TEST);
+      gl.clearColor(0x1a / 255, 0x1a / 255, 0x2e / 255, 1);
+      gl.clear(gl.COLOR_BUFFER_BIT);
+      gl.useProgram(program);
+      gl.enable(gl.SCISSOR_TEST);
+      gl.activeTexture(gl.TEXTURE0);
+      gl.uniform1i(uniforms.u_texture, 0);
+      gl.uniform1f(uniforms.u_height, height);
+      for (const layer of layers) {
+        if (!layer.texture) continue;
+        const top = layer.height ? Math.max(0, height - layer.bottom - layer.height) : 0;
+        const bottom = Math.max(0, height - layer.bottom);
+        if (bottom <= top) continue;
+        gl.scissor(0, height - bottom, width, bottom - top);
+        gl.bindTexture(gl.TEXTURE_2D, layer.texture);
+        // Reduce the offset on the CPU (doubles) so the shader only sees small values
+        gl.uniform2f(uniforms.u_origin, -((scroll * layer.parallax) % layer.tile), top);
+        gl.uniform1f(uniforms.u_tile, layer.tile);
+        gl.uniform1f(uniforms.u_tint, layer.tint);
+        gl.uniform1f(uniforms.u_encode, layer.encode);
+        gl.drawArrays(gl.TRIANGLES, 0, 3);
+      }
+    }
+  };
+}
@@ -0,0 +1,44 @@
+// Reader side of the triple-buffered frames published by game_publish_frame (wasm/game.h). Shared by the
+// page (js/game.js) and the headless check (wasm/native/worker_frames.js).
+
+// Header words of a published frame (match GAME_PUB_* in wasm/game.h)
+const GAME_PUB = {
+  SEQ: 0,
+  PLAYER_X: 1,
+  PLAYER_Y: 2,
+  PLAYER_ANGLE: 3,
+  CANVAS_WIDTH: 4,
+  CANVAS_HEIGHT: 5,
+  ENEMY_COUNT: 6,
+  ENEMY_OFFSET: 7,
+  BULLET_COUNT: 8,
+  BULLET_OFFSET: 9,
+  PARTICLE_COUNT: 10,
+  PARTICLE_OFFSET: 11,
+  ENEMY_WORDS: 6,
+  BULLET_WORDS: 2,
+  PARTICLE_WORDS: 5,
+  FRESH: 4,
+  READER_START: 2
+};
+
+// layout: { buffer, frames, exchange, frameWords } as posted by js/sim_worker.js; buffer is the worker's
+// (shared) WASM memory, frames and exchange are byte addresses in it. latest() returns the newest complete
+// frame as { f32, u32, base } (word views of the whole memory, base = the frame's first word), or null before
+// the first publish. The frame stays intact until the next latest() call.
+function createFrameReader(layout) {
+  const f32 = new Float32Array(layout.buffer);
+  const u32 = new Uint32Array(layout.buffer);
+  const exchange = new Int32Array(layout.buffer, layout.exchange, 1);
+  let front = GAME_PUB.READER_START;
+  const frame = { f32, u32, base: 0 };
+  return {
+    latest() {
+      if (Atomics.load(exchange, 0) & GAME_PUB.FRESH) front = Atomics.exchange(exchange, 0, front) & 3;
+      frame.base = (layout.frames >> 2) + front * layout.frameWords;
+      return u32[frame.base + GAME_PUB.SEQ] ? frame : null;
+    }
+  };
+}
+
+if (typeof module !== 'undefined') module.exports = { GAME_PUB, createFrameReader };
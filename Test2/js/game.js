@@ -7,6 +7,12 @@ const ctx = canvas.getContext('2d');
 canvas.width = window.innerWidth;
 canvas.height = window.innerHeight;
 
+// Textured WebGL backdrop under the (then transparent) game canvas (js/backdrop.js); null: flat background
+const backdropCanvas = document.getElementById('backdrop');
+backdropCanvas.width = canvas.width;
+backdropCanvas.height = canvas.height;
+const backdrop = createBackdrop(backdropCanvas);
+
 // Input state
 const keys = {};
 let mouseX = 0;
@@ -19,14 +25,40 @@ let game_get_player_x, game_get_player_y, game_get_player_angle;
 let game_get_bullet_count, game_get_bullet_x, game_get_bullet_y;
 let game_get_enemy_count, game_get_enemy_x, game_get_enemy_y, game_get_enemy_width, game_get_enemy_height, game_get_enemy_rotation, game_get_enemy_color;
 let game_get_particle_count, game_get_particle_x, game_get_particle_y, game_get_particle_vx, game_get_particle_vy, game_get_particle_life, game_get_particle_size, game_get_particle_color;
+// Set when the build has game_build_render_list: returns this frame's culled render list as { f32, u32, base }
+let buildRenderList = null;
+const RENDER_MARGIN = 100; // draw what overlaps the canvas grown by this (GAME_PUBLISH_MARGIN)
+
+// Worker mode (js/sim_worker.js): the simulation ticks in a Worker and render() draws the newest frame it
+// published into shared memory (js/frames.js). Used when the page is cross-origin isolated (server.py) and the
+// build has shared memory; ?record, ?stats and ?noworker keep the simulation on this thread.
+let simWorker = null;
+let frameReader = null;
+let sentInput = null;
 
-// Background scroll
+// Set when the page was opened with ?record and the build has the input recorder: F8 downloads the log
+let saveRecording = null;
+// Set when the page was opened with ?stats and the build has GAME_STATS: logs the slowest update each second
+let logStats = null;
+// GameStats fields in struct order (all uint32, match wasm/game.h)
+const GAME_STATS_FIELD_NAMES = [
+  'updates', 'update_ns', 'player_ns', 'bullet_ns', 'enemy_ns', 'particle_ns', 'pair_tests', 'hits', 'bullet_spawns',
+  'enemy_spawns', 'enemy_arrivals', 'particle_spawns', 'bullet_removals', 'enemy_removals', 'particle_removals',
+  'bullets', 'enemies', 'particles'
+];
+
+// Background scroll; the backdrop takes the unwrapped distance so its tiles do not jump on the wrap
 let backgroundX = 0;
+let backgroundScroll = 0;
 const BACKGROUND_SPEED = 1;
 
 // Input handlers
 document.addEventListener('keydown', (e) => {
   keys[e.code] = true;
+  if (e.code === 'F8' && saveRecording) {
+    e.preventDefault();
+    saveRecording();
+  }
 });
 
 document.addEventListener('keyup', (e) => {
@@ -52,8 +84,8 @@ canvas.addEventListener('mouseup', (e) => {
 });
 
 window.addEventListener('resize', () => {
-  canvas.width = window.innerWidth;
-  canvas.height = window.innerHeight;
+  canvas.width = backdropCanvas.width = window.innerWidth;
+  canvas.height = backdropCanvas.height = window.innerHeight;
 });
 
 // Build keys mask: W=1, S=2, A=4, D=8
@@ -74,24 +106,40 @@ function rgbToColor(rgb) {
   return `rgb(${r}, ${g}, ${b})`;
 }
 
-// Update game state (calls WASM)
+// Hands the current input to the worker when it changed
+function sendInput() {
+  const input = { type: 'input', keys: getKeysMask(), mouseX, mouseY, shoot: isShooting ? 1 : 0, width: canvas.width, height: canvas.height };
+  if (sentInput && Object.keys(input).every((k) => input[k] === sentInput[k])) return;
+  simWorker.postMessage(input);
+  sentInput = input;
+}
+
+// Update game state (calls WASM, or feeds the worker that does)
 function update(deltaTime) {
-  if (!game_update) return;
-  
-  const keysMask = getKeysMask();
-  game_update(deltaTime, keysMask, mouseX, mouseY, isShooting ? 1 : 0, canvas.width, canvas.height);
+  if (simWorker) {
+    sendInput();
+  } else {
+    if (!game_update) return;
+    const keysMask = getKeysMask();
+    game_update(deltaTime, keysMask, mouseX, mouseY, isShooting ? 1 : 0, canvas.width, canvas.height);
+    if (logStats) logStats();
+  }
   
   // Scroll background
   backgroundX -= BACKGROUND_SPEED;
+  backgroundScroll += BACKGROUND_SPEED;
   if (backgroundX <= -canvas.width) {
     backgroundX = 0;
   }
 }
 
-// Render game
-function render() {
-  if (!game_get_player_x) return;
-  
+function drawBackground() {
+  if (backdrop) {
+    ctx.clearRect(0, 0, canvas.width, canvas.height);
+    backdrop.draw(backgroundScroll);
+    return;
+  }
+
   // Clear canvas
   ctx.fillStyle = '#1a1a2e';
   ctx.fillRect(0, 0, canvas.width, canvas.height);
@@ -117,10 +165,119 @@ function render() {
     ctx.lineTo(canvas.width, y);
     ctx.stroke();
   }
+}
+
+function drawEnemy(x, y, width, height, rotation, color) {
+  ctx.save();
+  const centerX = x + width / 2;
+  const centerY = y + height / 2;
+  ctx.translate(centerX, centerY);
+  ctx.rotate(rotation);
+  
+  // Draw enemy body
+  ctx.fillStyle = rgbToColor(color);
+  ctx.fillRect(-width / 2, -height / 2, width, height);
+  
+  // Draw enemy "eyes"
+  const eyeSize = Math.max(3, width / 8);
+  const eyeOffsetX = width / 4;
+  const eyeOffsetY = -height / 4;
+  ctx.fillStyle = '#ffffff';
+  ctx.fillRect(-eyeOffsetX - eyeSize / 2, eyeOffsetY - eyeSize / 2, eyeSize, eyeSize);
+  ctx.fillRect(eyeOffsetX - eyeSize / 2, eyeOffsetY - eyeSize / 2, eyeSize, eyeSize);
+  
+  ctx.restore();
+}
+
+// Bullets share one fill style, set by the caller
+function drawBullet(x, y) {
+  ctx.beginPath();
+  ctx.arc(x, y, 5, 0, Math.PI * 2);
+  ctx.fill();
+}
+
+function drawParticle(x, y, life, size, color) {
+  const alpha = life / 0.5;
+  ctx.save();
+  ctx.globalAlpha = alpha;
+  ctx.fillStyle = rgbToColor(color);
+  ctx.beginPath();
+  ctx.arc(x, y, size, 0, Math.PI * 2);
+  ctx.fill();
+  ctx.restore();
+}
+
+function drawPlayer(playerX, playerY, playerAngle) {
+  const playerWidth = 40;
+  const playerHeight = 40;
+  
+  ctx.save();
+  ctx.translate(playerX + playerWidth / 2, playerY + playerHeight / 2);
+  ctx.rotate(playerAngle);
+  ctx.fillStyle = '#5999ff';
+  ctx.fillRect(-playerWidth / 2, -playerHeight / 2, playerWidth, playerHeight);
+  
+  // Draw gun barrel
+  ctx.fillStyle = '#333333';
+  ctx.fillRect(playerWidth / 2 - 5, -3, 15, 6);
+  ctx.restore();
+}
+
+function drawCrosshair() {
+  ctx.strokeStyle = 'rgba(255, 255, 255, 0.5)';
+  ctx.lineWidth = 2;
+  ctx.beginPath();
+  ctx.moveTo(mouseX - 10, mouseY);
+  ctx.lineTo(mouseX + 10, mouseY);
+  ctx.moveTo(mouseX, mouseY - 10);
+  ctx.lineTo(mouseX, mouseY + 10);
+  ctx.stroke();
+}
+
+// Draw a frame in the published layout (wasm/game.h), already culled by the core: the newest one the worker
+// published or this thread's render list
+function drawFrame(frame) {
+  const { f32, u32, base } = frame;
+  drawBackground();
+
+  let o = base + u32[base + GAME_PUB.ENEMY_OFFSET];
+  for (let n = u32[base + GAME_PUB.ENEMY_COUNT]; n > 0; n--, o += GAME_PUB.ENEMY_WORDS) {
+    drawEnemy(f32[o], f32[o + 1], f32[o + 2], f32[o + 3], f32[o + 4], u32[o + 5]);
+  }
+
+  ctx.fillStyle = '#ffff00';
+  o = base + u32[base + GAME_PUB.BULLET_OFFSET];
+  for (let n = u32[base + GAME_PUB.BULLET_COUNT]; n > 0; n--, o += GAME_PUB.BULLET_WORDS) {
+    drawBullet(f32[o], f32[o + 1]);
+  }
+
+  o = base + u32[base + GAME_PUB.PARTICLE_OFFSET];
+  for (let n = u32[base + GAME_PUB.PARTICLE_COUNT]; n > 0; n--, o += GAME_PUB.PARTICLE_WORDS) {
+    drawParticle(f32[o], f32[o + 1], f32[o + 2], f32[o + 3], u32[o + 4]);
+  }
+
+  drawPlayer(f32[base + GAME_PUB.PLAYER_X], f32[base + GAME_PUB.PLAYER_Y], f32[base + GAME_PUB.PLAYER_ANGLE]);
+  drawCrosshair();
+}
+
+// Render game
+function render() {
+  if (frameReader) {
+    const frame = frameReader.latest();
+    if (frame) drawFrame(frame);
+    return;
+  }
+  if (buildRenderList) {
+    drawFrame(buildRenderList());
+    return;
+  }
+  if (!game_get_player_x) return;
+  // Builds without game_build_render_list: a getter call per value
+  drawBackground();
 
   // Draw enemies (only those visible on screen for performance)
   const enemyCount = game_get_enemy_count();
-  const margin = 100; // Extra margin for enemies slightly off-screen
+  const margin = RENDER_MARGIN;
   for (let i = 0; i < enemyCount; i++) {
     const x = game_get_enemy_x(i);
     const y = game_get_enemy_y(i);
@@ -133,87 +290,28 @@ function render() {
       continue;
     }
     
-    const rotation = game_get_enemy_rotation(i);
-    const color = game_get_enemy_color(i);
-    
-    ctx.save();
-    const centerX = x + width / 2;
-    const centerY = y + height / 2;
-    ctx.translate(centerX, centerY);
-    ctx.rotate(rotation);
-    
-    // Draw enemy body
-    ctx.fillStyle = rgbToColor(color);
-    ctx.fillRect(-width / 2, -height / 2, width, height);
-    
-    // Draw enemy "eyes"
-    const eyeSize = Math.max(3, width / 8);
-    const eyeOffsetX = width / 4;
-    const eyeOffsetY = -height / 4;
-    ctx.fillStyle = '#ffffff';
-    ctx.fillRect(-eyeOffsetX - eyeSize / 2, eyeOffsetY - eyeSize / 2, eyeSize, eyeSize);
-    ctx.fillRect(eyeOffsetX - eyeSize / 2, eyeOffsetY - eyeSize / 2, eyeSize, eyeSize);
-    
-    ctx.restore();
+    drawEnemy(x, y, width, height, game_get_enemy_rotation(i), game_get_enemy_color(i));
   }
 
   // Draw bullets
   ctx.fillStyle = '#ffff00';
   const bulletCount = game_get_bullet_count();
   for (let i = 0; i < bulletCount; i++) {
-    const x = game_get_bullet_x(i);
-    const y = game_get_bullet_y(i);
-    ctx.beginPath();
-    ctx.arc(x, y, 5, 0, Math.PI * 2);
-    ctx.fill();
+    drawBullet(game_get_bullet_x(i), game_get_bullet_y(i));
   }
 
   // Draw particles
   const particleCount = game_get_particle_count();
   for (let i = 0; i < particleCount; i++) {
-    const x = game_get_particle_x(i);
-    const y = game_get_particle_y(i);
-    const life = game_get_particle_life(i);
-    const size = game_get_particle_size(i);
-    const color = game_get_particle_color(i);
-    
-    const alpha = life / 0.5;
-    ctx.save();
-    ctx.globalAlpha = alpha;
-    ctx.fillStyle = rgbToColor(color);
-    ctx.beginPath();
-    ctx.arc(x, y, size, 0, Math.PI * 2);
-    ctx.fill();
-    ctx.restore();
+    drawParticle(game_get_particle_x(i), game_get_particle_y(i), game_get_particle_life(i), game_get_particle_size(i),
+                 game_get_particle_color(i));
   }
 
   // Draw player
-  const playerX = game_get_player_x();
-  const playerY = game_get_player_y();
-  const playerAngle = game_get_player_angle();
-  const playerWidth = 40;
-  const playerHeight = 40;
-  
-  ctx.save();
-  ctx.translate(playerX + playerWidth / 2, playerY + playerHeight / 2);
-  ctx.rotate(playerAngle);
-  ctx.fillStyle = '#5999ff';
-  ctx.fillRect(-playerWidth / 2, -playerHeight / 2, playerWidth, playerHeight);
-  
-  // Draw gun barrel
-  ctx.fillStyle = '#333333';
-  ctx.fillRect(playerWidth / 2 - 5, -3, 15, 6);
-  ctx.restore();
+  drawPlayer(game_get_player_x(), game_get_player_y(), game_get_player_angle());
 
   // Draw crosshair at mouse position
-  ctx.strokeStyle = 'rgba(255, 255, 255, 0.5)';
-  ctx.lineWidth = 2;
-  ctx.beginPath();
-  ctx.moveTo(mouseX - 10, mouseY);
-  ctx.lineTo(mouseX + 10, mouseY);
-  ctx.moveTo(mouseX, mouseY - 10);
-  ctx.lineTo(mouseX, mouseY + 10);
-  ctx.stroke();
+  drawCrosshair();
 }
 
 // Game loop
@@ -232,20 +330,60 @@ function gameLoop(currentTime) {
 (function () {
   const wasmDir = 'wasm/';
   const createGameModuleFn = typeof globalThis.createGameModule !== 'undefined' ? globalThis.createGameModule : null;
+  const params = new URLSearchParams(window.location.search);
 
-  if (!createGameModuleFn) {
-    document.getElementById('instructions').textContent =
-      'WASM build not loaded. Run wasm/build.bat or build.sh first, then refresh.';
+  if (self.crossOriginIsolated && typeof Worker !== 'undefined' &&
+      !params.has('record') && !params.has('stats') && !params.has('noworker')) {
+    startWorker();
     return;
   }
+  startHere();
+
+  // Falls back to startHere when the build has no shared memory or the worker fails
+  function startWorker() {
+    simWorker = new Worker('js/sim_worker.js');
+    simWorker.onmessage = (e) => {
+      const msg = e.data;
+      if (msg.type === 'ready') {
+        frameReader = createFrameReader(msg);
+        gameLoop(0);
+      } else if (msg.type === 'unshared' || msg.type === 'error') {
+        console.warn('Simulation worker unavailable, running on the main thread:', msg.message || 'build without shared memory');
+        simWorker.terminate();
+        simWorker = null;
+        startHere();
+      }
+    };
+    simWorker.onerror = (err) => {
+      if (frameReader) {
+        console.error('Simulation worker failed:', err.message);
+        return;
+      }
+      console.warn('Simulation worker failed, running on the main thread:', err.message);
+      simWorker.terminate();
+      simWorker = null;
+      startHere();
+    };
+    simWorker.postMessage({ type: 'start', threads: Math.min(navigator.hardwareConcurrency || 1, 8) });
+  }
 
-  createGameModuleFn({ locateFile: (path) => wasmDir + path })
-    .then(runWithModule)
-    .catch((err) => {
-      console.error('WASM init failed:', err);
+  function startHere() {
+    if (!createGameModuleFn) {
       document.getElementById('instructions').textContent =
-        'Failed to load game (WebAssembly). Build wasm first: run wasm/build.bat or wasm/build.sh.';
-    });
+        'WASM build not loaded. Run wasm/build.bat or build.sh first, then refresh.';
+      return;
+    }
+
+    createGameModuleFn({ locateFile: (path) => wasmDir + path })
+      .then(runWithModule)
+      .catch((err) => {
+        console.error('WASM init failed:', err);
+        // The default build has shared memory, which browsers only allow on cross-origin isolated pages
+        document.getElementById('instructions').textContent = self.crossOriginIsolated
+          ? 'Failed to load game (WebAssembly). Build wasm first: run wasm/build.bat or wasm/build.sh.'
+          : 'Failed to load game (WebAssembly). Serve the page with server.py, or build wasm with -sSHARED_MEMORY=0.';
+      });
+  }
 
   function runWithModule(Module) {
     game_init = Module.cwrap('game_init', null, []);
@@ -276,7 +414,55 @@ function gameLoop(currentTime) {
     game_get_particle_size = Module.cwrap('game_get_particle_size', 'number', ['number']);
     game_get_particle_color = Module.cwrap('game_get_particle_color', 'number', ['number']);
 
-    game_init();
+    if (typeof Module['_game_build_render_list'] === 'function') {
+      const build = Module.cwrap('game_build_render_list', 'number', ['number', 'number', 'number', 'number']);
+      const frame = { f32: null, u32: null, base: 0 };
+      buildRenderList = () => {
+        frame.base = build(-RENDER_MARGIN, -RENDER_MARGIN, canvas.width + RENDER_MARGIN, canvas.height + RENDER_MARGIN) >> 2;
+        if (frame.u32 !== Module.HEAPU32) { // new views after a memory growth
+          frame.u32 = Module.HEAPU32;
+          frame.f32 = new Float32Array(frame.u32.buffer);
+        }
+        return frame;
+      };
+    }
+
+    // GAME_THREADS builds: spread the parallel phases over the cores (workers need a cross-origin isolated page)
+    if (typeof Module['_game_set_thread_count'] === 'function' && self.crossOriginIsolated) {
+      Module.ccall('game_set_thread_count', 'number', ['number'], [Math.min(navigator.hardwareConcurrency || 1, 8)]);
+    }
+
+    // ?record: log every game_update from a fresh start; replay the download with wasm/native/replay.c
+    if (new URLSearchParams(window.location.search).has('record') && typeof Module['_game_record_start'] === 'function') {
+      Module.ccall('game_record_start', null, [], []);
+      saveRecording = () => {
+        const start = Module.ccall('game_get_record_data', 'number', [], []);
+        const size = Module.ccall('game_get_record_size', 'number', [], []);
+        const url = URL.createObjectURL(new Blob([Module.HEAPU8.slice(start, start + size)], { type: 'application/octet-stream' }));
+        const link = document.createElement('a');
+        link.href = url;
+        link.download = 'test2-input.bin';
+        link.click();
+        URL.revokeObjectURL(url);
+      };
+    } else {
+      game_init();
+    }
+
+    // ?stats: GAME_STATS builds expose per-phase timings and work counters of the last update (GameStats)
+    const statsPtr = typeof Module['_game_get_stats'] === 'function' ? Module.ccall('game_get_stats', 'number', [], []) : 0;
+    if (new URLSearchParams(window.location.search).has('stats') && statsPtr) {
+      const stats = new Uint32Array(Module.HEAPU32.buffer, statsPtr, GAME_STATS_FIELD_NAMES.length);
+      let worst = null;
+      let nextLog = performance.now() + 1000;
+      logStats = () => {
+        if (!worst || stats[1] > worst[1]) worst = stats.slice();
+        if (performance.now() < nextLog) return;
+        console.log('slowest game_update this second:', Object.fromEntries(GAME_STATS_FIELD_NAMES.map((name, i) => [name, worst[i]])));
+        worst = null;
+        nextLog += 1000;
+      };
+    }
     gameLoop(0);
   }
 })();
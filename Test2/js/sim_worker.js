@@ -0,0 +1,105 @@
+// Simulation worker: owns the WASM core, steps it at TICK_HZ independently of the page's frame rate and
+// publishes every update with game_publish_frame; the page reads the newest frame from the shared memory
+// (js/frames.js). Needs a build with shared memory (the wasm/build.sh default) and, in a browser, a
+// cross-origin isolated page (server.py sends the headers). Runs as a browser Worker or a Node worker_threads
+// worker (wasm/native/worker_frames.js).
+//
+// Messages in:  { type: 'start', threads }
+//               { type: 'input', keys, mouseX, mouseY, shoot, width, height } (latest wins)
+//               { type: 'stop' }
+// Messages out: { type: 'ready', buffer, frames, exchange, frameWords }
+//               { type: 'stopped', updates, updateMs } in answer to 'stop'
+//               { type: 'unshared' } / { type: 'error', message } when the worker cannot run the game
+
+const TICK_HZ = 60;
+const MAX_DT = 0.1;
+
+const isNode = typeof importScripts !== 'function';
+let post;
+let onMessage;
+let createModule;
+if (isNode) {
+  const { parentPort } = require('worker_threads');
+  post = (msg) => parentPort.postMessage(msg);
+  parentPort.on('message', (msg) => onMessage(msg));
+  createModule = require(require('path').join(__dirname, '../wasm/game.js'));
+} else {
+  importScripts('../wasm/game.js');
+  post = (msg) => postMessage(msg);
+  self.onmessage = (e) => onMessage(e.data);
+  createModule = self.createGameModule;
+}
+
+const input = { keys: 0, mouseX: 0, mouseY: 0, shoot: 0, width: 800, height: 600 };
+let running = false;
+let gameUpdate = null;
+let publishFrame = null;
+let lastTime = 0;
+let nextTick = 0;
+let updates = 0;
+let updateMs = 0;
+
+function tick() {
+  if (!running) return;
+  const now = performance.now();
+  const dt = Math.min((now - lastTime) / 1000, MAX_DT);
+  lastTime = now;
+  gameUpdate(dt, input.keys, input.mouseX, input.mouseY, input.shoot, input.width, input.height);
+  publishFrame();
+  updates++;
+  updateMs += performance.now() - now;
+  // Keep the tick grid; after a stall, restart it instead of running a burst of catch-up updates
+  nextTick += 1000 / TICK_HZ;
+  const wait = nextTick - performance.now();
+  if (wait < 0) nextTick = performance.now();
+  setTimeout(tick, Math.max(0, wait));
+}
+
+function start(msg) {
+  const wasmDir = isNode ? require('path').join(__dirname, '../wasm/') : '../wasm/';
+  createModule({ locateFile: (path) => wasmDir + path })
+    .then((Module) => {
+      if (typeof Module['_game_publish_frame'] !== 'function') {
+        post({ type: 'error', message: 'WASM build has no game_publish_frame; rebuild wasm' });
+        return;
+      }
+      if (typeof SharedArrayBuffer === 'undefined' || !(Module.HEAPU8.buffer instanceof SharedArrayBuffer)) {
+        post({ type: 'unshared' });
+        return;
+      }
+      gameUpdate = Module.cwrap('game_update', null, ['number', 'number', 'number', 'number', 'number', 'number', 'number']);
+      publishFrame = Module.cwrap('game_publish_frame', 'number', []);
+      if (msg.threads > 1 && typeof Module['_game_set_thread_count'] === 'function') {
+        Module.ccall('game_set_thread_count', 'number', ['number'], [msg.threads]);
+      }
+      Module.ccall('game_init', null, [], []);
+      publishFrame();
+      post({
+        type: 'ready',
+        buffer: Module.HEAPU8.buffer,
+        frames: Module.ccall('game_get_publish_frames', 'number', [], []),
+        exchange: Module.ccall('game_get_publish_exchange', 'number', [], []),
+        frameWords: Module.ccall('game_get_publish_frame_words', 'number', [], [])
+      });
+      running = true;
+      lastTime = nextTick = performance.now();
+      setTimeout(tick, 0);
+    })
+    .catch((err) => post({ type: 'error', message: String(err) }));
+}
+
+onMessage = (msg) => {
+  if (msg.type === 'start') {
+    start(msg);
+  } else if (msg.type === 'input') {
+    input.keys = msg.keys;
+    input.mouseX = msg.mouseX;
+    input.mouseY = msg.mouseY;
+    input.shoot = msg.shoot;
+    input.width = msg.width;
+    input.height = msg.height;
+  } else if (msg.type === 'stop') {
+    running = false;
+    post({ type: 'stopped', updates, updateMs });
+  }
+};
@@ -23,6 +23,13 @@ class MyHTTPRequestHandler(http.server.SimpleHTTPRequestHandler):
         mimetype = super().guess_type(path)
         return mimetype
     
+    def end_headers(self):
+        # Cross-origin isolation: gives the page SharedArrayBuffer, so the simulation can run in a Worker
+        # (js/sim_worker.js) and share its frames with the page
+        self.send_header('Cross-Origin-Opener-Policy', 'same-origin')
+        self.send_header('Cross-Origin-Embedder-Policy', 'require-corp')
+        super().end_headers()
+    
     def log_message(self, format, *args):
         # Suppress default logging to reduce noise
         pass
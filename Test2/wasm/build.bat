@@ -1,5 +1,8 @@
 @echo off
 REM Build WASM game module (requires Emscripten: https://emscripten.org/docs/getting_started/downloads.html)
+REM The memory is shared, so a cross-origin isolated page (server.py) runs the simulation in a Worker
+REM (js/sim_worker.js). For hosts that cannot send the isolation headers, build.bat -sSHARED_MEMORY=0.
+REM Extra arguments go to emcc, e.g. build.bat -DGAME_THREADS=1 -pthread -sPTHREAD_POOL_SIZE=4 for parallel phases
 set SCRIPT_DIR=%~dp0
 cd /d "%SCRIPT_DIR%"
 REM If emcc is not in PATH, try project emsdk (run "emsdk install latest" and "emsdk activate latest" once)
@@ -7,8 +10,9 @@ where emcc >nul 2>&1 || if exist "%~dp0..\emsdk\emsdk_env.bat" call "%~dp0..\ems
 emcc game.c -o game.js ^
   -s MODULARIZE=1 ^
   -s EXPORT_NAME="createGameModule" ^
-  -s EXPORTED_FUNCTIONS="['_malloc','_free','_game_init','_game_update','_game_get_player_position','_game_get_player_x','_game_get_player_y','_game_get_player_angle','_game_get_bullet_count','_game_get_bullet','_game_get_bullet_x','_game_get_bullet_y','_game_get_bullet_vx','_game_get_bullet_vy','_game_get_enemy_count','_game_get_enemy','_game_get_enemy_x','_game_get_enemy_y','_game_get_enemy_width','_game_get_enemy_height','_game_get_enemy_rotation','_game_get_enemy_color','_game_get_particle_count','_game_get_particle','_game_get_particle_x','_game_get_particle_y','_game_get_particle_vx','_game_get_particle_vy','_game_get_particle_life','_game_get_particle_size','_game_get_particle_color']" ^
-  -s EXPORTED_RUNTIME_METHODS="['ccall','cwrap']" ^
+  -s EXPORTED_FUNCTIONS="['_malloc','_free','_game_init','_game_update','_game_get_player_position','_game_get_player_x','_game_get_player_y','_game_get_player_angle','_game_get_bullet_count','_game_get_bullet','_game_get_bullet_x','_game_get_bullet_y','_game_get_bullet_vx','_game_get_bullet_vy','_game_get_enemy_count','_game_get_enemy','_game_get_enemy_x','_game_get_enemy_y','_game_get_enemy_width','_game_get_enemy_height','_game_get_enemy_rotation','_game_get_enemy_color','_game_get_enemy_id','_game_get_particle_count','_game_get_particle','_game_get_particle_x','_game_get_particle_y','_game_get_particle_vx','_game_get_particle_vy','_game_get_particle_life','_game_get_particle_size','_game_get_particle_color','_game_record_start','_game_record_stop','_game_get_record_size','_game_get_record_data','_game_state_hash','_game_get_stats','_game_set_thread_count','_game_world_default','_game_world_create','_game_world_destroy','_game_world_update','_game_worlds_update','_game_world_get_player','_game_world_state_hash','_game_net_client_open','_game_net_client_close','_game_net_client_view','_game_net_encode','_game_net_ack','_game_net_replica_create','_game_net_replica_destroy','_game_net_replica_apply','_game_net_replica_tick','_game_net_replica_count','_game_net_replica_id','_game_net_replica_field','_game_publish_frame','_game_get_publish_frames','_game_get_publish_exchange','_game_get_publish_frame_words','_game_build_render_list']" ^
+  -s EXPORTED_RUNTIME_METHODS="['ccall','cwrap','HEAPU8','HEAPU32']" ^
   -s INITIAL_MEMORY=67108864 ^
-  -O2
+  -s SHARED_MEMORY=1 ^
+  -I..\..\shared -O2 -msimd128 %*
 echo Build complete. Output: game.js, game.wasm
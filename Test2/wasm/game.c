@@ -1,5 +1,13 @@
 #include "game.h"
+#include "jobs.h"
+#include "hash.h"
+#define STATS_STEP_NAME "update"
+#include "stats.h"
+#include "netcode.h"
+#include "particles.h"
 #include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 /* Constants */
@@ -14,6 +22,13 @@
 #define ENEMY_SPAWN_DISTANCE 50000.f
 #define PARTICLE_LIFETIME 0.5f
 #define SHOOT_COOLDOWN_TIME 0.1f
+#define PLAYER_WIDTH 40.f
+#define PLAYER_HEIGHT 40.f
+#define ENEMY_JOB_CHUNK 4096 /* enemies per jobs_parallel_for chunk */
+#define ENEMY_JOB_CHUNKS ((MAX_ENEMIES + ENEMY_JOB_CHUNK - 1) / ENEMY_JOB_CHUNK)
+#define PARTICLE_JOB_CHUNK 4096
+#define ENEMY_WHEEL_SLOTS 32768 /* arrival wheel of a full pool; above the longest wait of ~25000 updates */
+#define ENEMY_EDGE_STEP 512.f   /* the active edge moves in multiples of this, and shrinks a step late */
 
 /* Structures */
 typedef struct {
@@ -22,53 +37,125 @@ typedef struct {
   float life;
 } Bullet;
 
+/* An enemy right of the active edge, with x and rotation as of enemy tick `tick`. It moves in a straight line
+   at a fixed speed per update, so it needs no updates until `due`, the first update whose move takes it to
+   the active edge; then its position is computed in closed form and it joins the active arrays. Parked
+   enemies are only touched at these two points, so each is one record rather than spread over arrays. */
 typedef struct {
-  float x, y;
-  float width, height;
-  float speed;
-  float rotation;
-  float rotationSpeed;
-  unsigned int color; /* RGB packed as 0xRRGGBB */
-  int active;
-} Enemy;
+  float x, y, speed, rotation, size, rotation_speed;
+  unsigned int color, id;
+  unsigned int tick, due; /* due 0 marks a free record */
+  int next; /* next record in the same wheel slot or in the free list, -1 at the end */
+} ParkedEnemy;
 
+/* Enemies as a structure of arrays over the active ones only: every index below enemy_count is a live enemy,
+   and removing one moves the last into its place. x, y, speed and rotation are what the per-update sweep
+   streams through; the rest is read by collision tests, hits and readers. An id stays with its enemy while
+   it lives and is then recycled through the free list, so replication can follow enemies across moves.
+   Enemies spawn up to ENEMY_SPAWN_DISTANCE right of the screen and most of them are far from anything that
+   looks at them. Those right of active_edge (the screen, its publish margin and every client view) are
+   parked: they wait in a timing wheel indexed by their due update, and an update only takes out the slot
+   for itself. Moving the edge reschedules every parked enemy, so it moves a whole ENEMY_EDGE_STEP at a time
+   and only shrinks once it is a step more than needed. */
 typedef struct {
-  float x, y;
-  float vx, vy;
-  float life;
-  float size;
-  unsigned int color;
-} Particle;
+  float* x;
+  float* y;
+  float* speed;
+  float* rotation;
+  float* size; /* width = height */
+  float* rotation_speed;
+  unsigned int* color; /* RGB packed as 0xRRGGBB */
+  unsigned int* id;
+  unsigned int* free_ids; /* ids of removed enemies, reused last in first out */
+  int free_count;
+  unsigned int next_id;   /* no id from here up has been handed out */
+  /* Collision band for the sort-and-sweep broadphase: the enemies a bullet can reach, i.e. whose left edge
+     is at or left of band_edge (the canvas' right edge plus BULLET_RADIUS). Enemies only move left, so they
+     join when they cross the edge or spawn inside it and stay until removed. Entries [band_begin,
+     band_count) carry the enemy index (-1 once removed) with its x and speed; band_x follows x exactly
+     without touching the enemy arrays. [band_begin, band_sorted) is sorted by band_x; entries joined since
+     the last enemy_band_repair follow. Enemies leave at the low-x end, so band_begin just moves past them;
+     the window is compacted back to 0 when it reaches the end of the arrays. */
+  int* band_slot;     /* per enemy: its band entry, or -1 */
+  int* band_index;    /* 2 * max_enemies entries */
+  float* band_x;      /* 2 * max_enemies */
+  float* band_speed;  /* 2 * max_enemies */
+  int band_begin, band_count, band_sorted;
+  float band_edge;
+  ParkedEnemy* parked; /* max_enemies records */
+  int* wheel;          /* wheel_mask + 1 list heads; slot s holds the records due at updates equal to s mod size */
+  int wheel_mask;
+  int parked_count;
+  int parked_free;     /* first free record */
+  unsigned int tick;   /* last update whose enemy move has run */
+  float active_edge;
+} EnemyPool;
+#define ENEMY_POOL_ARRAYS 16 /* 4-byte arrays of max_enemies entries behind a created world */
+#define ENEMY_ENTER_LIST 8   /* band crossings remembered per job chunk; more and the chunk is scanned */
 
-/* Game state */
-static float player_x = 100.f;
-static float player_y = 400.f;
-static float player_width = 40.f;
-static float player_height = 40.f;
-static float player_angle = 0.f;
+/* Game state: one GameWorld per simulation (game.h). Everything below acts on the active world, which is the
+   default world except inside game_worlds_update. A created world is one allocation: this header with the
+   bullets, then its enemy arrays, parked records and wheel, then its particle arrays. */
+struct GameWorld {
+  float player_x, player_y;
+  float player_angle;
+  float shoot_cooldown;
+  float canvas_width, canvas_height;
+  unsigned int rng_state;
+  unsigned int updates; /* world_update calls since the reset, the tick of replication snapshots */
+  int bullet_count;
+  int enemy_count; /* active enemies; the rest of the live ones are parked */
+  int max_enemies; /* capacity of enemies, active and parked; kept full, every removed enemy is replaced */
+  EnemyPool enemies;
+  ParticleRing particles;
+  Bullet bullets[MAX_BULLETS];
+};
 
-static Bullet bullets[MAX_BULLETS];
-static int bullet_count = 0;
-static float shoot_cooldown = 0.f;
+static struct {
+  float x[MAX_ENEMIES], y[MAX_ENEMIES], speed[MAX_ENEMIES], rotation[MAX_ENEMIES];
+  float size[MAX_ENEMIES], rotation_speed[MAX_ENEMIES];
+  unsigned int color[MAX_ENEMIES], id[MAX_ENEMIES], free_ids[MAX_ENEMIES];
+  int band_slot[MAX_ENEMIES], band_index[2 * MAX_ENEMIES];
+  float band_x[2 * MAX_ENEMIES], band_speed[2 * MAX_ENEMIES];
+  ParkedEnemy parked[MAX_ENEMIES];
+  int wheel[ENEMY_WHEEL_SLOTS];
+} default_enemies;
+static struct {
+  float x[MAX_PARTICLES], y[MAX_PARTICLES], vx[MAX_PARTICLES], vy[MAX_PARTICLES];
+  float life[MAX_PARTICLES], size[MAX_PARTICLES];
+  unsigned int color[MAX_PARTICLES];
+} default_particles;
+static GameWorld default_world; /* game_init points it at default_enemies and default_particles */
+static GameWorld* world = &default_world;
 
-static Enemy enemies[MAX_ENEMIES];
-static int enemy_count = 0;
+/* Per-chunk results of the parallel enemy pass, merged in chunk order */
+static int enemy_chunk_exits[ENEMY_JOB_CHUNKS];
+static int enemy_chunk_enters[ENEMY_JOB_CHUNKS]; /* crossed band_edge */
+static int enemy_chunk_enter_list[ENEMY_JOB_CHUNKS][ENEMY_ENTER_LIST];
 
-static Particle particles[MAX_PARTICLES];
-static int particle_count = 0;
+static float net_view_edge(const GameWorld* w); /* replication, below */
 
-static float canvas_width = 800.f;
-static float canvas_height = 600.f;
+/* Input recording */
+static unsigned char record_log[GAME_RECORD_CAPACITY];
+static int record_size = 0;
+static int recording = 0;
+static int record_count = 0;
+static float record_mouse_x, record_mouse_y;
+static float record_canvas_width, record_canvas_height;
 
-/* RNG */
-static unsigned int rng_state = 12345u;
+/* Instrumentation (GAME_STATS, stats.h): phases are traced with the update they belong to */
+#if GAME_STATS
+static GameStats stats;
+#define STATS_STEP stats.updates
+#endif
 
+/* RNG */
 static unsigned int rng_next(void) {
-  unsigned int x = rng_state;
+  unsigned int x = world->rng_state;
   x ^= x << 13;
   x ^= x >> 17;
   x ^= x << 5;
-  rng_state = x;
+  world->rng_state = x;
   return x;
 }
 
@@ -105,228 +192,1124 @@ static unsigned int hsl_to_rgb(float h, float s, float l) {
   return (ur << 16) | (ug << 8) | ub;
 }
 
+/* Moves the band window back to 0 without its removed entries; order is kept */
+static void band_compact(EnemyPool* p) {
+  int n = 0, sorted = 0;
+  for (int k = p->band_begin; k < p->band_count; k++) {
+    int i = p->band_index[k];
+    if (i < 0) continue;
+    p->band_index[n] = i;
+    p->band_x[n] = p->band_x[k];
+    p->band_speed[n] = p->band_speed[k];
+    p->band_slot[i] = n++;
+    if (k < p->band_sorted) sorted = n;
+  }
+  p->band_begin = 0;
+  p->band_count = n;
+  p->band_sorted = sorted;
+}
+
+static void band_join(EnemyPool* p, int i) {
+  if (p->band_count == 2 * world->max_enemies) band_compact(p); /* at most max_enemies remain */
+  int k = p->band_count++;
+  p->band_index[k] = i;
+  p->band_x[k] = p->x[i];
+  p->band_speed[k] = p->speed[i];
+  p->band_slot[i] = k;
+}
+
+static int enemy_wheel_slots(int max_enemies) {
+  int slots = 64;
+  while (slots < max_enemies && slots < ENEMY_WHEEL_SLOTS) slots <<= 1;
+  return slots;
+}
+
+/* Appends r to the active enemies at position x and rotation */
+static void enemy_activate(EnemyPool* p, const ParkedEnemy* r, float x, float rotation) {
+  int i = world->enemy_count++;
+  p->x[i] = x;
+  p->y[i] = r->y;
+  p->speed[i] = r->speed;
+  p->rotation[i] = rotation;
+  p->size[i] = r->size;
+  p->rotation_speed[i] = r->rotation_speed;
+  p->color[i] = r->color;
+  p->id[i] = r->id;
+  p->band_slot[i] = -1;
+  if (x <= p->band_edge) band_join(p, i);
+}
+
+/* First update whose move takes r to edge or left of it; r is right of edge at its tick. Found with the same
+   float expression enemy_arrivals evaluates, so r is still right of edge the update before. */
+static unsigned int parked_due(const ParkedEnemy* r, float edge) {
+  unsigned int k = (unsigned int)((r->x - edge) / r->speed);
+  if (k < 1) k = 1;
+  while (k > 1 && r->x - r->speed * (float)(k - 1) <= edge) k--;
+  while (r->x - r->speed * (float)k > edge) k++;
+  return r->tick + k;
+}
+
+static void wheel_insert(EnemyPool* p, int slot) {
+  ParkedEnemy* r = &p->parked[slot];
+  int* head = &p->wheel[r->due & (unsigned int)p->wheel_mask];
+  r->next = *head;
+  *head = slot;
+}
+
+static void parked_release(EnemyPool* p, int slot) {
+  p->parked[slot].due = 0;
+  p->parked[slot].next = p->parked_free;
+  p->parked_free = slot;
+  p->parked_count--;
+}
+
 static void spawn_enemy(void) {
-  if (enemy_count >= MAX_ENEMIES) return;
+  EnemyPool* p = &world->enemies;
+  if (world->enemy_count + p->parked_count >= world->max_enemies) return;
   
-  Enemy* e = &enemies[enemy_count++];
-  e->x = canvas_width + rng_float(0.f, ENEMY_SPAWN_DISTANCE);
-  e->y = rng_float(0.f, canvas_height);
-  e->width = rng_float(ENEMY_MIN_SIZE, ENEMY_MAX_SIZE);
-  e->height = e->width; /* Square enemies */
-  e->speed = rng_float(ENEMY_MIN_SPEED, ENEMY_MAX_SPEED);
-  e->rotation = rng_float(0.f, 6.28318530718f);
-  e->rotationSpeed = rng_float(-0.05f, 0.05f);
+  STATS_ADD(enemy_spawns, 1);
+  ParkedEnemy e;
+  e.x = world->canvas_width + rng_float(0.f, ENEMY_SPAWN_DISTANCE);
+  e.y = rng_float(0.f, world->canvas_height);
+  e.size = rng_float(ENEMY_MIN_SIZE, ENEMY_MAX_SIZE); /* Square enemies */
+  e.speed = rng_float(ENEMY_MIN_SPEED, ENEMY_MAX_SPEED);
+  e.rotation = rng_float(0.f, 6.28318530718f);
+  e.rotation_speed = rng_float(-0.05f, 0.05f);
   float hue = rng_float(0.f, 360.f);
-  e->color = hsl_to_rgb(hue, 0.7f, 0.5f);
-  e->active = 1;
+  e.color = hsl_to_rgb(hue, 0.7f, 0.5f);
+  e.id = p->free_count ? p->free_ids[--p->free_count] : p->next_id++;
+  if (e.x <= p->active_edge) {
+    enemy_activate(p, &e, e.x, e.rotation);
+    return;
+  }
+  int slot = p->parked_free;
+  ParkedEnemy* r = &p->parked[slot];
+  p->parked_free = r->next;
+  p->parked_count++;
+  *r = e;
+  r->tick = p->tick;
+  r->due = parked_due(r, p->active_edge);
+  wheel_insert(p, slot);
 }
 
-void game_init(void) {
-  player_x = 100.f;
-  player_y = 400.f;
-  player_angle = 0.f;
-  bullet_count = 0;
-  enemy_count = 0;
-  particle_count = 0;
-  shoot_cooldown = 0.f;
-  rng_state = 12345u;
+/* Activates the enemies due this update, at their position before its move */
+static int enemy_arrivals(EnemyPool* p, unsigned int update) {
+  int arrivals = 0;
+  int* link = &p->wheel[update & (unsigned int)p->wheel_mask];
+  while (*link >= 0) {
+    int slot = *link;
+    ParkedEnemy* r = &p->parked[slot];
+    if (r->due != update) { /* a later turn of the wheel */
+      link = &r->next;
+      continue;
+    }
+    *link = r->next;
+    float k = (float)(p->tick - r->tick);
+    enemy_activate(p, r, r->x - r->speed * k, r->rotation + r->rotation_speed * k);
+    parked_release(p, slot);
+    arrivals++;
+  }
+  return arrivals;
+}
+
+/* Takes active enemy i out of the arrays; the last enemy takes its index. Its id stays with the caller. */
+static void enemy_unlink(EnemyPool* p, int i) {
+  int last = --world->enemy_count;
+  if (p->band_slot[last] >= 0) p->band_index[p->band_slot[last]] = i;
+  if (p->band_slot[i] >= 0) p->band_index[p->band_slot[i]] = -1;
+  p->band_slot[i] = p->band_slot[last];
+  p->x[i] = p->x[last];
+  p->y[i] = p->y[last];
+  p->speed[i] = p->speed[last];
+  p->rotation[i] = p->rotation[last];
+  p->size[i] = p->size[last];
+  p->rotation_speed[i] = p->rotation_speed[last];
+  p->color[i] = p->color[last];
+  p->id[i] = p->id[last];
+}
+
+/* Moves the active edge to cover edge, rounded up to a multiple of ENEMY_EDGE_STEP. It grows as soon as edge
+   passes it, activating the parked enemies now left of it; it shrinks only when it is more than a step past
+   the rounded edge, and then to one step past it, parking the active enemies right of it again. Either way
+   every parked enemy is rescheduled in one pass, so a panning view costs a pass per step, and a view
+   wavering around a step boundary costs none. */
+static void enemy_move_active_edge(EnemyPool* p, float edge) {
+  float rounded = ceilf(edge / ENEMY_EDGE_STEP) * ENEMY_EDGE_STEP;
+  if (edge > p->active_edge) {
+    edge = rounded;
+  } else if (rounded + ENEMY_EDGE_STEP < p->active_edge) {
+    edge = rounded + ENEMY_EDGE_STEP;
+  } else {
+    return;
+  }
+  p->active_edge = edge;
+  for (int s = 0; s <= p->wheel_mask; s++) p->wheel[s] = -1;
+  for (int i = world->enemy_count - 1; i >= 0; i--) { /* back to front: the enemy moved into i was checked */
+    if (p->x[i] <= edge) continue;
+    int slot = p->parked_free;
+    ParkedEnemy* r = &p->parked[slot];
+    p->parked_free = r->next;
+    p->parked_count++;
+    r->x = p->x[i];
+    r->y = p->y[i];
+    r->speed = p->speed[i];
+    r->rotation = p->rotation[i];
+    r->size = p->size[i];
+    r->rotation_speed = p->rotation_speed[i];
+    r->color = p->color[i];
+    r->id = p->id[i];
+    r->tick = p->tick;
+    r->due = 1; /* rescheduled below */
+    enemy_unlink(p, i);
+  }
+  for (int slot = 0; slot < world->max_enemies; slot++) { /* in record order rather than down the wheel's lists */
+    ParkedEnemy* r = &p->parked[slot];
+    if (!r->due) continue;
+    float k = (float)(p->tick - r->tick);
+    float x = r->x - r->speed * k;
+    if (x <= edge) {
+      enemy_activate(p, r, x, r->rotation + r->rotation_speed * k);
+      parked_release(p, slot);
+    } else {
+      r->due = parked_due(r, edge);
+      wheel_insert(p, slot);
+    }
+  }
+}
+
+/* Removes active enemy i; the last enemy takes its index */
+static void remove_enemy(int i) {
+  EnemyPool* p = &world->enemies;
+  p->free_ids[p->free_count++] = p->id[i];
+  enemy_unlink(p, i);
+}
+
+/* Puts the active world at the start of a match. Enemies spawn against the default 800x600 canvas until the
+   first update reports the real one, so a world's start does not depend on earlier matches. */
+static void world_reset(void) {
+  world->player_x = 100.f;
+  world->player_y = 400.f;
+  world->player_angle = 0.f;
+  world->bullet_count = 0;
+  world->enemy_count = 0;
+  world->enemies.free_count = 0;
+  world->enemies.next_id = 0;
+  world->enemies.band_begin = 0;
+  world->enemies.band_count = 0;
+  world->enemies.band_sorted = 0;
+  world->enemies.parked_count = 0;
+  world->enemies.parked_free = world->max_enemies > 0 ? 0 : -1;
+  world->enemies.tick = 0;
+  for (int i = 0; i < world->max_enemies; i++) {
+    world->enemies.parked[i].due = 0;
+    world->enemies.parked[i].next = i + 1 < world->max_enemies ? i + 1 : -1;
+  }
+  for (int s = 0; s <= world->enemies.wheel_mask; s++) world->enemies.wheel[s] = -1;
+  world->particles.tail = 0;
+  world->particles.count = 0;
+  world->shoot_cooldown = 0.f;
+  world->canvas_width = 800.f;
+  world->enemies.band_edge = world->canvas_width + BULLET_RADIUS;
+  world->enemies.active_edge = world->canvas_width + GAME_PUBLISH_MARGIN;
+  world->canvas_height = 600.f;
+  world->rng_state = 12345u;
+  world->updates = 0;
   
   /* Spawn initial enemies */
-  for (int i = 0; i < 100000 && i < MAX_ENEMIES; i++) {
+  for (int i = 0; i < world->max_enemies; i++) {
     spawn_enemy();
   }
 }
 
-void game_update(float dt, unsigned int keys_mask, float mouse_x, float mouse_y, int shoot, float cw, float ch) {
-  canvas_width = cw;
-  canvas_height = ch;
+void game_init(void) {
+  EnemyPool* p = &default_world.enemies;
+  p->x = default_enemies.x;
+  p->y = default_enemies.y;
+  p->speed = default_enemies.speed;
+  p->rotation = default_enemies.rotation;
+  p->size = default_enemies.size;
+  p->rotation_speed = default_enemies.rotation_speed;
+  p->color = default_enemies.color;
+  p->id = default_enemies.id;
+  p->free_ids = default_enemies.free_ids;
+  p->band_slot = default_enemies.band_slot;
+  p->band_index = default_enemies.band_index;
+  p->band_x = default_enemies.band_x;
+  p->band_speed = default_enemies.band_speed;
+  p->parked = default_enemies.parked;
+  p->wheel = default_enemies.wheel;
+  p->wheel_mask = enemy_wheel_slots(MAX_ENEMIES) - 1;
+  default_world.max_enemies = MAX_ENEMIES;
+  ParticleRing* r = &default_world.particles;
+  r->x = default_particles.x;
+  r->y = default_particles.y;
+  r->vx = default_particles.vx;
+  r->vy = default_particles.vy;
+  r->life = default_particles.life;
+  r->size = default_particles.size;
+  r->color = default_particles.color;
+  r->capacity = MAX_PARTICLES;
+  recording = 0;
+#if GAME_STATS
+  memset(&stats, 0, sizeof(stats));
+#endif
+  world_reset();
+}
+
+static void record_update(float dt, unsigned int keys_mask, float mouse_x, float mouse_y, int shoot, float cw, float ch) {
+  int first = record_count == 0;
+  unsigned char flags = (unsigned char)(keys_mask & GAME_RECORD_KEYS);
+  if (shoot) flags |= GAME_RECORD_SHOOT;
+  if (first || mouse_x != record_mouse_x || mouse_y != record_mouse_y) flags |= GAME_RECORD_MOUSE;
+  if (first || cw != record_canvas_width || ch != record_canvas_height) flags |= GAME_RECORD_CANVAS;
+  int bytes = 5 + ((flags & GAME_RECORD_MOUSE) ? 8 : 0) + ((flags & GAME_RECORD_CANVAS) ? 8 : 0);
+  if (record_size + bytes > GAME_RECORD_CAPACITY) {
+    recording = 0;
+    return;
+  }
+  unsigned char* out = record_log + record_size;
+  *out++ = flags;
+  memcpy(out, &dt, 4); out += 4;
+  if (flags & GAME_RECORD_MOUSE) {
+    memcpy(out, &mouse_x, 4); memcpy(out + 4, &mouse_y, 4); out += 8;
+    record_mouse_x = mouse_x;
+    record_mouse_y = mouse_y;
+  }
+  if (flags & GAME_RECORD_CANVAS) {
+    memcpy(out, &cw, 4); memcpy(out + 4, &ch, 4);
+    record_canvas_width = cw;
+    record_canvas_height = ch;
+  }
+  record_size += bytes;
+  record_count++;
+}
+
+typedef struct {
+  float x;
+  int index;
+} BandEntry;
+
+static int band_entry_cmp(const void* a, const void* b) {
+  const BandEntry* u = (const BandEntry*)a;
+  const BandEntry* v = (const BandEntry*)b;
+  return u->x < v->x ? -1 : u->x > v->x ? 1 : u->index - v->index;
+}
+
+/* Refills the band from scratch for a new band_edge (canvas resize), sorted with qsort */
+static void enemy_band_rebuild(float edge) {
+  EnemyPool* p = &world->enemies;
+  BandEntry* entries = (BandEntry*)malloc((size_t)world->enemy_count * sizeof(BandEntry) + 1);
+  int n = 0;
+  p->band_edge = edge;
+  p->band_begin = p->band_count = p->band_sorted = 0;
+  for (int i = 0; i < world->enemy_count; i++) {
+    p->band_slot[i] = -1;
+    if (p->x[i] > edge) continue;
+    if (entries) {
+      entries[n].x = p->x[i];
+      entries[n++].index = i;
+    } else {
+      band_join(p, i); /* out of memory: enemy_band_repair sorts them, slowly */
+    }
+  }
+  if (entries) {
+    qsort(entries, (size_t)n, sizeof(BandEntry), band_entry_cmp);
+    for (int k = 0; k < n; k++) band_join(p, entries[k].index);
+    p->band_sorted = n;
+    free(entries);
+  }
+}
+
+/* Restores the band order by insertion sort. Enemies in the band keep their relative order between updates
+   except where a faster one overtakes, so this is close to one compare per entry; only entries that move
+   have their band_slot rewritten. */
+static void enemy_band_repair(void) {
+  EnemyPool* p = &world->enemies;
+  float edge = world->canvas_width + BULLET_RADIUS;
+  if (edge != p->band_edge) enemy_band_rebuild(edge);
+  int* index = p->band_index;
+  float* key = p->band_x;
+  float* speed = p->band_speed;
+  for (int k = p->band_begin + 1; k < p->band_count; k++) {
+    if (key[k - 1] <= key[k]) continue;
+    int i = index[k];
+    float x = key[k], v = speed[k];
+    int m = k;
+    for (; m > p->band_begin && key[m - 1] > x; m--) {
+      key[m] = key[m - 1];
+      speed[m] = speed[m - 1];
+      index[m] = index[m - 1];
+      if (index[m] >= 0) p->band_slot[index[m]] = m;
+    }
+    key[m] = x;
+    speed[m] = v;
+    index[m] = i;
+    if (i >= 0) p->band_slot[i] = m;
+  }
+  while (p->band_begin < p->band_count && index[p->band_begin] < 0) p->band_begin++;
+  p->band_sorted = p->band_count;
+}
+
+/* Narrowphase for band entry j (-1 = removed): returns j if the bullet touches it and j is above hit */
+static int bullet_test(const EnemyPool* p, const Bullet* b, int j, int hit, int* tests) {
+  if (j <= hit) return hit;
+  float enemy_radius = p->size[j] / 2.f;
+  float dx = b->x - (p->x[j] + enemy_radius);
+  float dy = b->y - (p->y[j] + enemy_radius);
+  float reach = BULLET_RADIUS + enemy_radius;
+  ++*tests;
+  return dx * dx + dy * dy < reach * reach ? j : hit;
+}
+
+/* Sort-and-sweep query: highest-index enemy the bullet touches, or -1. A touching enemy's left edge lies in
+   (bullet x - BULLET_RADIUS - ENEMY_MAX_SIZE, bullet x + BULLET_RADIUS), found by binary search in the sorted
+   band; entries joined since the repair are few and tested as well. Distances are compared squared. */
+static int bullet_find_hit(const Bullet* b) {
+  const EnemyPool* p = &world->enemies;
+  float lo = b->x - BULLET_RADIUS - ENEMY_MAX_SIZE - 1.f, hi = b->x + BULLET_RADIUS + 1.f;
+  int first = p->band_begin, last = p->band_sorted;
+  while (first < last) {
+    int mid = (first + last) >> 1;
+    if (p->band_x[mid] < lo) first = mid + 1;
+    else last = mid;
+  }
+  int hit = -1, tests = 0;
+  for (int k = first; k < p->band_sorted && p->band_x[k] <= hi; k++) {
+    hit = bullet_test(p, b, p->band_index[k], hit, &tests);
+  }
+  for (int k = p->band_sorted; k < p->band_count; k++) {
+    hit = bullet_test(p, b, p->band_index[k], hit, &tests);
+  }
+  STATS_ADD(pair_tests, tests);
+  return hit;
+}
+
+/* Jobs bodies. Each writes only its own elements and per-chunk results, so the merge afterwards sees the
+   same values whatever the thread count. */
+
+/* Moves every enemy, counts those now off screen and lists those that crossed band_edge (branch free: every
+   index is stored, only crossings advance the list); both are handled afterwards, outside the jobs */
+static void enemy_move_range(void* ctx, int begin, int end, int worker) {
+  EnemyPool* p = &world->enemies;
+  float* restrict x = p->x;
+  float* restrict rotation = p->rotation;
+  const float* restrict speed = p->speed;
+  const float* restrict rotation_speed = p->rotation_speed;
+  const float* restrict size = p->size;
+  int* list = enemy_chunk_enter_list[begin / ENEMY_JOB_CHUNK];
+  float edge = p->band_edge;
+  int exits = 0, enters = 0;
+  (void)ctx;
+  (void)worker;
+  for (int i = begin; i < end; i++) {
+    float nx = x[i] - speed[i];
+    list[enters < ENEMY_ENTER_LIST ? enters : ENEMY_ENTER_LIST - 1] = i;
+    enters += (x[i] > edge) & (nx <= edge);
+    x[i] = nx;
+    rotation[i] += rotation_speed[i];
+    exits += nx + size[i] < 0.f;
+  }
+  enemy_chunk_exits[begin / ENEMY_JOB_CHUNK] = exits;
+  enemy_chunk_enters[begin / ENEMY_JOB_CHUNK] = enters;
+}
+
+static void particle_move_range(void* ctx, int begin, int end, int worker) {
+  (void)worker;
+  particles_integrate_logical(&world->particles, begin, end, *(const float*)ctx);
+}
+
+int game_set_thread_count(int threads) { return jobs_init(threads); }
+
+/* game_update for the active world */
+static void world_update(float dt, unsigned int keys_mask, float mouse_x, float mouse_y, int shoot, float cw, float ch) {
+  STATS_TIMER(player_start);
+  world->updates++;
+  world->canvas_width = cw;
+  world->canvas_height = ch;
   
   if (dt > 0.1f) dt = 0.1f;
   
   /* Player movement */
   if (keys_mask & 1) { /* W */
-    player_y = fmaxf(0.f, player_y - PLAYER_SPEED);
+    world->player_y = fmaxf(0.f, world->player_y - PLAYER_SPEED);
   }
   if (keys_mask & 2) { /* S */
-    player_y = fminf(canvas_height - player_height, player_y + PLAYER_SPEED);
+    world->player_y = fminf(world->canvas_height - PLAYER_HEIGHT, world->player_y + PLAYER_SPEED);
   }
   if (keys_mask & 4) { /* A */
-    player_x = fmaxf(0.f, player_x - PLAYER_SPEED);
+    world->player_x = fmaxf(0.f, world->player_x - PLAYER_SPEED);
   }
   if (keys_mask & 8) { /* D */
-    player_x = fminf(canvas_width - player_width, player_x + PLAYER_SPEED);
+    world->player_x = fminf(world->canvas_width - PLAYER_WIDTH, world->player_x + PLAYER_SPEED);
   }
   
   /* Calculate angle to mouse */
-  float dx = mouse_x - (player_x + player_width / 2.f);
-  float dy = mouse_y - (player_y + player_height / 2.f);
-  player_angle = atan2f(dy, dx);
+  float dx = mouse_x - (world->player_x + PLAYER_WIDTH / 2.f);
+  float dy = mouse_y - (world->player_y + PLAYER_HEIGHT / 2.f);
+  world->player_angle = atan2f(dy, dx);
   
   /* Shooting */
-  shoot_cooldown -= dt;
-  if (shoot && shoot_cooldown <= 0.f && bullet_count < MAX_BULLETS) {
-    shoot_cooldown = SHOOT_COOLDOWN_TIME;
-    Bullet* b = &bullets[bullet_count++];
-    b->x = player_x + player_width / 2.f;
-    b->y = player_y + player_height / 2.f;
-    b->vx = cosf(player_angle) * BULLET_SPEED;
-    b->vy = sinf(player_angle) * BULLET_SPEED;
+  world->shoot_cooldown -= dt;
+  if (shoot && world->shoot_cooldown <= 0.f && world->bullet_count < MAX_BULLETS) {
+    world->shoot_cooldown = SHOOT_COOLDOWN_TIME;
+    Bullet* b = &world->bullets[world->bullet_count++];
+    b->x = world->player_x + PLAYER_WIDTH / 2.f;
+    b->y = world->player_y + PLAYER_HEIGHT / 2.f;
+    b->vx = cosf(world->player_angle) * BULLET_SPEED;
+    b->vy = sinf(world->player_angle) * BULLET_SPEED;
     b->life = BULLET_LIFETIME;
+    STATS_ADD(bullet_spawns, 1);
   }
+  STATS_PHASE(player_ns, "player", player_start);
   
   /* Update bullets */
-  for (int i = bullet_count - 1; i >= 0; i--) {
-    Bullet* b = &bullets[i];
+  STATS_TIMER(bullet_start);
+  enemy_move_active_edge(&world->enemies, fmaxf(world->canvas_width + GAME_PUBLISH_MARGIN, net_view_edge(world)));
+  enemy_band_repair();
+  for (int i = world->bullet_count - 1; i >= 0; i--) {
+    Bullet* b = &world->bullets[i];
     b->x += b->vx * dt;
     b->y += b->vy * dt;
     b->life -= dt;
     
     int remove = 0;
-    if (b->life <= 0.f || b->x < 0.f || b->x > canvas_width || b->y < 0.f || b->y > canvas_height) {
+    if (b->life <= 0.f || b->x < 0.f || b->x > world->canvas_width || b->y < 0.f || b->y > world->canvas_height) {
       remove = 1;
     }
     
     /* Check collision with enemies */
-    if (!remove) {
-      for (int j = enemy_count - 1; j >= 0; j--) {
-        Enemy* e = &enemies[j];
-        if (!e->active) continue;
-        
-        float ex = e->x + e->width / 2.f;
-        float ey = e->y + e->height / 2.f;
-        float dist = sqrtf((b->x - ex) * (b->x - ex) + (b->y - ey) * (b->y - ey));
-        float enemy_radius = fmaxf(e->width, e->height) / 2.f;
-        
-        if (dist < BULLET_RADIUS + enemy_radius) {
-          /* Hit! */
-          e->active = 0;
-          remove = 1;
-          
-          /* Create explosion particles */
-          for (int k = 0; k < 8 && particle_count < MAX_PARTICLES; k++) {
-            Particle* p = &particles[particle_count++];
-            p->x = ex;
-            p->y = ey;
-            p->vx = rng_float(-2.f, 2.f);
-            p->vy = rng_float(-2.f, 2.f);
-            p->life = PARTICLE_LIFETIME;
-            p->size = rng_float(3.f, 6.f);
-            p->color = e->color;
-          }
-          
-          /* Spawn new enemy */
-          if (enemy_count < MAX_ENEMIES) {
-            spawn_enemy();
-          }
-          break;
-        }
+    int j = remove ? -1 : bullet_find_hit(b);
+    if (j >= 0) {
+      EnemyPool* e = &world->enemies;
+      float ex = e->x[j] + e->size[j] / 2.f;
+      float ey = e->y[j] + e->size[j] / 2.f;
+      unsigned int color = e->color[j];
+      
+      /* Hit! */
+      remove_enemy(j);
+      remove = 1;
+      STATS_ADD(hits, 1);
+      STATS_ADD(enemy_removals, 1);
+      
+      /* Create explosion particles; a full ring gives up its oldest */
+      ParticleRing* r = &world->particles;
+      for (int k = 0; k < GAME_EXPLOSION_PARTICLES; k++) {
+        int evicted;
+        int s = particles_emit(r, &evicted);
+        r->x[s] = ex;
+        r->y[s] = ey;
+        r->vx[s] = rng_float(-2.f, 2.f);
+        r->vy[s] = rng_float(-2.f, 2.f);
+        r->life[s] = PARTICLE_LIFETIME;
+        r->size[s] = rng_float(3.f, 6.f);
+        r->color[s] = color;
+        STATS_ADD(particle_spawns, 1);
+        STATS_ADD(particle_removals, evicted);
       }
+      
+      /* Spawn new enemy */
+      spawn_enemy();
     }
     
     if (remove) {
-      bullets[i] = bullets[--bullet_count];
+      world->bullets[i] = world->bullets[--world->bullet_count];
+      STATS_ADD(bullet_removals, 1);
     }
   }
+  STATS_PHASE(bullet_ns, "bullets", bullet_start);
   
-  /* Update enemies */
-  for (int i = enemy_count - 1; i >= 0; i--) {
-    Enemy* e = &enemies[i];
-    if (!e->active) continue;
-    
-    e->x -= e->speed;
-    e->rotation += e->rotationSpeed;
-    
-    /* Remove enemies that are off screen */
-    if (e->x + e->width < 0.f) {
-      e->active = 0;
-      if (enemy_count < MAX_ENEMIES) {
-        spawn_enemy();
-      }
+  /* Update enemies. Those due arrive first and move with the rest. The band's keys follow the move, then
+     those that crossed into it join; those that left the screen are removed back to front, only in chunks
+     that have any, so each hole is filled by an enemy already checked; their replacements are spawned
+     afterwards, in order. */
+  STATS_TIMER(enemy_start);
+  EnemyPool* pool = &world->enemies;
+  STATS_ADD(enemy_arrivals, enemy_arrivals(pool, world->updates));
+  int swept = world->enemy_count, exits = 0;
+  jobs_parallel_for(swept, ENEMY_JOB_CHUNK, enemy_move_range, 0);
+  pool->tick = world->updates;
+  for (int k = pool->band_begin; k < pool->band_count; k++) pool->band_x[k] -= pool->band_speed[k];
+  for (int c = 0; c * ENEMY_JOB_CHUNK < swept; c++) {
+    int enters = enemy_chunk_enters[c];
+    if (enters < ENEMY_ENTER_LIST) {
+      for (int k = 0; k < enters; k++) band_join(pool, enemy_chunk_enter_list[c][k]);
+      continue;
+    }
+    int begin = c * ENEMY_JOB_CHUNK, end = begin + ENEMY_JOB_CHUNK < swept ? begin + ENEMY_JOB_CHUNK : swept;
+    for (int i = begin; i < end; i++) {
+      if (pool->band_slot[i] < 0 && pool->x[i] <= pool->band_edge) band_join(pool, i);
+    }
+  }
+  for (int c = (swept - 1) / ENEMY_JOB_CHUNK; c >= 0; c--) {
+    if (!enemy_chunk_exits[c]) continue;
+    int begin = c * ENEMY_JOB_CHUNK, end = begin + ENEMY_JOB_CHUNK < swept ? begin + ENEMY_JOB_CHUNK : swept;
+    for (int i = end - 1; i >= begin; i--) {
+      if (pool->x[i] + pool->size[i] < 0.f) remove_enemy(i);
     }
+    exits += enemy_chunk_exits[c];
+  }
+  STATS_ADD(enemy_removals, exits);
+  for (int k = 0; k < exits; k++) {
+    spawn_enemy();
   }
   
+  STATS_PHASE(enemy_ns, "enemies", enemy_start);
+  
   /* Update particles */
-  for (int i = particle_count - 1; i >= 0; i--) {
-    Particle* p = &particles[i];
-    p->x += p->vx * dt;
-    p->y += p->vy * dt;
-    p->life -= dt;
-    p->vx *= 0.98f;
-    p->vy *= 0.98f;
-    
-    if (p->life <= 0.f) {
-      particles[i] = particles[--particle_count];
-    }
+  STATS_TIMER(particle_start);
+  jobs_parallel_for(world->particles.count, PARTICLE_JOB_CHUNK, particle_move_range, &dt);
+  STATS_ADD(particle_removals, particles_expire(&world->particles));
+  STATS_PHASE(particle_ns, "particles", particle_start);
+  
+  STATS_ADD(bullets, world->bullet_count);
+  STATS_ADD(enemies, world->enemy_count);
+  STATS_ADD(particles, world->particles.count);
+}
+
+void game_update(float dt, unsigned int keys_mask, float mouse_x, float mouse_y, int shoot, float cw, float ch) {
+#if GAME_STATS
+  unsigned int updates = stats.updates + 1;
+  memset(&stats, 0, sizeof(stats));
+  stats.updates = updates;
+#endif
+  STATS_TIMER(update_start);
+  if (recording) record_update(dt, keys_mask, mouse_x, mouse_y, shoot, cw, ch);
+  world_update(dt, keys_mask, mouse_x, mouse_y, shoot, cw, ch);
+  STATS_PHASE(update_ns, "game_update", update_start);
+}
+
+/* Worlds */
+GameWorld* game_world_default(void) { return &default_world; }
+
+GameWorld* game_world_create(int max_enemies) {
+  if (max_enemies <= 0 || max_enemies > MAX_ENEMIES) max_enemies = MAX_ENEMIES;
+  size_t n = (size_t)max_enemies;
+  int slots = enemy_wheel_slots(max_enemies);
+  GameWorld* w = (GameWorld*)malloc(sizeof(GameWorld) + n * ENEMY_POOL_ARRAYS * sizeof(float) + n * sizeof(ParkedEnemy) +
+                                    (size_t)slots * sizeof(int) + (size_t)GAME_WORLD_MAX_PARTICLES * 7 * sizeof(float));
+  if (!w) return 0;
+  float* f = (float*)(w + 1);
+  EnemyPool* p = &w->enemies;
+  p->x = f;
+  p->y = f + n;
+  p->speed = f + 2 * n;
+  p->rotation = f + 3 * n;
+  p->size = f + 4 * n;
+  p->rotation_speed = f + 5 * n;
+  p->color = (unsigned int*)(f + 6 * n);
+  p->id = p->color + n;
+  p->free_ids = p->color + 2 * n;
+  p->band_slot = (int*)(f + 9 * n);
+  p->band_index = p->band_slot + n;
+  p->band_x = f + 12 * n;
+  p->band_speed = f + 14 * n;
+  p->parked = (ParkedEnemy*)(f + ENEMY_POOL_ARRAYS * n);
+  p->wheel = (int*)(p->parked + n);
+  p->wheel_mask = slots - 1;
+  ParticleRing* r = &w->particles;
+  r->x = (float*)(p->wheel + slots);
+  r->y = r->x + GAME_WORLD_MAX_PARTICLES;
+  r->vx = r->x + 2 * GAME_WORLD_MAX_PARTICLES;
+  r->vy = r->x + 3 * GAME_WORLD_MAX_PARTICLES;
+  r->life = r->x + 4 * GAME_WORLD_MAX_PARTICLES;
+  r->size = r->x + 5 * GAME_WORLD_MAX_PARTICLES;
+  r->color = (unsigned int*)(r->x + 6 * GAME_WORLD_MAX_PARTICLES);
+  r->capacity = GAME_WORLD_MAX_PARTICLES;
+  w->max_enemies = max_enemies;
+  world = w;
+  world_reset();
+  world = &default_world;
+  return w;
+}
+
+void game_world_destroy(GameWorld* w) {
+  if (w != &default_world) free(w);
+}
+
+void game_world_update(GameWorld* w, float dt, unsigned int keys_mask, float mouse_x, float mouse_y, int shoot,
+                       float canvas_width, float canvas_height) {
+  GameInput in = { dt, keys_mask, mouse_x, mouse_y, shoot, canvas_width, canvas_height };
+  game_worlds_update(&w, 1, &in);
+}
+
+/* Worlds share nothing but the scratch above, so they are simply stepped in order, each one's data read
+   front to back in one block. Stats cover the whole batch. */
+void game_worlds_update(GameWorld* const* worlds, int n, const GameInput* inputs) {
+#if GAME_STATS
+  unsigned int updates = stats.updates + 1;
+  memset(&stats, 0, sizeof(stats));
+  stats.updates = updates;
+#endif
+  STATS_TIMER(update_start);
+  for (int i = 0; i < n; i++) {
+    const GameInput* in = &inputs[i];
+    world = worlds[i];
+    world_update(in->dt, in->keys_mask, in->mouse_x, in->mouse_y, in->shoot, in->canvas_width, in->canvas_height);
   }
+  world = &default_world;
+  STATS_PHASE(update_ns, "game_worlds_update", update_start);
+}
+
+void game_world_get_player(const GameWorld* w, float* x, float* y, float* angle) {
+  *x = w->player_x;
+  *y = w->player_y;
+  *angle = w->player_angle;
+}
+
+/* Replication (netcode.h). Positions go as quarter pixels offset by NET_POS_OFFSET, so the range covers the
+   spawn band right of the canvas; angles wrap to their field width. */
+#define NET_POS_OFFSET 4096.f
+#define NET_POS_SCALE 4.f
+#define NET_SIZE_SCALE 4.f
+enum { NET_POS, NET_ANGLE, NET_SIZE, NET_RAW };
+
+static const NetSchema net_schemas[GAME_NET_CLASSES] = {
+  { 3, { 18, 16, 12 }, { 4, 4, 4 } },                         /* player: x, y, angle */
+  { 2, { 18, 16 }, { 1, 1 } },                                /* bullets: x, y */
+  { 5, { 18, 16, 8, 8, 24 }, { 3, 3, -1, 1, -1 } },           /* enemies: x, y, size, rotation, color */
+};
+static const unsigned char net_kinds[GAME_NET_CLASSES][NET_MAX_FIELDS] = {
+  { NET_POS, NET_POS, NET_ANGLE },
+  { NET_POS, NET_POS },
+  { NET_POS, NET_POS, NET_SIZE, NET_ANGLE, NET_RAW },
+};
+static const int net_capacities[GAME_NET_CLASSES] = { 1, MAX_BULLETS, GAME_NET_MAX_ENEMIES };
+
+typedef struct {
+  const GameWorld* world; /* 0 = closed */
+  int has_view;
+  float view[4];          /* min_x, min_y, max_x, max_y */
+  unsigned int next_seq;  /* seq of the next snapshot, from 1 */
+  unsigned int acked;     /* newest acknowledged seq, 0 = none */
+  NetHistory history;
+} NetClient;
+
+struct GameNetReplica {
+  unsigned int latest; /* seq of the newest decoded snapshot */
+  NetHistory history;
+};
+
+static NetClient net_clients[GAME_NET_MAX_CLIENTS];
+
+static unsigned int net_quantize(float v, int kind, int bits) {
+  unsigned int max = (1u << bits) - 1u;
+  if (kind == NET_ANGLE) {
+    float turns = fmodf(v * (1.f / 6.28318530718f), 1.f);
+    return (unsigned int)(int)floorf(turns * (float)(1u << bits) + 0.5f) & max;
+  }
+  float q = kind == NET_POS ? (v + NET_POS_OFFSET) * NET_POS_SCALE : v * NET_SIZE_SCALE;
+  q += 0.5f;
+  return q <= 0.f ? 0u : q >= (float)max ? max : (unsigned int)q;
+}
+
+static float net_dequantize(unsigned int q, int kind, int bits) {
+  if (kind == NET_POS) return (float)q * (1.f / NET_POS_SCALE) - NET_POS_OFFSET;
+  if (kind == NET_ANGLE) return (float)q * (6.28318530718f / (float)(1u << bits));
+  if (kind == NET_SIZE) return (float)q * (1.f / NET_SIZE_SCALE);
+  return (float)q;
+}
+
+static unsigned int* net_push(NetFrame* f, int cls, unsigned int id, int count, const float* values) {
+  const NetSchema* s = &net_schemas[cls];
+  unsigned int* v = net_entities_push(&f->classes[cls], s, id);
+  if (v) {
+    for (int i = 0; i < count; i++) v[i] = net_quantize(values[i], net_kinds[cls][i], s->bits[i]);
+  }
+  return v;
+}
+
+typedef struct {
+  unsigned int id;
+  int index;
+} NetEnemyRef;
+
+static NetEnemyRef net_enemy_refs[GAME_NET_MAX_ENEMIES];
+
+static int net_enemy_ref_cmp(const void* a, const void* b) {
+  unsigned int x = ((const NetEnemyRef*)a)->id, y = ((const NetEnemyRef*)b)->id;
+  return (x > y) - (x < y);
+}
+
+/* Interest filter: what overlaps the client's view grown by GAME_NET_VIEW_MARGIN. Enemies go in id order,
+   which their array order is not. */
+static void net_capture(const NetClient* c, NetFrame* f) {
+  const GameWorld* w = c->world;
+  float x0 = c->has_view ? c->view[0] : 0.f, y0 = c->has_view ? c->view[1] : 0.f;
+  float x1 = c->has_view ? c->view[2] : w->canvas_width, y1 = c->has_view ? c->view[3] : w->canvas_height;
+  x0 -= GAME_NET_VIEW_MARGIN;
+  y0 -= GAME_NET_VIEW_MARGIN;
+  x1 += GAME_NET_VIEW_MARGIN;
+  y1 += GAME_NET_VIEW_MARGIN;
+  
+  float player[3] = { w->player_x, w->player_y, w->player_angle };
+  net_push(f, GAME_NET_PLAYER, 0, 3, player);
+  for (int i = 0; i < w->bullet_count; i++) {
+    const Bullet* b = &w->bullets[i];
+    if (b->x < x0 || b->x > x1 || b->y < y0 || b->y > y1) continue;
+    float v[2] = { b->x, b->y };
+    net_push(f, GAME_NET_BULLETS, (unsigned int)i, 2, v);
+  }
+  const EnemyPool* e = &w->enemies;
+  int n = 0;
+  for (int j = 0; j < w->enemy_count && n < GAME_NET_MAX_ENEMIES; j++) {
+    if (e->x[j] + e->size[j] < x0 || e->x[j] > x1 || e->y[j] + e->size[j] < y0 || e->y[j] > y1) continue;
+    net_enemy_refs[n].id = e->id[j];
+    net_enemy_refs[n++].index = j;
+  }
+  qsort(net_enemy_refs, (size_t)n, sizeof(NetEnemyRef), net_enemy_ref_cmp);
+  for (int k = 0; k < n; k++) {
+    int j = net_enemy_refs[k].index;
+    float v[4] = { e->x[j], e->y[j], e->size[j], e->rotation[j] };
+    unsigned int* q = net_push(f, GAME_NET_ENEMIES, e->id[j], 4, v);
+    q[GAME_NET_COLOR] = e->color[j] & 0xFFFFFFu;
+  }
+}
+
+/* Right edge of what the world's clients see, view margin included; views default to the canvas, which the
+   active edge covers anyway */
+static float net_view_edge(const GameWorld* w) {
+  float edge = 0.f;
+  for (int i = 0; i < GAME_NET_MAX_CLIENTS; i++) {
+    const NetClient* c = &net_clients[i];
+    if (c->world == w && c->has_view) edge = fmaxf(edge, c->view[2] + GAME_NET_VIEW_MARGIN);
+  }
+  return edge;
+}
+
+static NetClient* net_client(int client) {
+  return client >= 0 && client < GAME_NET_MAX_CLIENTS && net_clients[client].world ? &net_clients[client] : 0;
+}
+
+int game_net_client_open(const GameWorld* w) {
+  for (int i = 0; i < GAME_NET_MAX_CLIENTS; i++) {
+    NetClient* c = &net_clients[i];
+    if (c->world) continue;
+    if (!net_history_init(&c->history, GAME_NET_CLASSES, net_schemas, net_capacities)) return -1;
+    c->world = w ? w : &default_world;
+    c->has_view = 0;
+    c->next_seq = 1;
+    c->acked = 0;
+    return i;
+  }
+  return -1;
+}
+
+void game_net_client_close(int client) {
+  NetClient* c = net_client(client);
+  if (!c) return;
+  net_history_free(&c->history);
+  c->world = 0;
+}
+
+void game_net_client_view(int client, float min_x, float min_y, float max_x, float max_y) {
+  NetClient* c = net_client(client);
+  if (!c) return;
+  c->has_view = 1;
+  c->view[0] = min_x;
+  c->view[1] = min_y;
+  c->view[2] = max_x;
+  c->view[3] = max_y;
+}
+
+int game_net_encode(int client, unsigned char* out, int capacity) {
+  NetClient* c = net_client(client);
+  if (!c) return -1;
+  unsigned int seq = c->next_seq;
+  const NetFrame* base = c->acked && seq - c->acked < NET_HISTORY ? net_history_find(&c->history, c->acked) : 0;
+  NetFrame* f = net_history_claim(&c->history, seq, c->world->updates);
+  net_capture(c, f);
+  int bytes = net_encode_frame(&c->history, base, f, out, capacity);
+  if (bytes < 0) {
+    f->seq = 0;
+    return -1;
+  }
+  c->next_seq++;
+  return bytes;
+}
+
+void game_net_ack(int client, unsigned int seq) {
+  NetClient* c = net_client(client);
+  if (c && seq > c->acked && seq < c->next_seq && net_history_find(&c->history, seq)) c->acked = seq;
+}
+
+GameNetReplica* game_net_replica_create(void) {
+  GameNetReplica* r = (GameNetReplica*)malloc(sizeof(GameNetReplica));
+  if (!r) return 0;
+  r->latest = 0;
+  if (!net_history_init(&r->history, GAME_NET_CLASSES, net_schemas, net_capacities)) {
+    free(r);
+    return 0;
+  }
+  return r;
+}
+
+void game_net_replica_destroy(GameNetReplica* r) {
+  if (!r) return;
+  net_history_free(&r->history);
+  free(r);
+}
+
+unsigned int game_net_replica_apply(GameNetReplica* r, const unsigned char* data, int size) {
+  const NetFrame* f = net_decode_frame(&r->history, data, size);
+  if (!f) return 0;
+  if (f->seq > r->latest) r->latest = f->seq;
+  return f->seq;
+}
+
+static const NetEntities* net_replica_class(const GameNetReplica* r, int cls) {
+  const NetFrame* f = net_history_find(&r->history, r->latest);
+  return f && cls >= 0 && cls < GAME_NET_CLASSES ? &f->classes[cls] : 0;
+}
+
+unsigned int game_net_replica_tick(const GameNetReplica* r) {
+  const NetFrame* f = net_history_find(&r->history, r->latest);
+  return f ? f->tick : 0;
+}
+
+int game_net_replica_count(const GameNetReplica* r, int cls) {
+  const NetEntities* e = net_replica_class(r, cls);
+  return e ? e->count : 0;
+}
+
+unsigned int game_net_replica_id(const GameNetReplica* r, int cls, int i) {
+  const NetEntities* e = net_replica_class(r, cls);
+  return e && i >= 0 && i < e->count ? e->ids[i] : 0;
+}
+
+float game_net_replica_field(const GameNetReplica* r, int cls, int i, int field) {
+  const NetEntities* e = net_replica_class(r, cls);
+  if (!e || i < 0 || i >= e->count || field < 0 || field >= net_schemas[cls].fields) return 0.f;
+  return net_dequantize(e->values[(size_t)i * (size_t)net_schemas[cls].fields + (size_t)field], net_kinds[cls][field],
+                        net_schemas[cls].bits[field]);
 }
 
 /* Player getters */
 void game_get_player_position(float* x, float* y) {
-  *x = player_x;
-  *y = player_y;
+  *x = world->player_x;
+  *y = world->player_y;
 }
 
-float game_get_player_x(void) { return player_x; }
-float game_get_player_y(void) { return player_y; }
-float game_get_player_angle(void) { return player_angle; }
+float game_get_player_x(void) { return world->player_x; }
+float game_get_player_y(void) { return world->player_y; }
+float game_get_player_angle(void) { return world->player_angle; }
 
 /* Bullet getters */
-int game_get_bullet_count(void) { return bullet_count; }
+int game_get_bullet_count(void) { return world->bullet_count; }
 
 void game_get_bullet(int i, float* x, float* y, float* vx, float* vy) {
-  if (i < 0 || i >= bullet_count) return;
-  Bullet* b = &bullets[i];
+  if (i < 0 || i >= world->bullet_count) return;
+  Bullet* b = &world->bullets[i];
   *x = b->x;
   *y = b->y;
   *vx = b->vx;
   *vy = b->vy;
 }
 
-float game_get_bullet_x(int i) { return (i >= 0 && i < bullet_count) ? bullets[i].x : 0.f; }
-float game_get_bullet_y(int i) { return (i >= 0 && i < bullet_count) ? bullets[i].y : 0.f; }
-float game_get_bullet_vx(int i) { return (i >= 0 && i < bullet_count) ? bullets[i].vx : 0.f; }
-float game_get_bullet_vy(int i) { return (i >= 0 && i < bullet_count) ? bullets[i].vy : 0.f; }
+float game_get_bullet_x(int i) { return (i >= 0 && i < world->bullet_count) ? world->bullets[i].x : 0.f; }
+float game_get_bullet_y(int i) { return (i >= 0 && i < world->bullet_count) ? world->bullets[i].y : 0.f; }
+float game_get_bullet_vx(int i) { return (i >= 0 && i < world->bullet_count) ? world->bullets[i].vx : 0.f; }
+float game_get_bullet_vy(int i) { return (i >= 0 && i < world->bullet_count) ? world->bullets[i].vy : 0.f; }
 
 /* Enemy getters */
-int game_get_enemy_count(void) { return enemy_count; }
+int game_get_enemy_count(void) { return world->enemy_count; }
 
 void game_get_enemy(int i, float* x, float* y, float* width, float* height, float* rotation, unsigned int* color) {
-  if (i < 0 || i >= enemy_count) return;
-  Enemy* e = &enemies[i];
-  *x = e->x;
-  *y = e->y;
-  *width = e->width;
-  *height = e->height;
-  *rotation = e->rotation;
-  *color = e->color;
-}
-
-float game_get_enemy_x(int i) { return (i >= 0 && i < enemy_count) ? enemies[i].x : 0.f; }
-float game_get_enemy_y(int i) { return (i >= 0 && i < enemy_count) ? enemies[i].y : 0.f; }
-float game_get_enemy_width(int i) { return (i >= 0 && i < enemy_count) ? enemies[i].width : 0.f; }
-float game_get_enemy_height(int i) { return (i >= 0 && i < enemy_count) ? enemies[i].height : 0.f; }
-float game_get_enemy_rotation(int i) { return (i >= 0 && i < enemy_count) ? enemies[i].rotation : 0.f; }
-unsigned int game_get_enemy_color(int i) { return (i >= 0 && i < enemy_count) ? enemies[i].color : 0x808080; }
-
-/* Particle getters */
-int game_get_particle_count(void) { return particle_count; }
+  if (i < 0 || i >= world->enemy_count) return;
+  const EnemyPool* e = &world->enemies;
+  *x = e->x[i];
+  *y = e->y[i];
+  *width = e->size[i];
+  *height = e->size[i];
+  *rotation = e->rotation[i];
+  *color = e->color[i];
+}
+
+float game_get_enemy_x(int i) { return (i >= 0 && i < world->enemy_count) ? world->enemies.x[i] : 0.f; }
+float game_get_enemy_y(int i) { return (i >= 0 && i < world->enemy_count) ? world->enemies.y[i] : 0.f; }
+float game_get_enemy_width(int i) { return (i >= 0 && i < world->enemy_count) ? world->enemies.size[i] : 0.f; }
+float game_get_enemy_height(int i) { return (i >= 0 && i < world->enemy_count) ? world->enemies.size[i] : 0.f; }
+float game_get_enemy_rotation(int i) { return (i >= 0 && i < world->enemy_count) ? world->enemies.rotation[i] : 0.f; }
+unsigned int game_get_enemy_color(int i) { return (i >= 0 && i < world->enemy_count) ? world->enemies.color[i] : 0x808080; }
+unsigned int game_get_enemy_id(int i) { return (i >= 0 && i < world->enemy_count) ? world->enemies.id[i] : 0u; }
+
+/* Particle getters: oldest first */
+int game_get_particle_count(void) { return world->particles.count; }
+
+static int particle_at(int i) { return (i >= 0 && i < world->particles.count) ? particle_slot(&world->particles, i) : -1; }
 
 void game_get_particle(int i, float* x, float* y, float* vx, float* vy, float* life, float* size, unsigned int* color) {
-  if (i < 0 || i >= particle_count) return;
-  Particle* p = &particles[i];
-  *x = p->x;
-  *y = p->y;
-  *vx = p->vx;
-  *vy = p->vy;
-  *life = p->life;
-  *size = p->size;
-  *color = p->color;
-}
-
-float game_get_particle_x(int i) { return (i >= 0 && i < particle_count) ? particles[i].x : 0.f; }
-float game_get_particle_y(int i) { return (i >= 0 && i < particle_count) ? particles[i].y : 0.f; }
-float game_get_particle_vx(int i) { return (i >= 0 && i < particle_count) ? particles[i].vx : 0.f; }
-float game_get_particle_vy(int i) { return (i >= 0 && i < particle_count) ? particles[i].vy : 0.f; }
-float game_get_particle_life(int i) { return (i >= 0 && i < particle_count) ? particles[i].life : 0.f; }
-float game_get_particle_size(int i) { return (i >= 0 && i < particle_count) ? particles[i].size : 0.f; }
-unsigned int game_get_particle_color(int i) { return (i >= 0 && i < particle_count) ? particles[i].color : 0x808080; }
+  int s = particle_at(i);
+  if (s < 0) return;
+  const ParticleRing* r = &world->particles;
+  *x = r->x[s];
+  *y = r->y[s];
+  *vx = r->vx[s];
+  *vy = r->vy[s];
+  *life = r->life[s];
+  *size = r->size[s];
+  *color = r->color[s];
+}
+
+float game_get_particle_x(int i) { int s = particle_at(i); return s >= 0 ? world->particles.x[s] : 0.f; }
+float game_get_particle_y(int i) { int s = particle_at(i); return s >= 0 ? world->particles.y[s] : 0.f; }
+float game_get_particle_vx(int i) { int s = particle_at(i); return s >= 0 ? world->particles.vx[s] : 0.f; }
+float game_get_particle_vy(int i) { int s = particle_at(i); return s >= 0 ? world->particles.vy[s] : 0.f; }
+float game_get_particle_life(int i) { int s = particle_at(i); return s >= 0 ? world->particles.life[s] : 0.f; }
+float game_get_particle_size(int i) { int s = particle_at(i); return s >= 0 ? world->particles.size[s] : 0.f; }
+unsigned int game_get_particle_color(int i) { int s = particle_at(i); return s >= 0 ? world->particles.color[s] : 0x808080; }
+
+/* Input recording: the log starts from a fresh game_init, so replays need nothing but the log itself */
+void game_record_start(void) {
+  unsigned int header[2] = { GAME_RECORD_MAGIC, GAME_RECORD_VERSION };
+  game_init();
+  memcpy(record_log, header, GAME_RECORD_HEADER_BYTES);
+  record_size = GAME_RECORD_HEADER_BYTES;
+  record_count = 0;
+  recording = 1;
+}
+
+int game_record_stop(void) {
+  recording = 0;
+  return record_size;
+}
+
+int game_get_record_size(void) { return record_size; }
+const unsigned char* game_get_record_data(void) { return record_log; }
+
+/* Published frames (game.h). The writer owns publish_back; the other two frames belong to the exchange word
+   and the reader. Frames start as zeros, so a reader that looks before the first publish sees an empty one. */
+static unsigned int publish_frames[3][GAME_PUBLISH_FRAME_WORDS];
+static int publish_exchange = 1;
+static int publish_back;
+static unsigned int publish_seq;
+
+static void publish_float(unsigned int* word, float v) { memcpy(word, &v, sizeof(float)); }
+
+/* Writes the player, the canvas and everything overlapping [x0, x1] x [y0, y1] into f in the published-frame
+   layout, each section packed right after the previous one; the seq words are left to the caller */
+static void render_list_write(unsigned int* f, float x0, float y0, float x1, float y1) {
+  publish_float(&f[GAME_PUB_PLAYER_X], world->player_x);
+  publish_float(&f[GAME_PUB_PLAYER_Y], world->player_y);
+  publish_float(&f[GAME_PUB_PLAYER_ANGLE], world->player_angle);
+  publish_float(&f[GAME_PUB_CANVAS_WIDTH], world->canvas_width);
+  publish_float(&f[GAME_PUB_CANVAS_HEIGHT], world->canvas_height);
+
+  unsigned int offset = GAME_PUB_HEADER_WORDS, n = 0;
+  f[GAME_PUB_ENEMY_OFFSET] = offset;
+  const EnemyPool* e = &world->enemies;
+  for (int i = 0; i < world->enemy_count && n < GAME_PUBLISH_MAX_ENEMIES; i++) {
+    if (e->x[i] + e->size[i] < x0 || e->x[i] > x1 || e->y[i] + e->size[i] < y0 || e->y[i] > y1) continue;
+    unsigned int* w = &f[offset + n++ * GAME_PUB_ENEMY_WORDS];
+    publish_float(&w[0], e->x[i]);
+    publish_float(&w[1], e->y[i]);
+    publish_float(&w[2], e->size[i]);
+    publish_float(&w[3], e->size[i]);
+    publish_float(&w[4], e->rotation[i]);
+    w[5] = e->color[i];
+  }
+  f[GAME_PUB_ENEMY_COUNT] = n;
+
+  offset += n * GAME_PUB_ENEMY_WORDS;
+  n = 0;
+  f[GAME_PUB_BULLET_OFFSET] = offset;
+  for (int i = 0; i < world->bullet_count; i++) {
+    const Bullet* b = &world->bullets[i];
+    if (b->x + BULLET_RADIUS < x0 || b->x - BULLET_RADIUS > x1 || b->y + BULLET_RADIUS < y0 || b->y - BULLET_RADIUS > y1) continue;
+    unsigned int* w = &f[offset + n++ * GAME_PUB_BULLET_WORDS];
+    publish_float(&w[0], b->x);
+    publish_float(&w[1], b->y);
+  }
+  f[GAME_PUB_BULLET_COUNT] = n;
+
+  offset += n * GAME_PUB_BULLET_WORDS;
+  n = 0;
+  f[GAME_PUB_PARTICLE_OFFSET] = offset;
+  const ParticleRing* r = &world->particles;
+  for (int i = r->count - 1; i >= 0 && n < GAME_PUBLISH_MAX_PARTICLES; i--) { /* newest first: the cap drops faded ones */
+    int s = particle_slot(r, i);
+    float px = r->x[s], py = r->y[s], size = r->size[s];
+    if (px + size < x0 || px - size > x1 || py + size < y0 || py - size > y1) continue;
+    unsigned int* w = &f[offset + n++ * GAME_PUB_PARTICLE_WORDS];
+    publish_float(&w[0], px);
+    publish_float(&w[1], py);
+    publish_float(&w[2], r->life[s]);
+    publish_float(&w[3], size);
+    w[4] = r->color[s];
+  }
+  f[GAME_PUB_PARTICLE_COUNT] = n;
+}
+
+unsigned int game_publish_frame(void) {
+  unsigned int* f = publish_frames[publish_back];
+  unsigned int seq = ++publish_seq;
+  f[GAME_PUB_SEQ] = seq;
+  render_list_write(f, -GAME_PUBLISH_MARGIN, -GAME_PUBLISH_MARGIN, world->canvas_width + GAME_PUBLISH_MARGIN,
+                    world->canvas_height + GAME_PUBLISH_MARGIN);
+  f[GAME_PUBLISH_FRAME_WORDS - 1] = seq;
+
+  /* Release the frame to the reader and take back whichever one it is not holding */
+  publish_back = __atomic_exchange_n(&publish_exchange, publish_back | GAME_PUBLISH_FRESH, __ATOMIC_ACQ_REL) & 3;
+  return seq;
+}
+
+const unsigned int* game_get_publish_frames(void) { return &publish_frames[0][0]; }
+int* game_get_publish_exchange(void) { return &publish_exchange; }
+int game_get_publish_frame_words(void) { return GAME_PUBLISH_FRAME_WORDS; }
+
+/* Render list: one more frame, rebuilt on request for a renderer on the simulation's thread */
+static unsigned int render_list[GAME_PUBLISH_FRAME_WORDS];
+
+const unsigned int* game_build_render_list(float min_x, float min_y, float max_x, float max_y) {
+  render_list[GAME_PUB_SEQ] = render_list[GAME_PUBLISH_FRAME_WORDS - 1] = world->updates;
+  render_list_write(render_list, min_x, min_y, max_x, max_y);
+  return render_list;
+}
+
+/* State hash (hash.h) */
+static unsigned long long state_hash(const GameWorld* w) {
+  const EnemyPool* e = &w->enemies;
+  const float scalars[] = { w->player_x, w->player_y, w->player_angle, w->shoot_cooldown, w->canvas_width, w->canvas_height,
+                            e->active_edge };
+  const ParticleRing* r = &w->particles;
+  const int counts[] = { w->bullet_count, w->enemy_count, r->count, (int)w->rng_state, e->free_count, (int)e->next_id,
+                         e->parked_count, (int)e->tick };
+  const size_t n = (size_t)w->enemy_count * sizeof(float);
+  unsigned long long h = 0x243F6A8885A308D3ull;
+  h = hash_bytes(h, scalars, sizeof(scalars));
+  h = hash_bytes(h, counts, sizeof(counts));
+  h = hash_bytes(h, w->bullets, (size_t)w->bullet_count * sizeof(Bullet));
+  h = hash_bytes(h, e->x, n);
+  h = hash_bytes(h, e->y, n);
+  h = hash_bytes(h, e->speed, n);
+  h = hash_bytes(h, e->rotation, n);
+  h = hash_bytes(h, e->size, n);
+  h = hash_bytes(h, e->rotation_speed, n);
+  h = hash_bytes(h, e->color, n);
+  h = hash_bytes(h, e->id, n);
+  h = hash_bytes(h, e->free_ids, (size_t)e->free_count * sizeof(unsigned int));
+  for (int s = 0; s <= e->wheel_mask; s++) { /* parked enemies in wheel order; where a record is stored is not state */
+    for (int slot = e->wheel[s]; slot >= 0; slot = e->parked[slot].next) h = hash_bytes(h, &e->parked[slot], offsetof(ParkedEnemy, next));
+  }
+  const float* particle_arrays[] = { r->x, r->y, r->vx, r->vy, r->life, r->size, (const float*)r->color };
+  int run = r->capacity - r->tail < r->count ? r->capacity - r->tail : r->count; /* the live slots wrap at most once */
+  for (int a = 0; a < 7; a++) {
+    h = hash_bytes(h, particle_arrays[a] + r->tail, (size_t)run * sizeof(float));
+    h = hash_bytes(h, particle_arrays[a], (size_t)(r->count - run) * sizeof(float));
+  }
+  return h;
+}
+
+unsigned long long game_state_hash(void) { return state_hash(world); }
+unsigned long long game_world_state_hash(const GameWorld* w) { return state_hash(w); }
+
+/* Instrumentation */
+#if GAME_STATS
+const GameStats* game_get_stats(void) { return &stats; }
+
+#ifndef __EMSCRIPTEN__
+int game_trace_begin(const char* path) { return stats_trace_open(path); }
+void game_trace_end(void) { stats_trace_close(); }
+#endif
+#else
+const GameStats* game_get_stats(void) { return 0; }
+#endif
@@ -5,12 +5,63 @@
 extern "C" {
 #endif
 
+#ifndef MAX_BULLETS
 #define MAX_BULLETS 1000
-#define MAX_ENEMIES 100000
-#define MAX_PARTICLES 1000
+#endif
+#ifndef MAX_ENEMIES
+#define MAX_ENEMIES 100000 /* live enemies: game_init spawns this many and every removed one is replaced */
+#endif
+#ifndef MAX_PARTICLES
+#define MAX_PARTICLES 131072 /* particle ring of the default world; when full, new particles replace the oldest */
+#endif
+#ifndef GAME_EXPLOSION_PARTICLES
+#define GAME_EXPLOSION_PARTICLES 8 /* per destroyed enemy; raise it to load the particle pass */
+#endif
+#ifndef GAME_STATS
+#define GAME_STATS 0 /* 1 = time game_update phases and count their work into GameStats (game_get_stats) */
+#endif
+
+/* Phase timings (ns) and work counters of the last game_update, returned by game_get_stats in GAME_STATS
+   builds. Every field is a uint32, so JS can view it as a Uint32Array in field order. */
+typedef struct {
+  unsigned int updates;          /* game_update calls since game_init */
+  unsigned int update_ns;        /* whole game_update */
+  unsigned int player_ns;        /* movement, aim and firing */
+  unsigned int bullet_ns;        /* bullet motion, band repair and hit queries */
+  unsigned int enemy_ns;         /* enemy sweep */
+  unsigned int particle_ns;      /* particle integration */
+  unsigned int pair_tests;       /* bullet x band candidate distance tests */
+  unsigned int hits;             /* enemies destroyed by bullets */
+  unsigned int bullet_spawns;
+  unsigned int enemy_spawns;
+  unsigned int enemy_arrivals;   /* parked enemies activated */
+  unsigned int particle_spawns;
+  unsigned int bullet_removals;
+  unsigned int enemy_removals;   /* hit or left the screen */
+  unsigned int particle_removals;
+  unsigned int bullets;          /* live after the update */
+  unsigned int enemies;          /* active after the update */
+  unsigned int particles;        /* live after the update */
+} GameStats;
+#define GAME_STATS_FIELDS 18
+
+/* Input log (little-endian): u32 GAME_RECORD_MAGIC, u32 GAME_RECORD_VERSION, then one record per game_update:
+   u8 flags (keys_mask in the low 4 bits), f32 dt, f32 mouse_x, mouse_y if GAME_RECORD_MOUSE,
+   f32 canvas_width, canvas_height if GAME_RECORD_CANVAS. Replayed by native/replay.c. */
+#define GAME_RECORD_MAGIC 0x50523254u /* "T2RP" */
+#define GAME_RECORD_VERSION 1
+#define GAME_RECORD_HEADER_BYTES 8
+#define GAME_RECORD_KEYS 15
+#define GAME_RECORD_SHOOT 16
+#define GAME_RECORD_MOUSE 32  /* mouse position changed since the previous record */
+#define GAME_RECORD_CANVAS 64 /* canvas size changed since the previous record */
+#ifndef GAME_RECORD_CAPACITY
+#define GAME_RECORD_CAPACITY (1 << 20)
+#endif
 
 void game_init(void);
 void game_update(float dt, unsigned int keys_mask, float mouse_x, float mouse_y, int shoot, float canvas_width, float canvas_height);
+int game_set_thread_count(int threads); /* threads for parallel phases incl. the caller; returns the count in use (1 unless GAME_THREADS) */
 void game_get_player_position(float* x, float* y);
 float game_get_player_x(void);
 float game_get_player_y(void);
@@ -21,7 +72,9 @@ float game_get_bullet_x(int i);
 float game_get_bullet_y(int i);
 float game_get_bullet_vx(int i);
 float game_get_bullet_vy(int i);
-int game_get_enemy_count(void);
+/* Enemies far right of the screen are parked: not stepped and not among these until they reach the canvas plus
+   GAME_PUBLISH_MARGIN or a replication view (from the update after the view is set). */
+int game_get_enemy_count(void); /* active enemies 0..count-1, all live; removing one moves the last into its index */
 void game_get_enemy(int i, float* x, float* y, float* width, float* height, float* rotation, unsigned int* color);
 float game_get_enemy_x(int i);
 float game_get_enemy_y(int i);
@@ -29,7 +82,8 @@ float game_get_enemy_width(int i);
 float game_get_enemy_height(int i);
 float game_get_enemy_rotation(int i);
 unsigned int game_get_enemy_color(int i);
-int game_get_particle_count(void);
+unsigned int game_get_enemy_id(int i); /* stable while the enemy lives, below MAX_ENEMIES; reused after */
+int game_get_particle_count(void); /* particles 0..count-1, oldest first */
 void game_get_particle(int i, float* x, float* y, float* vx, float* vy, float* life, float* size, unsigned int* color);
 float game_get_particle_x(int i);
 float game_get_particle_y(int i);
@@ -38,6 +92,117 @@ float game_get_particle_vy(int i);
 float game_get_particle_life(int i);
 float game_get_particle_size(int i);
 unsigned int game_get_particle_color(int i);
+void game_record_start(void); /* restarts the game (game_init) and logs every game_update from here */
+int game_record_stop(void);   /* returns the log size in bytes */
+int game_get_record_size(void);
+const unsigned char* game_get_record_data(void);
+unsigned long long game_state_hash(void); /* 64-bit hash of all simulation state (live entries only) */
+const GameStats* game_get_stats(void); /* 0 unless built with GAME_STATS */
+#if GAME_STATS && !defined(__EMSCRIPTEN__)
+int game_trace_begin(const char* path); /* native only: write every timed phase to a Chrome trace (chrome://tracing) */
+void game_trace_end(void);
+#endif
+
+/* Published frames: what the renderer draws, for a simulation running on another thread (js/sim_worker.js)
+   over shared memory. game_publish_frame culls the default world against its canvas grown by
+   GAME_PUBLISH_MARGIN and writes the enemies, bullets and particles overlapping it into one of three frames of
+   GAME_PUBLISH_FRAME_WORDS uint32 words (floats stored as their bits), each section packed after the last. Triple buffered without locks: the exchange word holds the index of
+   the newest complete frame, plus GAME_PUBLISH_FRESH until a reader takes it. The writer swaps its finished
+   frame in with one atomic exchange; a reader owns frame GAME_PUBLISH_READER_START at first and, whenever
+   FRESH is set, swaps its own frame for the newest one the same way (Atomics.exchange in JS). */
+#ifndef GAME_PUBLISH_MAX_ENEMIES
+#define GAME_PUBLISH_MAX_ENEMIES 8192 /* enemies per frame; the rest of a crowded screen is not drawn */
+#endif
+#ifndef GAME_PUBLISH_MAX_PARTICLES
+#define GAME_PUBLISH_MAX_PARTICLES 16384 /* particles per frame, newest first */
+#endif
+#define GAME_PUBLISH_MARGIN 100.f
+#define GAME_PUBLISH_FRESH 4
+#define GAME_PUBLISH_READER_START 2
+#define GAME_PUB_SEQ 0             /* game_publish_frame calls; the frame's last word repeats it */
+#define GAME_PUB_PLAYER_X 1        /* f32 */
+#define GAME_PUB_PLAYER_Y 2
+#define GAME_PUB_PLAYER_ANGLE 3
+#define GAME_PUB_CANVAS_WIDTH 4    /* f32, as passed to the last game_update */
+#define GAME_PUB_CANVAS_HEIGHT 5
+#define GAME_PUB_ENEMY_COUNT 6
+#define GAME_PUB_ENEMY_OFFSET 7    /* word offsets of the sections; enemy: f32 x, y, width, height, rotation, u32 color */
+#define GAME_PUB_BULLET_COUNT 8
+#define GAME_PUB_BULLET_OFFSET 9   /* bullet: f32 x, y */
+#define GAME_PUB_PARTICLE_COUNT 10
+#define GAME_PUB_PARTICLE_OFFSET 11 /* particle: f32 x, y, life, size, u32 color */
+#define GAME_PUB_HEADER_WORDS 16
+#define GAME_PUB_ENEMY_WORDS 6
+#define GAME_PUB_BULLET_WORDS 2
+#define GAME_PUB_PARTICLE_WORDS 5
+#define GAME_PUBLISH_FRAME_WORDS (GAME_PUB_HEADER_WORDS + GAME_PUBLISH_MAX_ENEMIES * GAME_PUB_ENEMY_WORDS + \
+                                  MAX_BULLETS * GAME_PUB_BULLET_WORDS + GAME_PUBLISH_MAX_PARTICLES * GAME_PUB_PARTICLE_WORDS + 1)
+unsigned int game_publish_frame(void);                 /* returns the frame's seq */
+const unsigned int* game_get_publish_frames(void);     /* three frames back to back */
+int* game_get_publish_exchange(void);
+int game_get_publish_frame_words(void);                /* GAME_PUBLISH_FRAME_WORDS of this build */
+/* Render list: the same layout culled against any rectangle, for a renderer on the simulation's thread; one
+   call and one typed-array view per frame instead of a getter per value. The seq words hold the update count;
+   the list is overwritten by the next call. */
+const unsigned int* game_build_render_list(float min_x, float min_y, float max_x, float max_y);
+
+/* Worlds: independent simulations in one process, e.g. headless matches for bots or load tests. Everything
+   above acts on the default world; input recording serves it only. */
+#ifndef GAME_WORLD_MAX_PARTICLES
+#define GAME_WORLD_MAX_PARTICLES 1024 /* particle ring of a created world; particles are cosmetic */
+#endif
+typedef struct GameWorld GameWorld;
+typedef struct {
+  float dt;
+  unsigned int keys_mask;
+  float mouse_x, mouse_y;
+  int shoot;
+  float canvas_width, canvas_height;
+} GameInput; /* the arguments of one game_update */
+GameWorld* game_world_default(void);
+GameWorld* game_world_create(int max_enemies); /* <= 0 or above MAX_ENEMIES: MAX_ENEMIES; 0 when out of memory */
+void game_world_destroy(GameWorld* w);         /* no-op for the default world */
+void game_world_update(GameWorld* w, float dt, unsigned int keys_mask, float mouse_x, float mouse_y, int shoot,
+                       float canvas_width, float canvas_height);
+void game_worlds_update(GameWorld* const* worlds, int n, const GameInput* inputs); /* inputs[i] drives worlds[i] */
+void game_world_get_player(const GameWorld* w, float* x, float* y, float* angle);
+unsigned long long game_world_state_hash(const GameWorld* w);
+
+/* Replication: per-client snapshots of a world, quantized and bit-packed as deltas against the newest snapshot
+   the client acknowledged (netcode.h), so a server sends only what changed. A client receives the entities
+   overlapping its view rectangle (default: the world's canvas) grown by GAME_NET_VIEW_MARGIN; particles are
+   cosmetic and not sent. A replica decodes the packets on the client and reads the newest snapshot back.
+   Entity ids are bullet indices and enemy ids of the server world; an enemy keeps its id while it lives. */
+#ifndef GAME_NET_MAX_CLIENTS
+#define GAME_NET_MAX_CLIENTS 16
+#endif
+#ifndef GAME_NET_MAX_ENEMIES
+#define GAME_NET_MAX_ENEMIES 4096 /* per snapshot; further enemies in view wait for a later one */
+#endif
+#define GAME_NET_VIEW_MARGIN 64.f
+#define GAME_NET_PLAYER 0  /* entity classes, each with its fields */
+#define GAME_NET_BULLETS 1
+#define GAME_NET_ENEMIES 2
+#define GAME_NET_CLASSES 3
+#define GAME_NET_X 0       /* all classes */
+#define GAME_NET_Y 1
+#define GAME_NET_ANGLE 2   /* player */
+#define GAME_NET_SIZE 2    /* enemies: width = height */
+#define GAME_NET_ROTATION 3
+#define GAME_NET_COLOR 4   /* 0xRRGGBB, exact as a float */
+typedef struct GameNetReplica GameNetReplica;
+int game_net_client_open(const GameWorld* w); /* w = 0: the default world; returns the client, or -1 */
+void game_net_client_close(int client);
+void game_net_client_view(int client, float min_x, float min_y, float max_x, float max_y);
+int game_net_encode(int client, unsigned char* out, int capacity); /* the world now; bytes, or -1 if out is too small */
+void game_net_ack(int client, unsigned int seq);                    /* seq from game_net_replica_apply */
+GameNetReplica* game_net_replica_create(void);
+void game_net_replica_destroy(GameNetReplica* r);
+unsigned int game_net_replica_apply(GameNetReplica* r, const unsigned char* data, int size); /* seq to ack, 0 = undecodable */
+unsigned int game_net_replica_tick(const GameNetReplica* r); /* world updates at the newest snapshot */
+int game_net_replica_count(const GameNetReplica* r, int cls);
+unsigned int game_net_replica_id(const GameNetReplica* r, int cls, int i);
+float game_net_replica_field(const GameNetReplica* r, int cls, int i, int field);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,156 @@
+/* Headless benchmark of the whole core: times every game_init and game_update call and prints one JSON
+   line of percentiles per run, so results can be appended to a file and compared across commits.
+   Build natively from Test2/wasm with `make bench` (`make sweep` runs the standard configurations), or
+     cc -O2 -I. -I../../shared native/bench.c game.c -o bench -lm
+   Usage: bench [--ticks N] [--init-runs K] [--replay LOG] [--shoot 0|1] [--tag STR]
+     --ticks N      game_update calls to time (default 1000); with --replay, at most N records
+     --init-runs K  game_init calls to time (default 3)
+     --replay LOG   drive updates from an input log (game_record_start) instead of the scripted input
+     --shoot 0|1    hold fire during scripted input (default 1); bullets are capped by the fire rate and
+                    MAX_BULLETS, so this is the bullet-load switch
+     --threads T    workers for the parallel phases (GAME_THREADS builds: make scaling)
+     --tag STR      copied into the output, e.g. the commit id
+     --trace FILE   Chrome trace of every timed phase (GAME_STATS builds: make trace)
+   GAME_STATS builds also report the mean GameStats of the timed updates under "stats". */
+#include "game.h"
+#include "native/input_log.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_CANVAS_WIDTH 800.f
+#define BENCH_CANVAS_HEIGHT 600.f
+
+#if GAME_STATS
+static const char* const stats_names[GAME_STATS_FIELDS] = {
+  "updates", "update_ns", "player_ns", "bullet_ns", "enemy_ns", "particle_ns", "pair_tests", "hits", "bullet_spawns",
+  "enemy_spawns", "enemy_arrivals", "particle_spawns", "bullet_removals", "enemy_removals", "particle_removals",
+  "bullets", "enemies", "particles"
+};
+#endif
+
+static long long now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+static int cmp_ns(const void* a, const void* b) {
+  long long x = *(const long long*)a, y = *(const long long*)b;
+  return (x > y) - (x < y);
+}
+
+/* Sorts samples in place and prints {"p50":..,"p90":..,"p99":..,"max":..,"mean":..} (nearest rank) */
+static void print_percentiles(long long* samples, int n) {
+  if (n <= 0) {
+    printf("null");
+    return;
+  }
+  qsort(samples, (size_t)n, sizeof(long long), cmp_ns);
+  long long sum = 0;
+  for (int i = 0; i < n; i++) sum += samples[i];
+  printf("{\"p50\":%lld,\"p90\":%lld,\"p99\":%lld,\"max\":%lld,\"mean\":%lld}", samples[(n - 1) * 50 / 100],
+         samples[(n - 1) * 90 / 100], samples[(n - 1) * 99 / 100], samples[n - 1], sum / n);
+}
+
+int main(int argc, char** argv) {
+  int ticks = 1000, init_runs = 3, shoot = 1, threads = 1;
+  const char* log_path = 0;
+  const char* tag = "";
+  const char* trace_path = 0;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--ticks") && i + 1 < argc) ticks = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--init-runs") && i + 1 < argc) init_runs = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--replay") && i + 1 < argc) log_path = argv[++i];
+    else if (!strcmp(argv[i], "--shoot") && i + 1 < argc) shoot = atoi(argv[++i]) != 0;
+    else if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--tag") && i + 1 < argc) tag = argv[++i];
+    else if (!strcmp(argv[i], "--trace") && i + 1 < argc) trace_path = argv[++i];
+    else {
+      fprintf(stderr, "usage: %s [--ticks N] [--init-runs K] [--replay LOG] [--shoot 0|1] [--threads T] [--tag STR]"
+              " [--trace FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (init_runs < 1) init_runs = 1;
+  if (ticks < 0) ticks = 0;
+  threads = game_set_thread_count(threads);
+#if GAME_STATS
+  if (trace_path && !game_trace_begin(trace_path)) {
+    fprintf(stderr, "%s: cannot write trace\n", trace_path);
+    return 2;
+  }
+  double stats_sum[GAME_STATS_FIELDS] = { 0 };
+#else
+  if (trace_path) {
+    fprintf(stderr, "--trace needs a GAME_STATS=1 build\n");
+    return 2;
+  }
+#endif
+
+  InputLog log;
+  if (log_path && !input_log_open(&log, log_path)) return 2;
+
+  long long* init_ns = (long long*)malloc(sizeof(long long) * (size_t)init_runs);
+  long long* update_ns = (long long*)malloc(sizeof(long long) * (size_t)(ticks > 0 ? ticks : 1));
+  if (!init_ns || !update_ns) return 2;
+  for (int i = 0; i < init_runs; i++) {
+    long long t0 = now_ns();
+    game_init();
+    init_ns[i] = now_ns() - t0;
+  }
+
+  /* Scripted input: wander around the canvas while the mouse circles the player, with a jittered dt */
+  int updates = 0;
+  long long live_bullets = 0, live_particles = 0;
+  for (int k = 0; k < ticks; k++) {
+    InputFrame in;
+    if (log_path) {
+      if (!input_log_next(&log, &in)) break;
+    } else {
+      in.keys = ((k / 120) % 2 ? 1 : 2) | ((k / 75) % 2 ? 4 : 8); /* W/S, A/D */
+      in.mouse_x = game_get_player_x() + 200.f * cosf((float)k * 0.05f);
+      in.mouse_y = game_get_player_y() + 200.f * sinf((float)k * 0.05f);
+      in.shoot = shoot;
+      in.canvas_width = BENCH_CANVAS_WIDTH;
+      in.canvas_height = BENCH_CANVAS_HEIGHT;
+      in.dt = 1.f / 60.f + (float)(k % 7) * 0.002f;
+    }
+    long long t0 = now_ns();
+    game_update(in.dt, in.keys, in.mouse_x, in.mouse_y, in.shoot, in.canvas_width, in.canvas_height);
+    update_ns[updates++] = now_ns() - t0;
+    live_bullets += game_get_bullet_count();
+    live_particles += game_get_particle_count();
+#if GAME_STATS
+    const unsigned int* fields = (const unsigned int*)game_get_stats();
+    for (int f = 0; f < GAME_STATS_FIELDS; f++) stats_sum[f] += fields[f];
+#endif
+  }
+#if GAME_STATS
+  game_trace_end();
+#endif
+
+  printf("{\"game\":\"test2\",\"tag\":\"%s\",\"input\":\"%s\",\"max_enemies\":%d,\"max_bullets\":%d,"
+         "\"max_particles\":%d,\"explosion_particles\":%d,\"shoot\":%d,\"enemies\":%d,\"avg_live_bullets\":%lld,"
+         "\"avg_live_particles\":%lld,\"threads\":%d,\"ticks\":%d,\"init_ns\":",
+         tag, log_path ? "replay" : "scripted", MAX_ENEMIES, MAX_BULLETS, MAX_PARTICLES, GAME_EXPLOSION_PARTICLES,
+         log_path ? -1 : shoot,
+         game_get_enemy_count(), updates ? live_bullets / updates : 0, updates ? live_particles / updates : 0, threads, updates);
+  print_percentiles(init_ns, init_runs);
+  printf(",\"update_ns\":");
+  print_percentiles(update_ns, updates);
+#if GAME_STATS
+  printf(",\"stats\":{");
+  for (int f = 1; f < GAME_STATS_FIELDS; f++)
+    printf("%s\"%s\":%.1f", f > 1 ? "," : "", stats_names[f], updates ? stats_sum[f] / updates : 0.0);
+  printf("}");
+#endif
+  printf(",\"hash\":\"%016llx\"}\n", game_state_hash());
+
+  if (log_path) input_log_close(&log);
+  free(init_ns);
+  free(update_ns);
+  return 0;
+}
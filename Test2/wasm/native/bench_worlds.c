@@ -0,0 +1,124 @@
+/* Headless many-worlds benchmark: steps W independent worlds (the default world plus W - 1 from
+   game_world_create) for N ticks and prints one JSON line with the batch step percentiles and worlds ticked
+   per second, the metric for hosting many matches per core.
+   Build natively from Test2/wasm with `make bench_worlds` (`make worlds` runs the standard counts), or
+     cc -O2 -I. -I../../shared native/bench_worlds.c game.c -o bench_worlds -lm
+   Usage: bench_worlds [--worlds W] [--enemies E] [--ticks N] [--batch 0|1] [--tag STR]
+     --worlds W   worlds to step (default 64)
+     --enemies E  enemy capacity of the created worlds (default 1000; the default world has MAX_ENEMIES)
+     --ticks N    steps of every world (default 600)
+     --batch 0|1  one game_worlds_update per step (1, the default) or one game_world_update per world
+     --tag STR    copied into the output, e.g. the commit id
+   Every world runs bench's scripted input (fire held) at its own phase; world 0 (the default world) runs it
+   unshifted, so "default_hash" matches `bench --ticks N`, and "hash" must not depend on --batch. */
+#include "game.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define WORLD_PHASE 37 /* input offset between consecutive worlds, in updates */
+
+static long long now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+static int cmp_ns(const void* a, const void* b) {
+  long long x = *(const long long*)a, y = *(const long long*)b;
+  return (x > y) - (x < y);
+}
+
+/* Sorts samples in place and prints {"p50":..,"p90":..,"p99":..,"max":..,"mean":..} (nearest rank) */
+static void print_percentiles(long long* samples, int n) {
+  if (n <= 0) {
+    printf("null");
+    return;
+  }
+  qsort(samples, (size_t)n, sizeof(long long), cmp_ns);
+  long long sum = 0;
+  for (int i = 0; i < n; i++) sum += samples[i];
+  printf("{\"p50\":%lld,\"p90\":%lld,\"p99\":%lld,\"max\":%lld,\"mean\":%lld}", samples[(n - 1) * 50 / 100],
+         samples[(n - 1) * 90 / 100], samples[(n - 1) * 99 / 100], samples[n - 1], sum / n);
+}
+
+/* Same input as bench.c's scripted input, for a world whose player is at (px, py) */
+static void scripted_input(int k, float px, float py, GameInput* in) {
+  in->keys_mask = ((k / 120) % 2 ? 1 : 2) | ((k / 75) % 2 ? 4 : 8); /* W/S, A/D */
+  in->mouse_x = px + 200.f * cosf((float)k * 0.05f);
+  in->mouse_y = py + 200.f * sinf((float)k * 0.05f);
+  in->shoot = 1;
+  in->canvas_width = 800.f;
+  in->canvas_height = 600.f;
+  in->dt = 1.f / 60.f + (float)(k % 7) * 0.002f;
+}
+
+int main(int argc, char** argv) {
+  int count = 64, enemies = 1000, ticks = 600, batch = 1;
+  const char* tag = "";
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--worlds") && i + 1 < argc) count = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--enemies") && i + 1 < argc) enemies = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--ticks") && i + 1 < argc) ticks = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--batch") && i + 1 < argc) batch = atoi(argv[++i]) != 0;
+    else if (!strcmp(argv[i], "--tag") && i + 1 < argc) tag = argv[++i];
+    else {
+      fprintf(stderr, "usage: %s [--worlds W] [--enemies E] [--ticks N] [--batch 0|1] [--tag STR]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (count < 1) count = 1;
+  if (ticks < 0) ticks = 0;
+
+  GameWorld** worlds = (GameWorld**)malloc(sizeof(GameWorld*) * (size_t)count);
+  GameInput* inputs = (GameInput*)malloc(sizeof(GameInput) * (size_t)count);
+  long long* step_ns = (long long*)malloc(sizeof(long long) * (size_t)(ticks > 0 ? ticks : 1));
+  if (!worlds || !inputs || !step_ns) return 2;
+  game_init();
+  worlds[0] = game_world_default();
+  long long t0 = now_ns();
+  for (int i = 1; i < count; i++) {
+    worlds[i] = game_world_create(enemies);
+    if (!worlds[i]) {
+      fprintf(stderr, "out of memory after %d worlds\n", i);
+      return 2;
+    }
+  }
+  long long create_ns = count > 1 ? (now_ns() - t0) / (count - 1) : 0;
+
+  long long total = 0;
+  for (int k = 0; k < ticks; k++) {
+    for (int i = 0; i < count; i++) {
+      float px, py, angle;
+      game_world_get_player(worlds[i], &px, &py, &angle);
+      scripted_input(k + i * WORLD_PHASE, px, py, &inputs[i]);
+    }
+    t0 = now_ns();
+    if (batch) {
+      game_worlds_update(worlds, count, inputs);
+    } else {
+      for (int i = 0; i < count; i++)
+        game_world_update(worlds[i], inputs[i].dt, inputs[i].keys_mask, inputs[i].mouse_x, inputs[i].mouse_y,
+                          inputs[i].shoot, inputs[i].canvas_width, inputs[i].canvas_height);
+    }
+    step_ns[k] = now_ns() - t0;
+    total += step_ns[k];
+  }
+
+  unsigned long long hash = 0;
+  for (int i = 0; i < count; i++) hash = (hash ^ game_world_state_hash(worlds[i])) * 0x9E3779B97F4A7C15ull;
+  printf("{\"game\":\"test2\",\"tag\":\"%s\",\"worlds\":%d,\"enemies\":%d,\"max_enemies\":%d,\"ticks\":%d,\"batch\":%d,"
+         "\"create_ns\":%lld,\"worlds_per_sec\":%.0f,\"step_ns\":",
+         tag, count, enemies, MAX_ENEMIES, ticks, batch, create_ns,
+         total > 0 ? (double)count * ticks * 1e9 / (double)total : 0.0);
+  print_percentiles(step_ns, ticks);
+  printf(",\"default_hash\":\"%016llx\",\"hash\":\"%016llx\"}\n", game_state_hash(), hash);
+
+  for (int i = 1; i < count; i++) game_world_destroy(worlds[i]);
+  free(worlds);
+  free(inputs);
+  free(step_ns);
+  return 0;
+}
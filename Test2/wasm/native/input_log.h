@@ -0,0 +1,89 @@
+#ifndef INPUT_LOG_H
+#define INPUT_LOG_H
+
+/* Reader for input logs written by game_record_start (format in game.h), shared by the native tools. */
+#include "game.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  unsigned char* data;
+  long size;
+  long pos;
+  float mouse_x, mouse_y;             /* carried over while records leave them out */
+  float canvas_width, canvas_height;
+} InputLog;
+
+typedef struct {
+  float dt;
+  unsigned int keys;
+  float mouse_x, mouse_y;
+  int shoot;
+  float canvas_width, canvas_height;
+} InputFrame;
+
+/* Loads the whole log; returns 0 (with a message on stderr) if it is missing or not a Test2 log */
+static int input_log_open(InputLog* log, const char* path) {
+  unsigned int header[2];
+  FILE* f = fopen(path, "rb");
+  memset(log, 0, sizeof(*log));
+  log->canvas_width = 800.f;
+  log->canvas_height = 600.f;
+  if (!f) {
+    fprintf(stderr, "%s: cannot read log\n", path);
+    return 0;
+  }
+  fseek(f, 0, SEEK_END);
+  log->size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  log->data = (unsigned char*)malloc(log->size > 0 ? (size_t)log->size : 1);
+  if (!log->data || fread(log->data, 1, (size_t)log->size, f) != (size_t)log->size ||
+      log->size < GAME_RECORD_HEADER_BYTES) {
+    fclose(f);
+    fprintf(stderr, "%s: cannot read log\n", path);
+    return 0;
+  }
+  fclose(f);
+  memcpy(header, log->data, GAME_RECORD_HEADER_BYTES);
+  if (header[0] != GAME_RECORD_MAGIC || header[1] != GAME_RECORD_VERSION) {
+    fprintf(stderr, "%s: not a version %d Test2 input log\n", path, GAME_RECORD_VERSION);
+    return 0;
+  }
+  log->pos = GAME_RECORD_HEADER_BYTES;
+  return 1;
+}
+
+/* Next record, or 0 at the end (a truncated last record is dropped) */
+static int input_log_next(InputLog* log, InputFrame* frame) {
+  if (log->pos + 5 > log->size) return 0;
+  unsigned char flags = log->data[log->pos];
+  long pos = log->pos + 5;
+  long next = pos + ((flags & GAME_RECORD_MOUSE) ? 8 : 0) + ((flags & GAME_RECORD_CANVAS) ? 8 : 0);
+  if (next > log->size) return 0;
+  memcpy(&frame->dt, log->data + log->pos + 1, 4);
+  if (flags & GAME_RECORD_MOUSE) {
+    memcpy(&log->mouse_x, log->data + pos, 4);
+    memcpy(&log->mouse_y, log->data + pos + 4, 4);
+    pos += 8;
+  }
+  if (flags & GAME_RECORD_CANVAS) {
+    memcpy(&log->canvas_width, log->data + pos, 4);
+    memcpy(&log->canvas_height, log->data + pos + 4, 4);
+  }
+  frame->keys = flags & GAME_RECORD_KEYS;
+  frame->shoot = (flags & GAME_RECORD_SHOOT) != 0;
+  frame->mouse_x = log->mouse_x;
+  frame->mouse_y = log->mouse_y;
+  frame->canvas_width = log->canvas_width;
+  frame->canvas_height = log->canvas_height;
+  log->pos = next;
+  return 1;
+}
+
+static void input_log_close(InputLog* log) {
+  free(log->data);
+  log->data = 0;
+}
+
+#endif /* INPUT_LOG_H */
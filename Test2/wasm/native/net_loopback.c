@@ -0,0 +1,320 @@
+/* Loopback replication benchmark: runs the default world on bench's scripted input and, every update, encodes a
+   snapshot for C clients with different views, drops packets and acks at the given rate, decodes the rest into
+   one replica per client and checks it against the world. Prints one JSON line with bytes per packet, update,
+   encode and decode percentiles, and the size of the same snapshot without a baseline ("full_bytes").
+   Build natively from Test2/wasm with `make net_loopback` (`make net` runs it), or
+     cc -O2 -I. -I../../shared native/net_loopback.c game.c -o net_loopback -lm
+   Usage: net_loopback [--ticks N] [--clients C] [--loss PCT] [--latency L] [--reorder PCT] [--pan PX] [--tag STR]
+     --ticks N    updates (default 600)
+     --clients C  clients, client c viewing the canvas shifted right by c * VIEW_STEP (default 4)
+     --loss PCT   share of packets and of acks lost (default 5)
+     --latency L  updates before an ack reaches the server (default 4)
+     --reorder PCT  share of the packets that get through arriving 1..MAX_DELAY updates late instead, each
+                    first as a cut-short copy (default 0)
+     --pan PX     views move right PX per update, jumping back every PAN_RANGE (default 0)
+     --tag STR    copied into the output, e.g. the commit id
+   "mismatches" counts replicated values off by more than their quantization, replicas holding the wrong
+   bullets, late packets that move a replica back to an older tick and cut-short copies that
+   decode; it must be 0, and so must "decode_failures" (packets arriving in order that do not decode). "stale"
+   counts late packets the replica rejected: NET_HISTORY or more behind, or beaten to their slot.
+   Before the run a fixed case applies one client's packets out of order with a cut-short copy among them
+   ("out_of_order_failures", see out_of_order_case). Exits 1 unless all three counts are 0. */
+#include "game.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define PACKET_CAPACITY (1 << 20)
+#define VIEW_STEP 400.f
+#define PAN_RANGE 4096.f
+#define MAX_LATENCY 64
+#define MAX_DELAY 24 /* past NET_HISTORY, so some late packets are too old to keep */
+#define ORDER_PACKETS 20 /* more than NET_HISTORY, so late packets share slots with newer ones */
+
+static long long now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+static int cmp_ns(const void* a, const void* b) {
+  long long x = *(const long long*)a, y = *(const long long*)b;
+  return (x > y) - (x < y);
+}
+
+/* Sorts samples in place and prints {"p50":..,"p90":..,"p99":..,"max":..,"mean":..} (nearest rank) */
+static void print_percentiles(long long* samples, int n) {
+  if (n <= 0) {
+    printf("null");
+    return;
+  }
+  qsort(samples, (size_t)n, sizeof(long long), cmp_ns);
+  long long sum = 0;
+  for (int i = 0; i < n; i++) sum += samples[i];
+  printf("{\"p50\":%lld,\"p90\":%lld,\"p99\":%lld,\"max\":%lld,\"mean\":%lld}", samples[(n - 1) * 50 / 100],
+         samples[(n - 1) * 90 / 100], samples[(n - 1) * 99 / 100], samples[n - 1], sum / n);
+}
+
+static unsigned int loss_rng = 0x2545F491u;
+static int lost(int percent) {
+  loss_rng = loss_rng * 1664525u + 1013904223u;
+  return (int)((loss_rng >> 8) % 100u) < percent;
+}
+
+static int off(float got, float want, float tolerance) { return !(fabsf(got - want) <= tolerance); }
+
+static int off_angle(float got, float want, int bits) {
+  float d = fmodf(got - want, 6.28318530718f);
+  if (d > 3.14159265359f) d -= 6.28318530718f;
+  if (d < -3.14159265359f) d += 6.28318530718f;
+  return !(fabsf(d) <= 3.14159265359f / (float)(1 << bits) + 1e-3f);
+}
+
+static int enemy_index[MAX_ENEMIES]; /* enemy id -> index, rebuilt by verify */
+
+/* Checks the replica's newest snapshot against the world it was just taken from */
+static int verify(const GameNetReplica* r, const float* view) {
+  int bad = 0;
+  float pos_tol = 0.5f / 4.f + 0.01f; /* half a quarter pixel plus float rounding of the large x offsets */
+  float px, py, angle;
+  game_world_get_player(game_world_default(), &px, &py, &angle);
+  bad += game_net_replica_count(r, GAME_NET_PLAYER) != 1;
+  bad += off(game_net_replica_field(r, GAME_NET_PLAYER, 0, GAME_NET_X), px, pos_tol);
+  bad += off(game_net_replica_field(r, GAME_NET_PLAYER, 0, GAME_NET_Y), py, pos_tol);
+  bad += off_angle(game_net_replica_field(r, GAME_NET_PLAYER, 0, GAME_NET_ANGLE), angle, 12);
+
+  float x0 = view[0] - GAME_NET_VIEW_MARGIN, y0 = view[1] - GAME_NET_VIEW_MARGIN;
+  float x1 = view[2] + GAME_NET_VIEW_MARGIN, y1 = view[3] + GAME_NET_VIEW_MARGIN;
+  int n = game_net_replica_count(r, GAME_NET_BULLETS), expected = 0;
+  for (int i = 0; i < game_get_bullet_count(); i++) {
+    float x = game_get_bullet_x(i), y = game_get_bullet_y(i);
+    expected += x >= x0 && x <= x1 && y >= y0 && y <= y1;
+  }
+  bad += n != expected;
+  for (int i = 0; i < n; i++) {
+    int id = (int)game_net_replica_id(r, GAME_NET_BULLETS, i);
+    bad += off(game_net_replica_field(r, GAME_NET_BULLETS, i, GAME_NET_X), game_get_bullet_x(id), pos_tol);
+    bad += off(game_net_replica_field(r, GAME_NET_BULLETS, i, GAME_NET_Y), game_get_bullet_y(id), pos_tol);
+  }
+
+  n = game_net_replica_count(r, GAME_NET_ENEMIES);
+  expected = 0;
+  for (int j = 0; j < game_get_enemy_count(); j++) {
+    float x, y, w, h, rot;
+    unsigned int color;
+    game_get_enemy(j, &x, &y, &w, &h, &rot, &color);
+    expected += x + w >= x0 && x <= x1 && y + h >= y0 && y <= y1;
+    enemy_index[game_get_enemy_id(j)] = j;
+  }
+  bad += n != (expected < GAME_NET_MAX_ENEMIES ? expected : GAME_NET_MAX_ENEMIES);
+  for (int i = 0; i < n; i++) {
+    int id = enemy_index[game_net_replica_id(r, GAME_NET_ENEMIES, i)];
+    bad += off(game_net_replica_field(r, GAME_NET_ENEMIES, i, GAME_NET_X), game_get_enemy_x(id), pos_tol);
+    bad += off(game_net_replica_field(r, GAME_NET_ENEMIES, i, GAME_NET_Y), game_get_enemy_y(id), pos_tol);
+    bad += off(game_net_replica_field(r, GAME_NET_ENEMIES, i, GAME_NET_SIZE), game_get_enemy_width(id), 0.126f);
+    bad += off_angle(game_net_replica_field(r, GAME_NET_ENEMIES, i, GAME_NET_ROTATION), game_get_enemy_rotation(id), 8);
+    bad += (unsigned int)game_net_replica_field(r, GAME_NET_ENEMIES, i, GAME_NET_COLOR) != game_get_enemy_color(id);
+  }
+  return bad;
+}
+
+/* Encodes ORDER_PACKETS updates for one client and applies some of them out of order, with cut-short copies
+   of the newest packet and of a packet not yet received, and a late packet whose history slot holds the
+   newest snapshot. The replica's tick must never go back, no cut-short copy may decode, and the replica
+   must end on the last packet, matching the world. Returns the failures. */
+static int out_of_order_case(unsigned char* packet) {
+  static const int order[] = { 0, 2, 1, 5, 3, -5, 4, 18, 2, -19, 17, 19, 3 }; /* -k: packet k cut to half */
+  unsigned char* sent[ORDER_PACKETS];
+  int sizes[ORDER_PACKETS], bad = 0;
+  float view[4] = { 0.f, 0.f, 800.f, 600.f };
+  game_init();
+  int id = game_net_client_open(0);
+  GameNetReplica* r = game_net_replica_create();
+  if (id < 0 || !r) return 1;
+  game_net_client_view(id, view[0], view[1], view[2], view[3]);
+  for (int k = 0; k < ORDER_PACKETS; k++) {
+    game_update(1.f / 60.f, 8, 600.f, 300.f, 1, 800.f, 600.f);
+    sizes[k] = game_net_encode(id, packet, PACKET_CAPACITY);
+    sent[k] = (unsigned char*)malloc(sizes[k] > 0 ? (size_t)sizes[k] : 1);
+    if (sizes[k] <= 0 || !sent[k]) return 1;
+    memcpy(sent[k], packet, (size_t)sizes[k]);
+  }
+  unsigned int tick = 0;
+  for (size_t o = 0; o < sizeof(order) / sizeof(order[0]); o++) {
+    int k = order[o] < 0 ? -order[o] : order[o];
+    unsigned int seq = game_net_replica_apply(r, sent[k], order[o] < 0 ? sizes[k] / 2 : sizes[k]);
+    bad += order[o] < 0 && seq != 0;
+    bad += game_net_replica_tick(r) < tick;
+    tick = game_net_replica_tick(r);
+  }
+  bad += verify(r, view);
+  for (int k = 0; k < ORDER_PACKETS; k++) free(sent[k]);
+  game_net_replica_destroy(r);
+  game_net_client_close(id);
+  return bad;
+}
+
+typedef struct {
+  int due;
+  int client;
+  unsigned int seq;
+} Ack;
+
+typedef struct {
+  int due;
+  int client;
+  int size;
+  unsigned char* data;
+} Late;
+
+int main(int argc, char** argv) {
+  int ticks = 600, clients = 4, loss = 5, latency = 4, reorder = 0;
+  float pan = 0.f;
+  const char* tag = "";
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--ticks") && i + 1 < argc) ticks = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--clients") && i + 1 < argc) clients = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--loss") && i + 1 < argc) loss = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--latency") && i + 1 < argc) latency = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--reorder") && i + 1 < argc) reorder = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--pan") && i + 1 < argc) pan = (float)atof(argv[++i]);
+    else if (!strcmp(argv[i], "--tag") && i + 1 < argc) tag = argv[++i];
+    else {
+      fprintf(stderr, "usage: %s [--ticks N] [--clients C] [--loss PCT] [--latency L] [--reorder PCT] [--pan PX] "
+              "[--tag STR]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (ticks < 0) ticks = 0;
+  if (clients < 1) clients = 1;
+  if (clients > GAME_NET_MAX_CLIENTS - 1) clients = GAME_NET_MAX_CLIENTS - 1; /* one more measures full snapshots */
+  if (latency < 0) latency = 0;
+  if (latency > MAX_LATENCY - 1) latency = MAX_LATENCY - 1;
+
+  unsigned char* packet = (unsigned char*)malloc(PACKET_CAPACITY);
+  if (!packet) return 2;
+  int order_failures = out_of_order_case(packet);
+
+  game_init();
+  int ids[GAME_NET_MAX_CLIENTS];
+  GameNetReplica* replicas[GAME_NET_MAX_CLIENTS];
+  float views[GAME_NET_MAX_CLIENTS][4];
+  for (int c = 0; c < clients; c++) {
+    ids[c] = game_net_client_open(0);
+    replicas[c] = game_net_replica_create();
+    if (ids[c] < 0 || !replicas[c]) return 2;
+    views[c][0] = (float)c * VIEW_STEP;
+    views[c][1] = 0.f;
+    views[c][2] = (float)c * VIEW_STEP + 800.f;
+    views[c][3] = 600.f;
+    game_net_client_view(ids[c], views[c][0], views[c][1], views[c][2], views[c][3]);
+  }
+  int full_client = game_net_client_open(0); /* never acks, so every snapshot is coded without a baseline */
+  game_net_client_view(full_client, views[0][0], views[0][1], views[0][2], views[0][3]);
+
+  int samples = ticks * clients;
+  long long* bytes = (long long*)malloc(sizeof(long long) * (size_t)(samples > 0 ? samples : 1));
+  long long* encode_ns = (long long*)malloc(sizeof(long long) * (size_t)(samples > 0 ? samples : 1));
+  long long* decode_ns = (long long*)malloc(sizeof(long long) * (size_t)(samples > 0 ? samples : 1));
+  long long* update_ns = (long long*)malloc(sizeof(long long) * (size_t)(ticks > 0 ? ticks : 1));
+  Ack* acks = (Ack*)malloc(sizeof(Ack) * (size_t)(MAX_LATENCY * clients));
+  Late* late = (Late*)malloc(sizeof(Late) * (size_t)(MAX_DELAY * clients));
+  if (!bytes || !encode_ns || !decode_ns || !update_ns || !acks || !late) return 2;
+  int encoded = 0, decoded = 0, failures = 0, mismatches = 0, pending = 0, held = 0, delivered_late = 0, stale = 0;
+  long long full_bytes = 0, entities = 0;
+
+  for (int k = 0; k < ticks; k++) {
+    /* bench's scripted input, fire held */
+    float px = game_get_player_x(), py = game_get_player_y();
+    unsigned int keys = ((k / 120) % 2 ? 1 : 2) | ((k / 75) % 2 ? 4 : 8);
+    float dt = 1.f / 60.f + (float)(k % 7) * 0.002f;
+    if (pan > 0.f) {
+      float shift = fmodf(pan * (float)k, PAN_RANGE);
+      for (int c = 0; c < clients; c++) {
+        views[c][0] = (float)c * VIEW_STEP + shift;
+        views[c][2] = (float)c * VIEW_STEP + shift + 800.f;
+        game_net_client_view(ids[c], views[c][0], views[c][1], views[c][2], views[c][3]);
+      }
+    }
+    long long update_start = now_ns();
+    game_update(dt, keys, px + 200.f * cosf((float)k * 0.05f), py + 200.f * sinf((float)k * 0.05f), 1, 800.f, 600.f);
+    update_ns[k] = now_ns() - update_start;
+
+    for (int a = 0; a < pending; a++) {
+      if (acks[a].due > k) continue;
+      game_net_ack(ids[acks[a].client], acks[a].seq);
+      acks[a--] = acks[--pending];
+    }
+    for (int l = 0; l < held; l++) {
+      if (late[l].due > k) continue;
+      GameNetReplica* r = replicas[late[l].client];
+      unsigned int tick = game_net_replica_tick(r);
+      mismatches += game_net_replica_apply(r, late[l].data, late[l].size / 2) != 0;
+      unsigned int seq = game_net_replica_apply(r, late[l].data, late[l].size);
+      mismatches += game_net_replica_tick(r) < tick;
+      delivered_late++;
+      stale += !seq;
+      if (seq && !lost(loss) && pending < MAX_LATENCY * clients) acks[pending++] = (Ack){ k + latency, late[l].client, seq };
+      free(late[l].data);
+      late[l--] = late[--held];
+    }
+    for (int c = 0; c < clients; c++) {
+      long long t0 = now_ns();
+      int n = game_net_encode(ids[c], packet, PACKET_CAPACITY);
+      encode_ns[encoded] = now_ns() - t0;
+      if (n < 0) return 2;
+      bytes[encoded++] = n;
+      if (lost(loss)) continue;
+      if (lost(reorder) && held < MAX_DELAY * clients) {
+        late[held] = (Late){ k + 1 + (int)(loss_rng % MAX_DELAY), c, n, (unsigned char*)malloc((size_t)n) };
+        if (!late[held].data) return 2;
+        memcpy(late[held++].data, packet, (size_t)n);
+        continue;
+      }
+      t0 = now_ns();
+      unsigned int seq = game_net_replica_apply(replicas[c], packet, n);
+      decode_ns[decoded++] = now_ns() - t0;
+      if (!seq) {
+        failures++;
+        continue;
+      }
+      mismatches += verify(replicas[c], views[c]);
+      for (int cls = 0; cls < GAME_NET_CLASSES; cls++) entities += game_net_replica_count(replicas[c], cls);
+      if (!lost(loss) && pending < MAX_LATENCY * clients) acks[pending++] = (Ack){ k + latency, c, seq };
+    }
+    full_bytes += game_net_encode(full_client, packet, PACKET_CAPACITY);
+  }
+
+  printf("{\"game\":\"test2\",\"tag\":\"%s\",\"clients\":%d,\"ticks\":%d,\"loss\":%d,\"latency\":%d,\"pan\":%g,"
+         "\"max_enemies\":%d,\"entities\":%lld,\"full_bytes\":%lld,\"bytes\":",
+         tag, clients, ticks, loss, latency, (double)pan, MAX_ENEMIES, decoded ? entities / decoded : 0,
+         ticks ? full_bytes / ticks : 0);
+  print_percentiles(bytes, encoded);
+  printf(",\"update_ns\":");
+  print_percentiles(update_ns, ticks);
+  printf(",\"encode_ns\":");
+  print_percentiles(encode_ns, encoded);
+  printf(",\"decode_ns\":");
+  print_percentiles(decode_ns, decoded);
+  printf(",\"reorder\":%d,\"late\":%d,\"stale\":%d", reorder, delivered_late, stale);
+  printf(",\"decode_failures\":%d,\"mismatches\":%d,\"out_of_order_failures\":%d,\"hash\":\"%016llx\"}\n",
+         failures, mismatches, order_failures, game_state_hash());
+
+  for (int c = 0; c < clients; c++) {
+    game_net_client_close(ids[c]);
+    game_net_replica_destroy(replicas[c]);
+  }
+  game_net_client_close(full_client);
+  free(bytes);
+  free(encode_ns);
+  free(decode_ns);
+  free(update_ns);
+  free(packet);
+  free(acks);
+  for (int l = 0; l < held; l++) free(late[l].data);
+  free(late);
+  return failures || mismatches || order_failures;
+}
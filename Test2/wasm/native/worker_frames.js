@@ -0,0 +1,112 @@
+// Headless check of the worker mode under Node worker_threads: starts js/sim_worker.js, feeds it bench's
+// scripted input at 60 Hz and reads the newest published frame at a render rate of its own, the way
+// js/game.js does. Prints one JSON line with the updates the worker ran, the frames the reader saw, and the
+// read cost. "torn" counts frames whose first and last words disagree and "regressions" frames older than
+// one already read; both must be 0.
+// Needs the default (shared-memory) WASM build: from Test2/wasm run ./build.sh, then
+//   node native/worker_frames.js [--seconds S] [--render-hz HZ] [--tag STR]
+const path = require('path');
+const { Worker } = require('worker_threads');
+const { GAME_PUB, createFrameReader } = require(path.join(__dirname, '../../js/frames.js'));
+
+const args = { seconds: 5, renderHz: 144, tag: '' };
+for (let i = 2; i < process.argv.length; i++) {
+  const a = process.argv[i];
+  if (a === '--seconds' && i + 1 < process.argv.length) args.seconds = Number(process.argv[++i]);
+  else if (a === '--render-hz' && i + 1 < process.argv.length) args.renderHz = Number(process.argv[++i]);
+  else if (a === '--tag' && i + 1 < process.argv.length) args.tag = process.argv[++i];
+  else {
+    console.error('usage: node worker_frames.js [--seconds S] [--render-hz HZ] [--tag STR]');
+    process.exit(2);
+  }
+}
+
+function percentiles(samples) {
+  if (!samples.length) return null;
+  samples.sort((a, b) => a - b);
+  const at = (p) => samples[Math.floor((samples.length - 1) * p / 100)];
+  const mean = samples.reduce((s, v) => s + v, 0) / samples.length;
+  return { p50: at(50), p90: at(90), p99: at(99), max: samples[samples.length - 1], mean: Math.round(mean) };
+}
+
+const worker = new Worker(path.join(__dirname, '../../js/sim_worker.js'));
+let reader = null;
+let frameWords = 0;
+let k = 0;
+let inputTimer = null;
+let readTimer = null;
+let lastSeq = 0;
+let frames = 0;
+let repeats = 0;
+let torn = 0;
+let regressions = 0;
+let entities = 0;
+const readNs = [];
+
+// bench's scripted input, fire held; the player angle follows a circling mouse
+function sendInput() {
+  const keys = (Math.floor(k / 120) % 2 ? 1 : 2) | (Math.floor(k / 75) % 2 ? 4 : 8);
+  worker.postMessage({
+    type: 'input', keys, mouseX: 400 + 200 * Math.cos(k * 0.05), mouseY: 300 + 200 * Math.sin(k * 0.05), shoot: 1,
+    width: 800, height: 600
+  });
+  k++;
+}
+
+// What render() does with a frame, minus the drawing: walk every section
+function readFrame() {
+  const t0 = process.hrtime.bigint();
+  const frame = reader.latest();
+  if (!frame) return;
+  const { f32, u32, base } = frame;
+  const seq = u32[base + GAME_PUB.SEQ];
+  let sum = f32[base + GAME_PUB.PLAYER_X] + f32[base + GAME_PUB.PLAYER_Y];
+  const sections = [
+    [GAME_PUB.ENEMY_OFFSET, GAME_PUB.ENEMY_COUNT, GAME_PUB.ENEMY_WORDS],
+    [GAME_PUB.BULLET_OFFSET, GAME_PUB.BULLET_COUNT, GAME_PUB.BULLET_WORDS],
+    [GAME_PUB.PARTICLE_OFFSET, GAME_PUB.PARTICLE_COUNT, GAME_PUB.PARTICLE_WORDS]
+  ];
+  for (const [offset, count, words] of sections) {
+    let o = base + u32[base + offset];
+    for (let n = u32[base + count]; n > 0; n--, o += words) sum += f32[o] + f32[o + 1];
+    entities += u32[base + count];
+  }
+  readNs.push(Number(process.hrtime.bigint() - t0));
+  if (!Number.isFinite(sum) || u32[base + frameWords - 1] !== seq) torn++;
+  if (seq < lastSeq) regressions++;
+  else if (seq === lastSeq) repeats++;
+  else frames++;
+  lastSeq = Math.max(lastSeq, seq);
+}
+
+worker.on('message', (msg) => {
+  if (msg.type === 'ready') {
+    reader = createFrameReader(msg);
+    frameWords = msg.frameWords;
+    sendInput();
+    inputTimer = setInterval(sendInput, 1000 / 60);
+    readTimer = setInterval(readFrame, 1000 / args.renderHz);
+    setTimeout(() => worker.postMessage({ type: 'stop' }), args.seconds * 1000);
+  } else if (msg.type === 'stopped') {
+    clearInterval(inputTimer);
+    clearInterval(readTimer);
+    const reads = frames + repeats + regressions;
+    console.log(JSON.stringify({
+      game: 'test2', mode: 'worker', tag: args.tag, seconds: args.seconds, render_hz: args.renderHz,
+      updates: msg.updates, update_ms_mean: msg.updates ? +(msg.updateMs / msg.updates).toFixed(3) : 0,
+      frames_read: frames, repeats, entities: reads ? Math.round(entities / reads) : 0, read_ns: percentiles(readNs),
+      torn, regressions
+    }));
+    worker.terminate();
+    process.exitCode = torn || regressions || !frames ? 1 : 0;
+  } else {
+    console.error('worker:', msg.type, msg.message || 'build without shared memory (rebuild with ./build.sh)');
+    worker.terminate();
+    process.exitCode = 2;
+  }
+});
+worker.on('error', (err) => {
+  console.error('worker failed:', err);
+  process.exitCode = 2;
+});
+worker.postMessage({ type: 'start', threads: 1 });
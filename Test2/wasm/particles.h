@@ -0,0 +1,124 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+/* Particle ring: structure-of-arrays storage in spawn order. Every particle starts with the same lifetime and
+   loses the same dt per update, so the oldest always expire first: expiry only advances the tail, and emitting
+   into a full ring overwrites the oldest. Live particles are logical indices [0, count) from the tail; the
+   slot of logical i is tail + i, wrapped at capacity.
+   particles_integrate steps a run of slots PS_LANES at a time with no per-particle branches. The vector path
+   is picked at build time: WASM SIMD128 (emcc -msimd128), AVX (8 lanes), SSE2, else scalar; -DPS_NO_SIMD
+   forces the scalar path. Lane math matches the scalar loop operation for operation, so results are
+   bit-identical either way. */
+
+#if defined(PS_NO_SIMD)
+#define PS_LANES 1
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define PS_LANES 4
+typedef v128_t ps_vf;
+#define ps_load(p)      wasm_v128_load(p)
+#define ps_store(p, v)  wasm_v128_store(p, v)
+#define ps_set1(x)      wasm_f32x4_splat(x)
+#define ps_add(a, b)    wasm_f32x4_add(a, b)
+#define ps_sub(a, b)    wasm_f32x4_sub(a, b)
+#define ps_mul(a, b)    wasm_f32x4_mul(a, b)
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define PS_LANES 8
+typedef __m256 ps_vf;
+#define ps_load(p)      _mm256_loadu_ps(p)
+#define ps_store(p, v)  _mm256_storeu_ps(p, v)
+#define ps_set1(x)      _mm256_set1_ps(x)
+#define ps_add(a, b)    _mm256_add_ps(a, b)
+#define ps_sub(a, b)    _mm256_sub_ps(a, b)
+#define ps_mul(a, b)    _mm256_mul_ps(a, b)
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PS_LANES 4
+typedef __m128 ps_vf;
+#define ps_load(p)      _mm_loadu_ps(p)
+#define ps_store(p, v)  _mm_storeu_ps(p, v)
+#define ps_set1(x)      _mm_set1_ps(x)
+#define ps_add(a, b)    _mm_add_ps(a, b)
+#define ps_sub(a, b)    _mm_sub_ps(a, b)
+#define ps_mul(a, b)    _mm_mul_ps(a, b)
+#else
+#define PS_LANES 1
+#endif
+
+#define PS_DAMPING 0.98f /* velocity kept per update */
+
+typedef struct {
+  float* x;
+  float* y;
+  float* vx;
+  float* vy;
+  float* life;
+  float* size;
+  unsigned int* color; /* RGB packed as 0xRRGGBB */
+  int capacity;
+  int tail;  /* slot of the oldest particle */
+  int count;
+} ParticleRing;
+
+static inline int particle_slot(const ParticleRing* r, int i) {
+  int s = r->tail + i;
+  return s < r->capacity ? s : s - r->capacity;
+}
+
+/* Moves slots [begin, end): position by velocity * dt, then life down by dt and velocity damped */
+static void particles_integrate(ParticleRing* r, int begin, int end, float dt) {
+  float* restrict x = r->x;
+  float* restrict y = r->y;
+  float* restrict vx = r->vx;
+  float* restrict vy = r->vy;
+  float* restrict life = r->life;
+  int i = begin;
+#if PS_LANES > 1
+  ps_vf vdt = ps_set1(dt), damping = ps_set1(PS_DAMPING);
+  for (; i + PS_LANES <= end; i += PS_LANES) {
+    ps_vf u = ps_load(vx + i), v = ps_load(vy + i);
+    ps_store(x + i, ps_add(ps_load(x + i), ps_mul(u, vdt)));
+    ps_store(y + i, ps_add(ps_load(y + i), ps_mul(v, vdt)));
+    ps_store(life + i, ps_sub(ps_load(life + i), vdt));
+    ps_store(vx + i, ps_mul(u, damping));
+    ps_store(vy + i, ps_mul(v, damping));
+  }
+#endif
+  for (; i < end; i++) {
+    x[i] += vx[i] * dt;
+    y[i] += vy[i] * dt;
+    life[i] -= dt;
+    vx[i] *= PS_DAMPING;
+    vy[i] *= PS_DAMPING;
+  }
+}
+
+/* Moves logical particles [begin, end), one or two runs of slots */
+static void particles_integrate_logical(ParticleRing* r, int begin, int end, float dt) {
+  int s = particle_slot(r, begin), n = end - begin;
+  int run = r->capacity - s < n ? r->capacity - s : n;
+  particles_integrate(r, s, s + run, dt);
+  particles_integrate(r, 0, n - run, dt);
+}
+
+/* Slot for a new particle, the newest; a full ring gives up its oldest. Returns the slot and sets *evicted. */
+static int particles_emit(ParticleRing* r, int* evicted) {
+  *evicted = r->count == r->capacity;
+  if (*evicted) {
+    r->tail = particle_slot(r, 1);
+    r->count--;
+  }
+  return particle_slot(r, r->count++);
+}
+
+/* Drops the expired particles off the tail; returns how many */
+static int particles_expire(ParticleRing* r) {
+  int expired = 0;
+  while (expired < r->count && r->life[particle_slot(r, expired)] <= 0.f) expired++;
+  r->tail = particle_slot(r, expired);
+  r->count -= expired;
+  return expired;
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef HASH_H
+#define HASH_H
+
+/* State hashing for determinism checks: word-at-a-time multiply/xorshift mixing, not cryptographic, just
+   fast and well spread */
+#include <stddef.h>
+#include <string.h>
+
+static unsigned long long hash_mix(unsigned long long h, unsigned long long w) {
+  h = (h ^ w) * 0x9E3779B97F4A7C15ull;
+  return h ^ (h >> 32);
+}
+
+static unsigned long long hash_bytes(unsigned long long h, const void* data, size_t n) {
+  const unsigned char* p = (const unsigned char*)data;
+  unsigned long long w;
+  for (; n >= 8; p += 8, n -= 8) {
+    memcpy(&w, p, 8);
+    h = hash_mix(h, w);
+  }
+  if (n > 0) {
+    w = 0;
+    memcpy(&w, p, n);
+    h = hash_mix(h, w ^ ((unsigned long long)n << 56));
+  }
+  return h;
+}
+
+#endif /* HASH_H */
@@ -0,0 +1,175 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+/* Work-stealing scheduler for data-parallel loops. jobs_parallel_for cuts [0, count) into fixed chunks and
+   hands each worker a contiguous run of them; a worker takes chunks from the front of its own run and, when
+   that is empty, steals the back half of another worker's run. The calling thread is worker 0 and the call
+   returns once every chunk has run.
+   Chunk boundaries depend only on count and chunk size, never on the thread count, so a body that writes
+   per-element results (or per-chunk results merged in chunk order afterwards) is deterministic.
+   GAME_THREADS=1 uses pthreads (natively, or Emscripten pthreads on SharedArrayBuffer: build with -pthread
+   and -sPTHREAD_POOL_SIZE); otherwise the same chunks run inline on the caller. The caller never sleeps, so
+   it may be the browser's main thread: it drains chunks itself and then spins, only on chunks already
+   running elsewhere and on workers leaving the job, each bounded by one chunk body. */
+
+#ifndef GAME_THREADS
+#define GAME_THREADS 0
+#endif
+#define JOBS_MAX_THREADS 16
+
+/* Runs elements [begin, end) of one chunk; worker is in [0, threads running) */
+typedef void (*jobs_fn)(void* ctx, int begin, int end, int worker);
+
+#if GAME_THREADS
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+typedef struct {
+  _Atomic unsigned long long range; /* next chunk in the low 32 bits, end chunk in the high 32 bits */
+  char pad[64 - sizeof(unsigned long long)];
+} JobsQueue;
+
+static JobsQueue jobs_queues[JOBS_MAX_THREADS];
+static pthread_t jobs_workers[JOBS_MAX_THREADS];
+static int jobs_threads = 1;
+static pthread_mutex_t jobs_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t jobs_wake = PTHREAD_COND_INITIALIZER;
+static unsigned int jobs_generation; /* bumped per job; guarded by jobs_mutex like the fields below */
+static atomic_int jobs_joined;       /* workers inside the current job; joining also takes jobs_mutex */
+static int jobs_quit;
+static jobs_fn jobs_body;            /* 0 once the current job is closed to late joiners */
+static void* jobs_ctx;
+static int jobs_count, jobs_chunk;
+static atomic_int jobs_chunks_left;
+
+static unsigned long long jobs_pack(unsigned int next, unsigned int end) {
+  return ((unsigned long long)end << 32) | next;
+}
+
+static int jobs_pop(int worker, unsigned int* chunk) {
+  JobsQueue* q = &jobs_queues[worker];
+  unsigned long long r = atomic_load(&q->range);
+  for (;;) {
+    unsigned int next = (unsigned int)r, end = (unsigned int)(r >> 32);
+    if (next >= end) return 0;
+    if (atomic_compare_exchange_weak(&q->range, &r, jobs_pack(next + 1, end))) {
+      *chunk = next;
+      return 1;
+    }
+  }
+}
+
+/* Moves the back half of the first non-empty victim run into the thief's own (empty) queue */
+static int jobs_steal(int thief) {
+  for (int k = 1; k < jobs_threads; k++) {
+    JobsQueue* q = &jobs_queues[(thief + k) % jobs_threads];
+    unsigned long long r = atomic_load(&q->range);
+    for (;;) {
+      unsigned int next = (unsigned int)r, end = (unsigned int)(r >> 32);
+      if (next >= end) break;
+      unsigned int mid = end - (end - next + 1) / 2;
+      if (atomic_compare_exchange_weak(&q->range, &r, jobs_pack(next, mid))) {
+        atomic_store(&jobs_queues[thief].range, jobs_pack(mid, end));
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+static void jobs_run(int worker) {
+  unsigned int chunk;
+  do {
+    while (jobs_pop(worker, &chunk)) {
+      int begin = (int)chunk * jobs_chunk;
+      int end = begin + jobs_chunk < jobs_count ? begin + jobs_chunk : jobs_count;
+      jobs_body(jobs_ctx, begin, end, worker);
+      atomic_fetch_sub(&jobs_chunks_left, 1);
+    }
+  } while (jobs_steal(worker));
+}
+
+static void* jobs_worker_main(void* arg) {
+  int worker = (int)(size_t)arg;
+  unsigned int seen = 0;
+  pthread_mutex_lock(&jobs_mutex);
+  for (;;) {
+    while (!jobs_quit && jobs_generation == seen) pthread_cond_wait(&jobs_wake, &jobs_mutex);
+    if (jobs_quit) break;
+    seen = jobs_generation;
+    if (!jobs_body) continue; /* woke after the job was already finished */
+    atomic_fetch_add(&jobs_joined, 1);
+    pthread_mutex_unlock(&jobs_mutex);
+    jobs_run(worker);
+    atomic_fetch_sub(&jobs_joined, 1);
+    pthread_mutex_lock(&jobs_mutex);
+  }
+  pthread_mutex_unlock(&jobs_mutex);
+  return 0;
+}
+
+static void jobs_shutdown(void) {
+  pthread_mutex_lock(&jobs_mutex);
+  jobs_quit = 1;
+  pthread_cond_broadcast(&jobs_wake);
+  pthread_mutex_unlock(&jobs_mutex);
+  for (int w = 1; w < jobs_threads; w++) pthread_join(jobs_workers[w], 0);
+  jobs_quit = 0;
+  jobs_threads = 1;
+}
+
+/* Restarts the pool with `threads` workers including the caller; returns the count actually running */
+static int jobs_init(int threads) {
+  if (threads < 1) threads = 1;
+  if (threads > JOBS_MAX_THREADS) threads = JOBS_MAX_THREADS;
+  if (threads == jobs_threads) return jobs_threads;
+  jobs_shutdown();
+  while (jobs_threads < threads &&
+         pthread_create(&jobs_workers[jobs_threads], 0, jobs_worker_main, (void*)(size_t)jobs_threads) == 0)
+    jobs_threads++;
+  return jobs_threads;
+}
+
+static void jobs_parallel_for(int count, int chunk, jobs_fn fn, void* ctx) {
+  if (count <= 0) return;
+  int chunks = (count + chunk - 1) / chunk;
+  if (jobs_threads <= 1 || chunks <= 1) {
+    for (int begin = 0; begin < count; begin += chunk) fn(ctx, begin, begin + chunk < count ? begin + chunk : count, 0);
+    return;
+  }
+  for (int w = 0; w < jobs_threads; w++)
+    atomic_store(&jobs_queues[w].range, jobs_pack((unsigned int)(chunks * w / jobs_threads),
+                                                  (unsigned int)(chunks * (w + 1) / jobs_threads)));
+  atomic_store(&jobs_chunks_left, chunks);
+  pthread_mutex_lock(&jobs_mutex);
+  jobs_body = fn;
+  jobs_ctx = ctx;
+  jobs_count = count;
+  jobs_chunk = chunk;
+  jobs_generation++;
+  pthread_cond_broadcast(&jobs_wake);
+  pthread_mutex_unlock(&jobs_mutex);
+
+  jobs_run(0);
+  while (atomic_load(&jobs_chunks_left) > 0) sched_yield(); /* stolen chunks still running */
+
+  /* Close the job to late joiners, then let joined workers finish their last steal pass and leave it before
+     the queues are reused */
+  pthread_mutex_lock(&jobs_mutex);
+  jobs_body = 0;
+  pthread_mutex_unlock(&jobs_mutex);
+  while (atomic_load(&jobs_joined) > 0) sched_yield();
+}
+#else
+static int jobs_init(int threads) {
+  (void)threads;
+  return 1;
+}
+
+static void jobs_parallel_for(int count, int chunk, jobs_fn fn, void* ctx) {
+  for (int begin = 0; begin < count; begin += chunk) fn(ctx, begin, begin + chunk < count ? begin + chunk : count, 0);
+}
+#endif
+
+#endif /* JOBS_H */
@@ -0,0 +1,363 @@
+#ifndef NETCODE_H
+#define NETCODE_H
+
+/* Snapshot delta coding for replication. A frame is a few entity classes, each a list of entities sorted by
+   id with a fixed number of quantized unsigned fields (NetSchema). A packet codes one frame against a
+   baseline frame the receiver already holds (the newest it acknowledged), or against nothing:
+     per class: one bit per baseline entity (still present?), then for each kept one a changed bit and,
+     if changed, the field mask (or one bit if it equals the previous entity's) and the changed fields; then
+     the count of new entities, their id gaps and all their fields.
+   Changed fields are either the difference to the baseline wrapped to the field width, zigzag and
+   exp-Golomb coded (small moves cost a few bits), or the absolute value for fields that rarely change.
+   Both ends keep the last NET_HISTORY frames in a NetHistory, so baselines up to NET_HISTORY - 1 frames old
+   can be used. A receiver drops packets NET_HISTORY or more behind the newest it decoded, and never lets a
+   late packet evict a newer frame. Bits are packed LSB first; the packet header is u32 seq, u32 baseline seq (0 = none),
+   u32 tick. */
+#include <stdlib.h>
+#include <string.h>
+
+#define NET_MAX_FIELDS  8
+#define NET_MAX_CLASSES 4
+#define NET_HISTORY     16
+#define NET_ID_K        2 /* exp-Golomb order of new-entity id gaps */
+#define NET_COUNT_K     4 /* and of the new-entity count */
+
+typedef struct {
+  int fields;
+  unsigned char bits[NET_MAX_FIELDS]; /* width of the quantized value, 1..32 */
+  signed char k[NET_MAX_FIELDS];      /* exp-Golomb order of the change, or -1 to resend it absolute */
+} NetSchema;
+
+typedef struct {
+  int count, capacity;
+  unsigned int* ids;    /* ascending */
+  unsigned int* values; /* count rows of schema fields */
+} NetEntities;
+
+typedef struct {
+  unsigned int seq; /* 0 = empty slot */
+  unsigned int tick;
+  NetEntities classes[NET_MAX_CLASSES];
+} NetFrame;
+
+typedef struct {
+  int classes;
+  const NetSchema* schemas;
+  NetFrame frames[NET_HISTORY]; /* frame seq lives in frames[seq % NET_HISTORY] */
+  NetFrame pending; /* the packet being decoded; swapped into frames only once it decoded */
+  NetEntities scratch[NET_MAX_CLASSES]; /* new entities of the packet being decoded */
+  unsigned int newest; /* highest seq decoded so far */
+} NetHistory;
+
+/* Bit packing */
+typedef struct {
+  unsigned char* data;
+  int capacity, size; /* bytes */
+  unsigned long long acc;
+  int acc_bits;
+  int overflow;
+} NetWriter;
+
+typedef struct {
+  const unsigned char* data;
+  int size, pos; /* bytes */
+  unsigned long long acc;
+  int acc_bits;
+  int overflow; /* read past the end */
+} NetReader;
+
+static void net_writer_init(NetWriter* w, unsigned char* data, int capacity) {
+  memset(w, 0, sizeof(*w));
+  w->data = data;
+  w->capacity = capacity;
+}
+
+static void net_write_bits(NetWriter* w, unsigned int value, int bits) {
+  if (bits <= 0) return;
+  if (bits < 32) value &= (1u << bits) - 1u;
+  w->acc |= (unsigned long long)value << w->acc_bits;
+  w->acc_bits += bits;
+  while (w->acc_bits >= 8) {
+    if (w->size < w->capacity) w->data[w->size] = (unsigned char)w->acc;
+    else w->overflow = 1;
+    w->size++;
+    w->acc >>= 8;
+    w->acc_bits -= 8;
+  }
+}
+
+/* Exp-Golomb of order k: for n = v + 2^k with len bits below its top bit, len - k zeros, a one, then those
+   len bits */
+static void net_write_ue(NetWriter* w, unsigned int v, int k) {
+  unsigned long long n = (unsigned long long)v + (1ull << k);
+  int len = 0;
+  while ((n >> len) > 1) len++;
+  net_write_bits(w, 0, len - k);
+  net_write_bits(w, 1, 1);
+  if (len > 32) {
+    net_write_bits(w, (unsigned int)n, 32);
+    net_write_bits(w, (unsigned int)(n >> 32), len - 32);
+  } else {
+    net_write_bits(w, (unsigned int)n, len);
+  }
+}
+
+/* Signed difference wrapped to `bits`, then zigzag (0, -1, 1, -2, ...) */
+static unsigned int net_zigzag(unsigned int cur, unsigned int base, int bits) {
+  int shift = 32 - bits;
+  int d = (int)((cur - base) << shift) >> shift;
+  return ((unsigned int)d << 1) ^ (unsigned int)(d >> 31);
+}
+
+static unsigned int net_unzigzag(unsigned int z, unsigned int base, int bits) {
+  unsigned int d = (z >> 1) ^ (0u - (z & 1u));
+  return bits < 32 ? (base + d) & ((1u << bits) - 1u) : base + d;
+}
+
+/* Returns the packet size in bytes, or -1 if it did not fit */
+static int net_writer_finish(NetWriter* w) {
+  if (w->acc_bits > 0) net_write_bits(w, 0, 8 - w->acc_bits);
+  return w->overflow ? -1 : w->size;
+}
+
+static void net_reader_init(NetReader* r, const unsigned char* data, int size) {
+  memset(r, 0, sizeof(*r));
+  r->data = data;
+  r->size = size;
+}
+
+static unsigned int net_read_bits(NetReader* r, int bits) {
+  if (bits <= 0) return 0;
+  while (r->acc_bits < bits) {
+    unsigned long long byte = 0;
+    if (r->pos < r->size) byte = r->data[r->pos];
+    else r->overflow = 1;
+    r->pos++;
+    r->acc |= byte << r->acc_bits;
+    r->acc_bits += 8;
+  }
+  unsigned int v = bits < 32 ? (unsigned int)r->acc & ((1u << bits) - 1u) : (unsigned int)r->acc;
+  r->acc >>= bits;
+  r->acc_bits -= bits;
+  return v;
+}
+
+static unsigned int net_read_ue(NetReader* r, int k) {
+  int zeros = 0;
+  while (!net_read_bits(r, 1)) {
+    if (++zeros > 32 || r->overflow) {
+      r->overflow = 1;
+      return 0;
+    }
+  }
+  int len = zeros + k; /* bits after the leading one */
+  unsigned long long n = 1ull << len;
+  if (len > 32) {
+    n |= net_read_bits(r, 32);
+    n |= (unsigned long long)net_read_bits(r, len - 32) << 32;
+  } else {
+    n |= net_read_bits(r, len);
+  }
+  return (unsigned int)(n - (1ull << k));
+}
+
+/* Frame history */
+static int net_entities_alloc(NetEntities* e, const NetSchema* s, int capacity) {
+  size_t n = (size_t)(capacity > 0 ? capacity : 1);
+  e->count = 0;
+  e->capacity = capacity;
+  e->ids = (unsigned int*)malloc(sizeof(unsigned int) * n);
+  e->values = (unsigned int*)malloc(sizeof(unsigned int) * n * (size_t)s->fields);
+  return e->ids && e->values;
+}
+
+static void net_history_free(NetHistory* h) {
+  for (int c = 0; c < h->classes; c++) {
+    for (int f = 0; f < NET_HISTORY; f++) {
+      free(h->frames[f].classes[c].ids);
+      free(h->frames[f].classes[c].values);
+    }
+    free(h->pending.classes[c].ids);
+    free(h->pending.classes[c].values);
+    free(h->scratch[c].ids);
+    free(h->scratch[c].values);
+  }
+  memset(h, 0, sizeof(*h));
+}
+
+/* capacities[c] bounds the entities of class c per frame; returns 0 (and frees) when out of memory */
+static int net_history_init(NetHistory* h, int classes, const NetSchema* schemas, const int* capacities) {
+  memset(h, 0, sizeof(*h));
+  h->classes = classes;
+  h->schemas = schemas;
+  int ok = 1;
+  for (int c = 0; c < classes; c++) {
+    for (int f = 0; f < NET_HISTORY; f++) ok &= net_entities_alloc(&h->frames[f].classes[c], &schemas[c], capacities[c]);
+    ok &= net_entities_alloc(&h->pending.classes[c], &schemas[c], capacities[c]);
+    ok &= net_entities_alloc(&h->scratch[c], &schemas[c], capacities[c]);
+  }
+  if (!ok) net_history_free(h);
+  return ok;
+}
+
+/* The frame stored under seq, or 0 if it was never stored or has been overwritten */
+static NetFrame* net_history_find(const NetHistory* h, unsigned int seq) {
+  const NetFrame* f = &h->frames[seq % NET_HISTORY];
+  return seq != 0 && f->seq == seq ? (NetFrame*)f : 0;
+}
+
+/* Claims the slot of seq (evicting whatever was there) as an empty frame */
+static NetFrame* net_history_claim(NetHistory* h, unsigned int seq, unsigned int tick) {
+  NetFrame* f = &h->frames[seq % NET_HISTORY];
+  f->seq = seq;
+  f->tick = tick;
+  for (int c = 0; c < h->classes; c++) f->classes[c].count = 0;
+  return f;
+}
+
+/* Appends an entity (ids must arrive ascending); returns its value row, or 0 when the class is full */
+static unsigned int* net_entities_push(NetEntities* e, const NetSchema* s, unsigned int id) {
+  if (e->count >= e->capacity) return 0;
+  e->ids[e->count] = id;
+  return &e->values[(size_t)e->count++ * (size_t)s->fields];
+}
+
+/* Class coding */
+static void net_encode_entities(NetWriter* w, const NetSchema* s, const NetEntities* base, const NetEntities* cur) {
+  int j = 0, added = 0;
+  unsigned int last_mask = 0;
+  for (int i = 0; i < base->count; i++) {
+    unsigned int id = base->ids[i];
+    while (j < cur->count && cur->ids[j] < id) { j++; added++; }
+    if (j >= cur->count || cur->ids[j] != id) {
+      net_write_bits(w, 0, 1);
+      continue;
+    }
+    const unsigned int* b = &base->values[(size_t)i * (size_t)s->fields];
+    const unsigned int* v = &cur->values[(size_t)j * (size_t)s->fields];
+    unsigned int mask = 0;
+    for (int f = 0; f < s->fields; f++)
+      if (v[f] != b[f]) mask |= 1u << f;
+    net_write_bits(w, mask ? 3u : 1u, 2); /* present, then changed */
+    if (mask) {
+      net_write_bits(w, mask == last_mask, 1); /* most entities change the same fields as the one before */
+      if (mask != last_mask) net_write_bits(w, mask, s->fields);
+      last_mask = mask;
+      for (int f = 0; f < s->fields; f++) {
+        if (!(mask & (1u << f))) continue;
+        if (s->k[f] < 0) net_write_bits(w, v[f], s->bits[f]);
+        else net_write_ue(w, net_zigzag(v[f], b[f], s->bits[f]), s->k[f]);
+      }
+    }
+    j++;
+  }
+  added += cur->count - j;
+  net_write_ue(w, (unsigned int)added, NET_COUNT_K);
+  unsigned int next_id = 0; /* smallest id the next new entity can have */
+  j = 0;
+  for (int i = 0; i < cur->count; i++) {
+    unsigned int id = cur->ids[i];
+    while (j < base->count && base->ids[j] < id) j++;
+    if (j < base->count && base->ids[j] == id) continue;
+    net_write_ue(w, id - next_id, NET_ID_K);
+    next_id = id + 1;
+    const unsigned int* v = &cur->values[(size_t)i * (size_t)s->fields];
+    for (int f = 0; f < s->fields; f++) net_write_bits(w, v[f], s->bits[f]);
+  }
+}
+
+/* Rebuilds a class from base; new entities are read into scratch and merged in by id. Returns 0 if the
+   packet is malformed or the class does not fit out. */
+static int net_decode_entities(NetReader* r, const NetSchema* s, const NetEntities* base, NetEntities* out,
+                               NetEntities* scratch) {
+  size_t row = sizeof(unsigned int) * (size_t)s->fields;
+  unsigned int mask = 0;
+  int n = 0;
+  for (int i = 0; i < base->count; i++) {
+    if (!net_read_bits(r, 1)) continue;
+    if (n >= out->capacity) return 0;
+    const unsigned int* b = &base->values[(size_t)i * (size_t)s->fields];
+    unsigned int* v = &out->values[(size_t)n * (size_t)s->fields];
+    out->ids[n++] = base->ids[i];
+    memcpy(v, b, row);
+    if (!net_read_bits(r, 1)) continue;
+    if (!net_read_bits(r, 1)) mask = net_read_bits(r, s->fields);
+    for (int f = 0; f < s->fields; f++) {
+      if (!(mask & (1u << f))) continue;
+      if (s->k[f] < 0) v[f] = net_read_bits(r, s->bits[f]);
+      else v[f] = net_unzigzag(net_read_ue(r, s->k[f]), b[f], s->bits[f]);
+    }
+  }
+  unsigned int added = net_read_ue(r, NET_COUNT_K);
+  if (r->overflow || added > (unsigned int)(out->capacity - n)) return 0;
+  unsigned int next_id = 0;
+  scratch->count = 0;
+  for (unsigned int a = 0; a < added; a++) {
+    unsigned int id = next_id + net_read_ue(r, NET_ID_K);
+    next_id = id + 1;
+    unsigned int* v = net_entities_push(scratch, s, id);
+    for (int f = 0; f < s->fields; f++) v[f] = net_read_bits(r, s->bits[f]);
+  }
+  if (r->overflow) return 0;
+  /* Backward merge: kept entities stay at the front of out, new ones come from scratch */
+  int ki = n - 1, ai = scratch->count - 1;
+  for (int dst = n + scratch->count - 1; ai >= 0; dst--) {
+    if (ki >= 0 && out->ids[ki] > scratch->ids[ai]) {
+      out->ids[dst] = out->ids[ki];
+      memmove(&out->values[(size_t)dst * (size_t)s->fields], &out->values[(size_t)ki-- * (size_t)s->fields], row);
+    } else {
+      out->ids[dst] = scratch->ids[ai];
+      memcpy(&out->values[(size_t)dst * (size_t)s->fields], &scratch->values[(size_t)ai-- * (size_t)s->fields], row);
+    }
+  }
+  out->count = n + scratch->count;
+  return 1;
+}
+
+/* Frame coding. base may be 0 (full frame). Returns bytes written, or -1 if capacity was too small. */
+static int net_encode_frame(const NetHistory* h, const NetFrame* base, const NetFrame* cur, unsigned char* out,
+                            int capacity) {
+  static const NetEntities empty = { 0, 0, 0, 0 };
+  NetWriter w;
+  net_writer_init(&w, out, capacity);
+  net_write_bits(&w, cur->seq, 32);
+  net_write_bits(&w, base ? base->seq : 0u, 32);
+  net_write_bits(&w, cur->tick, 32);
+  for (int c = 0; c < h->classes; c++)
+    net_encode_entities(&w, &h->schemas[c], base ? &base->classes[c] : &empty, &cur->classes[c]);
+  return net_writer_finish(&w);
+}
+
+/* Decodes a packet into h; returns the new frame, or 0 if it is malformed, stale or its baseline is gone.
+   Nothing in h changes unless the packet decodes. */
+static NetFrame* net_decode_frame(NetHistory* h, const unsigned char* data, int size) {
+  static const NetEntities empty = { 0, 0, 0, 0 };
+  NetReader r;
+  net_reader_init(&r, data, size);
+  unsigned int seq = net_read_bits(&r, 32);
+  unsigned int base_seq = net_read_bits(&r, 32);
+  unsigned int tick = net_read_bits(&r, 32);
+  if (r.overflow || seq == 0 || (base_seq != 0 && (base_seq >= seq || seq - base_seq >= NET_HISTORY))) return 0;
+  if (h->newest >= NET_HISTORY && seq <= h->newest - NET_HISTORY) return 0; /* too old to keep */
+  NetFrame* slot = &h->frames[seq % NET_HISTORY];
+  if (slot->seq >= seq) return 0; /* duplicate, or a newer frame already holds the slot */
+  const NetFrame* base = base_seq ? net_history_find(h, base_seq) : 0;
+  if (base_seq && !base) return 0;
+  NetFrame* f = &h->pending;
+  for (int c = 0; c < h->classes; c++) {
+    if (!net_decode_entities(&r, &h->schemas[c], base ? &base->classes[c] : &empty, &f->classes[c], &h->scratch[c]))
+      return 0;
+  }
+  if (r.overflow) return 0;
+  /* The evicted frame's buffers become the next pending frame (seq - base_seq < NET_HISTORY keeps the
+     baseline out of this slot) */
+  NetFrame done = *f;
+  done.seq = seq;
+  done.tick = tick;
+  h->pending = *slot;
+  *slot = done;
+  if (seq > h->newest) h->newest = seq;
+  return slot;
+}
+
+#endif /* NETCODE_H */
@@ -0,0 +1,78 @@
+#ifndef STATS_H
+#define STATS_H
+
+/* Instrumentation (GAME_STATS): STATS_TIMER starts a phase clock, STATS_PHASE adds the elapsed time to a
+   GameStats field (and emits a trace event while a native trace is open), STATS_ADD bumps a counter. All
+   three compile to nothing otherwise.
+   The core defines STATS_STEP_NAME (the trace event's key for the update it belongs to) before including
+   this, after game.h and jobs.h, and STATS_STEP (that update's number) and `static GameStats stats` before
+   its first phase. */
+#if GAME_STATS
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#else
+#include <stdio.h>
+#include <time.h>
+
+static FILE* trace_file;
+static int trace_events;
+static unsigned long long trace_origin_ns;
+#endif
+
+static unsigned long long stats_now_ns(void) {
+#ifdef __EMSCRIPTEN__
+  return (unsigned long long)(emscripten_get_now() * 1e6);
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+#endif
+}
+
+static void stats_phase(unsigned int* field, const char* name, unsigned long long start, unsigned int step) {
+  unsigned long long end = stats_now_ns();
+  *field += (unsigned int)(end - start);
+#ifndef __EMSCRIPTEN__
+  if (trace_file)
+    fprintf(trace_file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"" STATS_STEP_NAME "\":%u}}",
+            trace_events++ ? ",\n" : "", name, (double)(start - trace_origin_ns) * 1e-3, (double)(end - start) * 1e-3, step);
+#else
+  (void)name;
+  (void)step;
+#endif
+}
+
+#ifndef __EMSCRIPTEN__
+static void stats_trace_close(void) {
+  if (!trace_file) return;
+  fputs("\n]}\n", trace_file);
+  fclose(trace_file);
+  trace_file = 0;
+}
+
+/* Chrome trace (JSON object format): one complete ("X") event per timed phase until stats_trace_close */
+static int stats_trace_open(const char* path) {
+  stats_trace_close();
+  trace_file = fopen(path, "w");
+  if (!trace_file) return 0;
+  fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", trace_file);
+  trace_events = 0;
+  trace_origin_ns = stats_now_ns();
+  return 1;
+}
+#endif
+
+#define STATS_TIMER(t) unsigned long long t = stats_now_ns()
+#define STATS_PHASE(field, name, t) stats_phase(&stats.field, name, t, STATS_STEP)
+#if GAME_THREADS
+#define STATS_ADD(field, n) __atomic_fetch_add(&stats.field, (unsigned int)(n), __ATOMIC_RELAXED) /* job workers too */
+#else
+#define STATS_ADD(field, n) (stats.field += (unsigned int)(n))
+#endif
+#else
+#define STATS_TIMER(t) ((void)0)
+#define STATS_PHASE(field, name, t) ((void)0)
+#define STATS_ADD(field, n) ((void)(n))
+#endif
+
+#endif /* STATS_H */
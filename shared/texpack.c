@@ -0,0 +1,815 @@
+/* Offline texture packer: PNG in, GPU-ready KTX2 out (Khronos KTX 2.0, no supercompression). Decodes the PNG
+   (8-bit gray/RGB/RGBA, not interlaced; alpha is dropped), optionally box-filters it down to --max-size,
+   builds the full mip chain with 2x2 box filtering in linear light, and block-compresses every level so the
+   browser uploads it as is: no PNG decode, no mip generation and a quarter (RGB) of the VRAM.
+     bc1   BC1 / DXT1 RGB, vkFormat 132 (131 with --linear), for WEBGL_compressed_texture_s3tc (desktop)
+     etc2  ETC1-compatible ETC2 RGB, vkFormat 148 (147), for WEBGL_compressed_texture_etc (mobile, WebGL2)
+   Each game's js/game.js picks the file its GPU can sample and falls back to the PNG. Build and run from
+   Test1/wasm or Test2/wasm with `make textures`, or
+     cc -O2 ../../shared/texpack.c -o texpack -lm
+   Usage: texpack [--format bc1|etc2] [--max-size N] [--linear] IN.png OUT.ktx2
+     --max-size N  halve the image until neither side exceeds N
+     --linear      data texture (normals, masks): no sRGB decode while filtering, UNORM vkFormat
+   Prints one JSON line with the sizes and the RMS error of the top level against the source. */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ---- inflate (RFC 1951) ---- */
+
+typedef struct {
+  const unsigned char* in;
+  size_t in_len, in_pos;
+  unsigned int bit_buf;
+  int bit_count;
+  unsigned char* out;
+  size_t out_len, out_pos;
+  int err;
+} Inflate;
+
+typedef struct {
+  short count[16];   /* codes of each length */
+  short symbol[320]; /* symbols ordered by code */
+} Huffman;
+
+static int inflate_bits(Inflate* s, int n) {
+  while (s->bit_count < n) {
+    if (s->in_pos >= s->in_len) {
+      s->err = 1;
+      return 0;
+    }
+    s->bit_buf |= (unsigned int)s->in[s->in_pos++] << s->bit_count;
+    s->bit_count += 8;
+  }
+  int v = (int)(s->bit_buf & ((1u << n) - 1));
+  s->bit_buf >>= n;
+  s->bit_count -= n;
+  return v;
+}
+
+/* Canonical code from code lengths; 0 if the lengths over-subscribe the code space */
+static int huffman_build(Huffman* h, const unsigned char* lengths, int n) {
+  short offs[16];
+  memset(h->count, 0, sizeof(h->count));
+  for (int i = 0; i < n; i++) h->count[lengths[i]]++;
+  h->count[0] = 0;
+  int left = 1;
+  for (int len = 1; len < 16; len++) {
+    left = (left << 1) - h->count[len];
+    if (left < 0) return 0;
+  }
+  offs[1] = 0;
+  for (int len = 1; len < 15; len++) offs[len + 1] = (short)(offs[len] + h->count[len]);
+  for (int i = 0; i < n; i++)
+    if (lengths[i]) h->symbol[offs[lengths[i]]++] = (short)i;
+  return 1;
+}
+
+static int huffman_decode(Inflate* s, const Huffman* h) {
+  int code = 0, first = 0, index = 0;
+  for (int len = 1; len < 16; len++) {
+    code |= inflate_bits(s, 1);
+    int count = h->count[len];
+    if (code - count < first) return h->symbol[index + (code - first)];
+    index += count;
+    first = (first + count) << 1;
+    code <<= 1;
+  }
+  s->err = 1;
+  return 0;
+}
+
+static const short length_base[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                      31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const short length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                       2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const short dist_base[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                    193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const short dist_extra[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                     6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static int inflate_codes(Inflate* s, const Huffman* lit, const Huffman* dist) {
+  for (;;) {
+    int sym = huffman_decode(s, lit);
+    if (s->err) return 0;
+    if (sym < 256) {
+      if (s->out_pos >= s->out_len) return 0;
+      s->out[s->out_pos++] = (unsigned char)sym;
+    } else if (sym == 256) {
+      return 1;
+    } else {
+      sym -= 257;
+      if (sym >= 29) return 0;
+      int len = length_base[sym] + inflate_bits(s, length_extra[sym]);
+      int dsym = huffman_decode(s, dist);
+      if (s->err || dsym >= 30) return 0;
+      size_t d = (size_t)(dist_base[dsym] + inflate_bits(s, dist_extra[dsym]));
+      if (s->err || d > s->out_pos || s->out_pos + (size_t)len > s->out_len) return 0;
+      for (; len > 0; len--, s->out_pos++) s->out[s->out_pos] = s->out[s->out_pos - d];
+    }
+  }
+}
+
+static int inflate_dynamic(Inflate* s) {
+  static const unsigned char order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+  unsigned char lengths[320];
+  Huffman lit, dist;
+  int nlen = inflate_bits(s, 5) + 257;
+  int ndist = inflate_bits(s, 5) + 1;
+  int ncode = inflate_bits(s, 4) + 4;
+  if (s->err || nlen > 286 || ndist > 30) return 0;
+  memset(lengths, 0, sizeof(lengths));
+  for (int i = 0; i < ncode; i++) lengths[order[i]] = (unsigned char)inflate_bits(s, 3);
+  if (!huffman_build(&lit, lengths, 19)) return 0;
+  for (int i = 0; i < nlen + ndist;) {
+    int sym = huffman_decode(s, &lit);
+    if (s->err) return 0;
+    if (sym < 16) {
+      lengths[i++] = (unsigned char)sym;
+      continue;
+    }
+    int prev = 0, rep;
+    if (sym == 16) {
+      if (i == 0) return 0;
+      prev = lengths[i - 1];
+      rep = 3 + inflate_bits(s, 2);
+    } else if (sym == 17) {
+      rep = 3 + inflate_bits(s, 3);
+    } else {
+      rep = 11 + inflate_bits(s, 7);
+    }
+    if (i + rep > nlen + ndist) return 0;
+    while (rep--) lengths[i++] = (unsigned char)prev;
+  }
+  if (!huffman_build(&lit, lengths, nlen) || !huffman_build(&dist, lengths + nlen, ndist)) return 0;
+  return inflate_codes(s, &lit, &dist);
+}
+
+static int inflate_fixed(Inflate* s) {
+  static Huffman lit, dist;
+  static int built = 0;
+  if (!built) {
+    unsigned char lengths[320];
+    int i = 0;
+    for (; i < 144; i++) lengths[i] = 8;
+    for (; i < 256; i++) lengths[i] = 9;
+    for (; i < 280; i++) lengths[i] = 7;
+    for (; i < 288; i++) lengths[i] = 8;
+    huffman_build(&lit, lengths, 288);
+    for (i = 0; i < 30; i++) lengths[i] = 5;
+    huffman_build(&dist, lengths, 30);
+    built = 1;
+  }
+  return inflate_codes(s, &lit, &dist);
+}
+
+/* zlib stream into exactly out_len bytes; 1 on success */
+static int zlib_inflate(const unsigned char* in, size_t in_len, unsigned char* out, size_t out_len) {
+  Inflate s = {0};
+  if (in_len < 2 || (in[0] & 15) != 8 || ((in[0] << 8) | in[1]) % 31 || (in[1] & 32)) return 0;
+  s.in = in + 2;
+  s.in_len = in_len - 2;
+  s.out = out;
+  s.out_len = out_len;
+  int last;
+  do {
+    last = inflate_bits(&s, 1);
+    int type = inflate_bits(&s, 2);
+    if (s.err) return 0;
+    if (type == 0) {
+      s.bit_buf = 0;
+      s.bit_count = 0;
+      if (s.in_pos + 4 > s.in_len) return 0;
+      size_t len = s.in[s.in_pos] | (s.in[s.in_pos + 1] << 8);
+      size_t nlen = s.in[s.in_pos + 2] | (s.in[s.in_pos + 3] << 8);
+      s.in_pos += 4;
+      if (len != (~nlen & 0xffff) || s.in_pos + len > s.in_len || s.out_pos + len > s.out_len) return 0;
+      memcpy(s.out + s.out_pos, s.in + s.in_pos, len);
+      s.in_pos += len;
+      s.out_pos += len;
+    } else if (type == 1) {
+      if (!inflate_fixed(&s)) return 0;
+    } else if (type == 2) {
+      if (!inflate_dynamic(&s)) return 0;
+    } else {
+      return 0;
+    }
+  } while (!last);
+  return s.out_pos == out_len;
+}
+
+/* ---- PNG ---- */
+
+static unsigned int be32(const unsigned char* p) {
+  return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 8) | p[3];
+}
+
+static unsigned char* read_file(const char* path, size_t* size) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return 0;
+  fseek(f, 0, SEEK_END);
+  long n = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  unsigned char* data = n > 0 ? malloc((size_t)n) : 0;
+  if (data && fread(data, 1, (size_t)n, f) != (size_t)n) {
+    free(data);
+    data = 0;
+  }
+  fclose(f);
+  *size = data ? (size_t)n : 0;
+  return data;
+}
+
+static int paeth(int a, int b, int c) {
+  int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+  return pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+}
+
+/* RGB8 pixels of an 8-bit, non-interlaced PNG; 0 with a message on stderr otherwise */
+static unsigned char* png_load(const char* path, int* width, int* height) {
+  static const unsigned char signature[8] = {137, 'P', 'N', 'G', 13, 10, 26, 10};
+  size_t size;
+  unsigned char* file = read_file(path, &size);
+  unsigned char *idat = 0, *raw = 0, *rgb = 0;
+  size_t idat_len = 0;
+  int w = 0, h = 0, channels = 0;
+  const char* err = 0;
+  if (!file) {
+    err = "cannot read";
+    goto done;
+  }
+  if (size < 8 || memcmp(file, signature, 8)) {
+    err = "not a PNG";
+    goto done;
+  }
+  for (size_t pos = 8; pos + 12 <= size;) {
+    size_t len = be32(file + pos);
+    const unsigned char* type = file + pos + 4;
+    const unsigned char* data = file + pos + 8;
+    if (len > size - pos - 12) {
+      err = "truncated chunk";
+      goto done;
+    }
+    if (!memcmp(type, "IHDR", 4) && len >= 13) {
+      static const int channels_of[7] = {1, 0, 3, 0, 2, 0, 4};
+      w = (int)be32(data);
+      h = (int)be32(data + 4);
+      if (data[8] != 8 || data[9] > 6 || !channels_of[data[9]] || data[12]) {
+        err = "only 8-bit, non-interlaced gray, RGB or RGBA PNGs are supported";
+        goto done;
+      }
+      channels = channels_of[data[9]];
+    } else if (!memcmp(type, "IDAT", 4)) {
+      unsigned char* grown = realloc(idat, idat_len + len);
+      if (!grown) {
+        err = "out of memory";
+        goto done;
+      }
+      idat = grown;
+      memcpy(idat + idat_len, data, len);
+      idat_len += len;
+    } else if (!memcmp(type, "IEND", 4)) {
+      break;
+    }
+    pos += len + 12;
+  }
+  if (!channels || w <= 0 || h <= 0 || w > 16384 || h > 16384) {
+    err = "missing or unsupported IHDR";
+    goto done;
+  }
+  size_t stride = (size_t)w * channels;
+  raw = malloc((stride + 1) * h);
+  rgb = malloc((size_t)w * h * 3);
+  if (!raw || !rgb || !zlib_inflate(idat, idat_len, raw, (stride + 1) * h)) {
+    err = raw && rgb ? "corrupt image data" : "out of memory";
+    goto done;
+  }
+  /* Unfilter in place: each row keeps its filter byte, the reconstructed pixels follow it */
+  for (int y = 0; y < h; y++) {
+    unsigned char* row = raw + y * (stride + 1);
+    const unsigned char* prev = y ? row - (stride + 1) : 0;
+    int filter = row[0];
+    row++;
+    if (prev) prev++;
+    for (size_t i = 0; i < stride; i++) {
+      int a = i >= (size_t)channels ? row[i - channels] : 0;
+      int b = prev ? prev[i] : 0;
+      int c = prev && i >= (size_t)channels ? prev[i - channels] : 0;
+      int p = filter == 1 ? a : filter == 2 ? b : filter == 3 ? (a + b) >> 1 : filter == 4 ? paeth(a, b, c) : 0;
+      if (filter > 4) {
+        err = "bad row filter";
+        goto done;
+      }
+      row[i] = (unsigned char)(row[i] + p);
+    }
+    for (int x = 0; x < w; x++) {
+      const unsigned char* px = row + x * channels;
+      unsigned char* out = rgb + ((size_t)y * w + x) * 3;
+      out[0] = px[0];
+      out[1] = channels >= 3 ? px[1] : px[0];
+      out[2] = channels >= 3 ? px[2] : px[0];
+    }
+  }
+done:
+  if (err) {
+    fprintf(stderr, "%s: %s\n", path, err);
+    free(rgb);
+    rgb = 0;
+  }
+  free(file);
+  free(idat);
+  free(raw);
+  *width = w;
+  *height = h;
+  return rgb;
+}
+
+/* ---- mip chain (float RGB in linear light, or as stored with --linear) ---- */
+
+static float srgb_to_linear_table[256];
+
+static float linear_to_srgb(float v) {
+  v = v < 0.f ? 0.f : v > 1.f ? 1.f : v;
+  return v <= 0.0031308f ? v * 12.92f : 1.055f * powf(v, 1.f / 2.4f) - 0.055f;
+}
+
+static unsigned char to_byte(float v, int srgb) {
+  float s = (srgb ? linear_to_srgb(v) : (v < 0.f ? 0.f : v > 1.f ? 1.f : v)) * 255.f + 0.5f;
+  return (unsigned char)s;
+}
+
+/* Next level: 2x2 box (a single row/column folds onto itself when that side is already 1) */
+static float* downsample(const float* src, int w, int h, int* nw, int* nh) {
+  int dw = w > 1 ? w / 2 : 1, dh = h > 1 ? h / 2 : 1;
+  float* dst = malloc((size_t)dw * dh * 3 * sizeof(float));
+  if (!dst) return 0;
+  for (int y = 0; y < dh; y++) {
+    int y0 = y * 2 < h ? y * 2 : h - 1, y1 = y * 2 + 1 < h ? y * 2 + 1 : h - 1;
+    for (int x = 0; x < dw; x++) {
+      int x0 = x * 2 < w ? x * 2 : w - 1, x1 = x * 2 + 1 < w ? x * 2 + 1 : w - 1;
+      for (int c = 0; c < 3; c++) {
+        dst[(y * dw + x) * 3 + c] = 0.25f * (src[(y0 * w + x0) * 3 + c] + src[(y0 * w + x1) * 3 + c] +
+                                             src[(y1 * w + x0) * 3 + c] + src[(y1 * w + x1) * 3 + c]);
+      }
+    }
+  }
+  *nw = dw;
+  *nh = dh;
+  return dst;
+}
+
+/* 4x4 block at (bx, by) as bytes in the output encoding; edge blocks repeat the last row/column */
+static void fetch_block(const unsigned char* rgb, int w, int h, int bx, int by, unsigned char block[16][3]) {
+  for (int y = 0; y < 4; y++) {
+    int sy = by * 4 + y < h ? by * 4 + y : h - 1;
+    for (int x = 0; x < 4; x++) {
+      int sx = bx * 4 + x < w ? bx * 4 + x : w - 1;
+      memcpy(block[y * 4 + x], rgb + ((size_t)sy * w + sx) * 3, 3);
+    }
+  }
+}
+
+static int color_error(const unsigned char* a, const int* b) {
+  int dr = a[0] - b[0], dg = a[1] - b[1], db = a[2] - b[2];
+  return dr * dr + dg * dg + db * db;
+}
+
+/* ---- BC1 ---- */
+
+static int clamp255(int v) { return v < 0 ? 0 : v > 255 ? 255 : v; }
+
+static unsigned int pack565(const float* c) {
+  int r = clamp255((int)(c[0] + 0.5f)), g = clamp255((int)(c[1] + 0.5f)), b = clamp255((int)(c[2] + 0.5f));
+  return (unsigned int)(((r * 31 + 127) / 255) << 11 | ((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255));
+}
+
+static void unpack565(unsigned int c, int* out) {
+  int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+  out[0] = (r << 3) | (r >> 2);
+  out[1] = (g << 2) | (g >> 4);
+  out[2] = (b << 3) | (b >> 2);
+}
+
+/* Indices for endpoints c0 > c1 (four-color mode); returns the block's squared error */
+static int bc1_indices(const unsigned char block[16][3], unsigned int c0, unsigned int c1, unsigned int* bits) {
+  int pal[4][3];
+  unpack565(c0, pal[0]);
+  unpack565(c1, pal[1]);
+  for (int c = 0; c < 3; c++) {
+    pal[2][c] = (2 * pal[0][c] + pal[1][c]) / 3;
+    pal[3][c] = (pal[0][c] + 2 * pal[1][c]) / 3;
+  }
+  int total = 0;
+  *bits = 0;
+  for (int i = 0; i < 16; i++) {
+    int best = 0, best_err = color_error(block[i], pal[0]);
+    for (int k = 1; k < (c0 == c1 ? 1 : 4); k++) {
+      int e = color_error(block[i], pal[k]);
+      if (e < best_err) {
+        best_err = e;
+        best = k;
+      }
+    }
+    total += best_err;
+    *bits |= (unsigned int)best << (2 * i);
+  }
+  return total;
+}
+
+static int bc1_try(const unsigned char block[16][3], const float* e0, const float* e1, unsigned char* out, int best) {
+  unsigned int c0 = pack565(e0), c1 = pack565(e1), bits;
+  if (c0 < c1) {
+    unsigned int t = c0;
+    c0 = c1;
+    c1 = t;
+  }
+  int err = bc1_indices(block, c0, c1, &bits);
+  if (err >= best) return best;
+  out[0] = (unsigned char)c0;
+  out[1] = (unsigned char)(c0 >> 8);
+  out[2] = (unsigned char)c1;
+  out[3] = (unsigned char)(c1 >> 8);
+  for (int k = 0; k < 4; k++) out[4 + k] = (unsigned char)(bits >> (8 * k));
+  return err;
+}
+
+/* Endpoints on the block's principal axis, then one least-squares refit of both to the chosen indices */
+static int bc1_encode(const unsigned char block[16][3], unsigned char* out) {
+  static const float weight0[4] = {1.f, 0.f, 2.f / 3.f, 1.f / 3.f};
+  float mean[3] = {0, 0, 0}, cov[6] = {0, 0, 0, 0, 0, 0};
+  for (int i = 0; i < 16; i++)
+    for (int c = 0; c < 3; c++) mean[c] += block[i][c] * (1.f / 16.f);
+  for (int i = 0; i < 16; i++) {
+    float d[3] = {block[i][0] - mean[0], block[i][1] - mean[1], block[i][2] - mean[2]};
+    cov[0] += d[0] * d[0];
+    cov[1] += d[0] * d[1];
+    cov[2] += d[0] * d[2];
+    cov[3] += d[1] * d[1];
+    cov[4] += d[1] * d[2];
+    cov[5] += d[2] * d[2];
+  }
+  float axis[3] = {1.f, 1.f, 1.f};
+  for (int it = 0; it < 8; it++) {
+    float v[3] = {cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+                  cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+                  cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2]};
+    float len = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (len < 1e-6f) break;
+    for (int c = 0; c < 3; c++) axis[c] = v[c] / len;
+  }
+  float tmin = 0.f, tmax = 0.f;
+  for (int i = 0; i < 16; i++) {
+    float t = (block[i][0] - mean[0]) * axis[0] + (block[i][1] - mean[1]) * axis[1] + (block[i][2] - mean[2]) * axis[2];
+    if (t < tmin) tmin = t;
+    if (t > tmax) tmax = t;
+  }
+  float e0[3], e1[3];
+  for (int c = 0; c < 3; c++) {
+    e0[c] = mean[c] + axis[c] * tmax;
+    e1[c] = mean[c] + axis[c] * tmin;
+  }
+  int err = bc1_try(block, e0, e1, out, 0x7fffffff);
+
+  unsigned int bits = out[4] | (out[5] << 8) | (out[6] << 16) | ((unsigned int)out[7] << 24);
+  float aa = 0, ab = 0, bb = 0, ax[3] = {0, 0, 0}, bx[3] = {0, 0, 0};
+  for (int i = 0; i < 16; i++) {
+    float a = weight0[(bits >> (2 * i)) & 3], b = 1.f - a;
+    aa += a * a;
+    ab += a * b;
+    bb += b * b;
+    for (int c = 0; c < 3; c++) {
+      ax[c] += a * block[i][c];
+      bx[c] += b * block[i][c];
+    }
+  }
+  float det = aa * bb - ab * ab;
+  if (fabsf(det) > 1e-6f) {
+    for (int c = 0; c < 3; c++) {
+      e0[c] = (bb * ax[c] - ab * bx[c]) / det;
+      e1[c] = (aa * bx[c] - ab * ax[c]) / det;
+    }
+    err = bc1_try(block, e0, e1, out, err);
+  }
+  return err;
+}
+
+/* ---- ETC1 (valid ETC2 RGB) ---- */
+
+static const int etc_modifiers[8][2] = {{2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}};
+
+/* Best table and per-pixel indices for one half block around base; returns its squared error */
+static int etc_subblock(const unsigned char block[16][3], const int* pixels, const int* base, int* table_out,
+                        int* idx_out) {
+  int best = 0x7fffffff;
+  for (int t = 0; t < 8; t++) {
+    int mods[4] = {etc_modifiers[t][0], etc_modifiers[t][1], -etc_modifiers[t][0], -etc_modifiers[t][1]};
+    int total = 0, idx[8];
+    for (int p = 0; p < 8 && total < best; p++) {
+      int best_err = 0x7fffffff;
+      for (int k = 0; k < 4; k++) {
+        int c[3] = {clamp255(base[0] + mods[k]), clamp255(base[1] + mods[k]), clamp255(base[2] + mods[k])};
+        int e = color_error(block[pixels[p]], c);
+        if (e < best_err) {
+          best_err = e;
+          idx[p] = k;
+        }
+      }
+      total += best_err;
+    }
+    if (total < best) {
+      best = total;
+      *table_out = t;
+      memcpy(idx_out, idx, sizeof(idx));
+    }
+  }
+  return best;
+}
+
+static void etc_encode(const unsigned char block[16][3], unsigned char* out) {
+  unsigned long long best_word = 0;
+  int best_err = 0x7fffffff;
+  for (int flip = 0; flip < 2; flip++) {
+    int pixels[2][8], n[2] = {0, 0};
+    float avg[2][3] = {{0, 0, 0}, {0, 0, 0}};
+    for (int y = 0; y < 4; y++) {
+      for (int x = 0; x < 4; x++) {
+        int half = flip ? y >= 2 : x >= 2;
+        pixels[half][n[half]++] = y * 4 + x;
+        for (int c = 0; c < 3; c++) avg[half][c] += block[y * 4 + x][c] * (1.f / 8.f);
+      }
+    }
+    for (int diff = 0; diff < 2; diff++) {
+      int q[2][3], base[2][3];
+      for (int c = 0; c < 3; c++) {
+        if (diff) {
+          q[0][c] = (int)(avg[0][c] * 31.f / 255.f + 0.5f);
+          int d = (int)(avg[1][c] * 31.f / 255.f + 0.5f) - q[0][c];
+          q[1][c] = q[0][c] + (d < -4 ? -4 : d > 3 ? 3 : d);
+          for (int s = 0; s < 2; s++) base[s][c] = (q[s][c] << 3) | (q[s][c] >> 2);
+        } else {
+          for (int s = 0; s < 2; s++) {
+            q[s][c] = (int)(avg[s][c] * 15.f / 255.f + 0.5f);
+            base[s][c] = q[s][c] * 17;
+          }
+        }
+      }
+      int table[2], idx[2][8];
+      int err = etc_subblock(block, pixels[0], base[0], &table[0], idx[0]);
+      err += etc_subblock(block, pixels[1], base[1], &table[1], idx[1]);
+      if (err >= best_err) continue;
+      best_err = err;
+      unsigned long long word = 0;
+      for (int c = 0; c < 3; c++) {
+        int shift = 56 - 8 * c;
+        if (diff) word |= (unsigned long long)(q[0][c] << 3 | ((q[1][c] - q[0][c]) & 7)) << shift;
+        else word |= (unsigned long long)(q[0][c] << 4 | q[1][c]) << shift;
+      }
+      word |= (unsigned long long)table[0] << 37 | (unsigned long long)table[1] << 34;
+      word |= (unsigned long long)diff << 33 | (unsigned long long)flip << 32;
+      /* Index bits are numbered column-major: pixel (x, y) is bit x * 4 + y of each half */
+      for (int s = 0; s < 2; s++) {
+        for (int p = 0; p < 8; p++) {
+          int px = pixels[s][p], bit = (px & 3) * 4 + (px >> 2), v = idx[s][p]; /* (msb, lsb): +a, +b, -a, -b */
+          word |= (unsigned long long)(v >> 1) << (16 + bit) | (unsigned long long)(v & 1) << bit;
+        }
+      }
+      best_word = word;
+    }
+  }
+  for (int k = 0; k < 8; k++) out[k] = (unsigned char)(best_word >> (56 - 8 * k));
+}
+
+/* ---- decoders, for the reported error ---- */
+
+static void bc1_decode(const unsigned char* in, unsigned char block[16][3]) {
+  unsigned int c0 = in[0] | (in[1] << 8), c1 = in[2] | (in[3] << 8);
+  unsigned int bits = in[4] | (in[5] << 8) | (in[6] << 16) | ((unsigned int)in[7] << 24);
+  int pal[4][3];
+  unpack565(c0, pal[0]);
+  unpack565(c1, pal[1]);
+  for (int c = 0; c < 3; c++) {
+    pal[2][c] = c0 > c1 ? (2 * pal[0][c] + pal[1][c]) / 3 : (pal[0][c] + pal[1][c]) / 2;
+    pal[3][c] = c0 > c1 ? (pal[0][c] + 2 * pal[1][c]) / 3 : 0;
+  }
+  for (int i = 0; i < 16; i++)
+    for (int c = 0; c < 3; c++) block[i][c] = (unsigned char)pal[(bits >> (2 * i)) & 3][c];
+}
+
+static void etc_decode(const unsigned char* in, unsigned char block[16][3]) {
+  unsigned long long word = 0;
+  for (int k = 0; k < 8; k++) word = word << 8 | in[k];
+  int diff = (int)(word >> 33) & 1, flip = (int)(word >> 32) & 1;
+  int base[2][3];
+  for (int c = 0; c < 3; c++) {
+    int v = (int)(word >> (56 - 8 * c)) & 255;
+    if (diff) {
+      int q0 = v >> 3, q1 = q0 + ((v & 7) ^ 4) - 4;
+      base[0][c] = (q0 << 3) | (q0 >> 2);
+      base[1][c] = (q1 << 3) | (q1 >> 2);
+    } else {
+      base[0][c] = (v >> 4) * 17;
+      base[1][c] = (v & 15) * 17;
+    }
+  }
+  int table[2] = {(int)(word >> 37) & 7, (int)(word >> 34) & 7};
+  for (int y = 0; y < 4; y++) {
+    for (int x = 0; x < 4; x++) {
+      int half = flip ? y >= 2 : x >= 2, bit = x * 4 + y;
+      int k = (int)((word >> (16 + bit)) & 1) << 1 | (int)((word >> bit) & 1);
+      int m = etc_modifiers[table[half]][k & 1] * (k & 2 ? -1 : 1);
+      for (int c = 0; c < 3; c++) block[y * 4 + x][c] = (unsigned char)clamp255(base[half][c] + m);
+    }
+  }
+}
+
+/* ---- KTX2 ---- */
+
+#define FORMAT_BC1 0
+#define FORMAT_ETC2 1
+
+static void put32(unsigned char* p, unsigned int v) {
+  for (int k = 0; k < 4; k++) p[k] = (unsigned char)(v >> (8 * k));
+}
+
+static void put64(unsigned char* p, unsigned long long v) {
+  for (int k = 0; k < 8; k++) p[k] = (unsigned char)(v >> (8 * k));
+}
+
+typedef struct {
+  unsigned char* data;
+  size_t size;
+  int width, height;
+} Level;
+
+/* Header, level index, DFD, writer key/value, then the levels smallest first, each 8-byte aligned */
+static int ktx2_write(const char* path, int format, int srgb, const Level* levels, int count, size_t* file_size) {
+  static const unsigned char identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+  static const char writer_key[] = "KTXwriter\0Test1 texpack";
+  unsigned int vk_format = format == FORMAT_BC1 ? (srgb ? 132 : 131) : (srgb ? 148 : 147);
+  size_t level_index = 80, dfd = level_index + 24 * (size_t)count, dfd_size = 44;
+  size_t kvd = dfd + dfd_size, kvd_size = (4 + sizeof(writer_key) + 3) & ~(size_t)3;
+  size_t offset = (kvd + kvd_size + 7) & ~(size_t)7;
+  unsigned char head[80 + 24 * 16 + 44 + 32];
+  memset(head, 0, sizeof(head));
+  memcpy(head, identifier, 12);
+  put32(head + 12, vk_format);
+  put32(head + 16, 1); /* typeSize */
+  put32(head + 20, (unsigned int)levels[0].width);
+  put32(head + 24, (unsigned int)levels[0].height);
+  put32(head + 36, 1); /* faceCount */
+  put32(head + 40, (unsigned int)count);
+  put32(head + 48, (unsigned int)dfd);
+  put32(head + 52, (unsigned int)dfd_size);
+  put32(head + 56, (unsigned int)kvd);
+  put32(head + 60, (unsigned int)kvd_size);
+  size_t level_offset[16];
+  for (int i = count - 1; i >= 0; i--) {
+    level_offset[i] = offset;
+    offset = (offset + levels[i].size + 7) & ~(size_t)7;
+  }
+  for (int i = 0; i < count; i++) {
+    put64(head + level_index + 24 * i, level_offset[i]);
+    put64(head + level_index + 24 * i + 8, levels[i].size);
+    put64(head + level_index + 24 * i + 16, levels[i].size); /* uncompressedByteLength */
+  }
+  /* Basic data format descriptor: one 64-bit sample covering the 4x4 block */
+  unsigned char* d = head + dfd;
+  put32(d, 44);
+  put32(d + 4, 0);                          /* vendorId 0, descriptorType 0 */
+  put32(d + 8, 2 | (40 << 16));             /* versionNumber 2, descriptorBlockSize 40 */
+  d[12] = format == FORMAT_BC1 ? 128 : 161; /* KHR_DF_MODEL_BC1A / ETC2 */
+  d[13] = 1;                                /* BT.709 primaries */
+  d[14] = srgb ? 2 : 1;                     /* sRGB / linear transfer */
+  d[15] = 0;                                /* straight alpha */
+  d[16] = 3;
+  d[17] = 3;                                /* texelBlockDimension 4x4 (stored minus one) */
+  d[20] = 8;                                /* bytesPlane0 */
+  d[28] = 0;
+  d[29] = 0;                                /* bitOffset 0 */
+  d[30] = 63;                               /* bitLength 64 (minus one) */
+  d[31] = format == FORMAT_BC1 ? 0 : 2;     /* KHR_DF_CHANNEL_BC1A_COLOR / ETC2_COLOR */
+  put32(d + 40, 0xffffffffu);               /* sampleUpper */
+  put32(head + kvd, (unsigned int)sizeof(writer_key));
+  memcpy(head + kvd + 4, writer_key, sizeof(writer_key));
+
+  FILE* f = fopen(path, "wb");
+  if (!f) return 0;
+  size_t head_size = kvd + kvd_size, pos = head_size;
+  int ok = fwrite(head, 1, head_size, f) == head_size;
+  static const unsigned char zeros[8] = {0};
+  for (int i = count - 1; i >= 0 && ok; i--) {
+    ok = fwrite(zeros, 1, level_offset[i] - pos, f) == level_offset[i] - pos &&
+         fwrite(levels[i].data, 1, levels[i].size, f) == levels[i].size;
+    pos = level_offset[i] + levels[i].size;
+  }
+  ok = fclose(f) == 0 && ok;
+  *file_size = pos;
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  const char *in_path = 0, *out_path = 0;
+  int format = FORMAT_BC1, max_size = 0, srgb = 1, bad = 0;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--format") && i + 1 < argc) {
+      i++;
+      if (!strcmp(argv[i], "bc1")) format = FORMAT_BC1;
+      else if (!strcmp(argv[i], "etc2")) format = FORMAT_ETC2;
+      else bad = 1;
+    } else if (!strcmp(argv[i], "--max-size") && i + 1 < argc) {
+      max_size = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--linear")) {
+      srgb = 0;
+    } else if (!in_path) {
+      in_path = argv[i];
+    } else if (!out_path) {
+      out_path = argv[i];
+    } else {
+      bad = 1;
+    }
+  }
+  if (bad || !in_path || !out_path) {
+    fprintf(stderr, "usage: %s [--format bc1|etc2] [--max-size N] [--linear] IN.png OUT.ktx2\n", argv[0]);
+    return 2;
+  }
+  for (int i = 0; i < 256; i++) {
+    float v = i / 255.f;
+    srgb_to_linear_table[i] = srgb ? (v <= 0.04045f ? v / 12.92f : powf((v + 0.055f) / 1.055f, 2.4f)) : v;
+  }
+
+  int w, h;
+  unsigned char* rgb = png_load(in_path, &w, &h);
+  if (!rgb) return 1;
+  int src_w = w, src_h = h;
+  float* img = malloc((size_t)w * h * 3 * sizeof(float));
+  if (!img) return 1;
+  for (size_t i = 0; i < (size_t)w * h * 3; i++) img[i] = srgb_to_linear_table[rgb[i]];
+
+  while (max_size > 0 && (w > max_size || h > max_size)) {
+    float* next = downsample(img, w, h, &w, &h);
+    if (!next) return 1;
+    free(img);
+    img = next;
+  }
+
+  Level levels[16];
+  int count = 0;
+  double top_err = 0.0; /* squared error of the decoded top level */
+  size_t payload = 0;
+  for (;;) {
+    int bw = (w + 3) / 4, bh = (h + 3) / 4;
+    unsigned char* bytes = malloc((size_t)w * h * 3);
+    levels[count].size = (size_t)bw * bh * 8;
+    levels[count].data = malloc(levels[count].size);
+    levels[count].width = w;
+    levels[count].height = h;
+    if (!bytes || !levels[count].data) return 1;
+    for (size_t i = 0; i < (size_t)w * h * 3; i++) bytes[i] = to_byte(img[i], srgb);
+    for (int by = 0; by < bh; by++) {
+      for (int bx = 0; bx < bw; bx++) {
+        unsigned char block[16][3], decoded[16][3];
+        unsigned char* out = levels[count].data + ((size_t)by * bw + bx) * 8;
+        fetch_block(bytes, w, h, bx, by, block);
+        if (format == FORMAT_BC1) {
+          bc1_encode(block, out);
+          bc1_decode(out, decoded);
+        } else {
+          etc_encode(block, out);
+          etc_decode(out, decoded);
+        }
+        for (int i = 0; count == 0 && i < 16; i++) {
+          int x = bx * 4 + (i & 3), y = by * 4 + (i >> 2);
+          int ref[3] = {decoded[i][0], decoded[i][1], decoded[i][2]};
+          if (x < w && y < h) top_err += color_error(block[i], ref);
+        }
+      }
+    }
+    payload += levels[count].size;
+    free(bytes);
+    count++;
+    if (w == 1 && h == 1) break;
+    float* next = downsample(img, w, h, &w, &h);
+    if (!next) return 1;
+    free(img);
+    img = next;
+  }
+
+  size_t file_size = 0;
+  if (!ktx2_write(out_path, format, srgb, levels, count, &file_size)) {
+    fprintf(stderr, "cannot write %s\n", out_path);
+    return 1;
+  }
+  size_t in_size;
+  free(read_file(in_path, &in_size));
+  printf("{\"tool\":\"texpack\",\"input\":\"%s\",\"output\":\"%s\",\"format\":\"%s\",\"srgb\":%d,"
+         "\"source\":[%d,%d],\"size\":[%d,%d],\"levels\":%d,\"png_bytes\":%zu,\"ktx2_bytes\":%zu,"
+         "\"rgba8_mip_bytes\":%zu,\"rms\":%.2f}\n",
+         in_path, out_path, format == FORMAT_BC1 ? "bc1" : "etc2", srgb, src_w, src_h, levels[0].width,
+         levels[0].height, count, in_size, file_size, payload * 8,
+         sqrt(top_err / (3.0 * levels[0].width * levels[0].height)));
+  for (int i = 0; i < count; i++) free(levels[i].data);
+  free(img);
+  free(rgb);
+  return 0;
+}